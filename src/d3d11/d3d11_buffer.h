@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../dxvk/dxvk_cs.h"
 #include "../dxvk/dxvk_device.h"
 
 #include "../d3d10/d3d10_buffer.h"
@@ -115,10 +116,46 @@ namespace dxvk {
       return m_mapped;
     }
 
+    void SetMappedSlice(const DxvkBufferSliceHandle& Slice) {
+      m_mapped = Slice;
+    }
+
     D3D10Buffer* GetD3D10Iface() {
       return &m_d3d10;
     }
 
+    /**
+     * \brief Tracks sequence number
+     *
+     * Stores the sequence number of the CS chunk that
+     * last accessed the resource. Sequence numbers only
+     * ever increase, so once a deferred context marks
+     * the resource with \c SynchronizeAll, it will have
+     * to fully synchronize with the CS thread.
+     * \param [in] Seq Sequence number
+     */
+    void TrackSequenceNumber(uint64_t Seq) {
+      uint64_t current = m_seq.load(std::memory_order_relaxed);
+
+      while (current < Seq && !m_seq.compare_exchange_weak(current, Seq, std::memory_order_relaxed))
+        continue;
+    }
+
+    /**
+     * \brief Queries sequence number to wait for
+     *
+     * Only staging resources are tracked since they
+     * cannot be bound to the pipeline, and are thus
+     * only accessed by copy and update commands.
+     * \returns Sequence number of the last chunk that
+     *    accessed the resource, or \c SynchronizeAll
+     */
+    uint64_t GetSequenceNumber() const {
+      return m_desc.Usage == D3D11_USAGE_STAGING
+        ? m_seq.load(std::memory_order_relaxed)
+        : DxvkCsThread::SynchronizeAll;
+    }
+
     /**
      * \brief Normalizes buffer description
      * 
@@ -136,6 +173,8 @@ namespace dxvk {
     Rc<DxvkBuffer>              m_soCounter;
     DxvkBufferSliceHandle       m_mapped;
 
+    std::atomic<uint64_t>       m_seq = { 0ull };
+
     D3D11DXGIResource           m_resource;
     D3D10Buffer                 m_d3d10;
 
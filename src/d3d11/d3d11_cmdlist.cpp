@@ -11,7 +11,11 @@ namespace dxvk {
   
   
   D3D11CommandList::~D3D11CommandList() {
-    
+    if (m_recordedCommands != nullptr)
+      DiscardRecordedCommands(m_recordedCommands);
+
+    if (m_recordContext != nullptr)
+      m_recorder->ReleaseContext(std::move(m_recordContext));
   }
   
   
@@ -45,15 +49,28 @@ namespace dxvk {
   
   
   void D3D11CommandList::AddQuery(D3D11Query* pQuery) {
+    // Queries are tied to the immediate context's command list
     m_queries.emplace_back(pQuery);
+    m_parallel = false;
   }
 
 
   void D3D11CommandList::EmitToCommandList(ID3D11CommandList* pCommandList) {
     auto cmdList = static_cast<D3D11CommandList*>(pCommandList);
     
-    for (const auto& chunk : m_chunks)
-      cmdList->m_chunks.push_back(chunk);
+    if (m_recorder != nullptr) {
+      // Secondary command lists can only be executed
+      // by primary ones, so the target command list
+      // must be executed on the immediate context.
+      cmdList->m_chunks.push_back(CreateExecuteChunk());
+      cmdList->m_parallel = false;
+    } else {
+      for (const auto& chunk : m_chunks)
+        cmdList->m_chunks.push_back(chunk);
+
+      if (!m_parallel)
+        cmdList->m_parallel = false;
+    }
 
     for (const auto& query : m_queries)
       cmdList->m_queries.push_back(query);
@@ -66,13 +83,39 @@ namespace dxvk {
     for (const auto& query : m_queries)
       query->DoDeferredEnd();
 
-    for (const auto& chunk : m_chunks)
-      CsThread->dispatchChunk(DxvkCsChunkRef(chunk));
+    if (m_recorder != nullptr) {
+      CsThread->dispatchChunk(CreateExecuteChunk());
+    } else {
+      for (const auto& chunk : m_chunks)
+        CsThread->dispatchChunk(DxvkCsChunkRef(chunk));
+    }
     
     MarkSubmitted();
   }
   
   
+  void D3D11CommandList::DisableParallelRecording() {
+    m_parallel = false;
+  }
+
+
+  void D3D11CommandList::AttachRecorder(
+          D3D11CommandListRecorder* pRecorder) {
+    if (!m_parallel || m_chunks.empty())
+      return;
+
+    m_recorder = pRecorder;
+
+    if (m_recorder->RecordsInParallel()) {
+      m_recorder->Dispatch([cCommandList = Com<D3D11CommandList, false>(this)] {
+        cCommandList->RecordCommands();
+      });
+    } else {
+      m_recordDone = true;
+    }
+  }
+  
+  
   void D3D11CommandList::MarkSubmitted() {
     if (m_submitted.exchange(true) && !m_warned.exchange(true)
      && m_parent->GetOptions()->dcSingleUseMode) {
@@ -81,5 +124,176 @@ namespace dxvk {
         "       but d3d11.dcSingleUseMode is enabled");
     }
   }
+
+
+  void D3D11CommandList::RecordCommands() {
+    // The immediate context may rename buffers used by this
+    // command list before executing it, in which case the
+    // recorded commands would access outdated buffer slices
+    Rc<DxvkCommandList> secondary = m_parent->GetDXVKDevice()->createSecondaryCommandList();
+    secondary->trackResourceVersions();
+
+    Rc<DxvkContext> context = m_recorder->AcquireContext();
+    context->beginRecording(secondary);
+
+    for (const auto& chunk : m_chunks)
+      chunk->executeAll(context.ptr());
+
+    Rc<DxvkCommandList> cmdList = context->endRecording();
+
+    if (cmdList->isOutdated())
+      DiscardRecordedCommands(cmdList);
+
+    std::lock_guard<dxvk::mutex> lock(m_recordMutex);
+    m_recordContext    = std::move(context);
+    m_recordedCommands = std::move(cmdList);
+    m_recordDone       = true;
+    m_recordCond.notify_one();
+  }
+
+
+  void D3D11CommandList::ExecuteCommands(
+          DxvkContext*        ctx) {
+    Rc<DxvkContext>     context;
+    Rc<DxvkCommandList> cmdList;
+
+    { std::unique_lock<dxvk::mutex> lock(m_recordMutex);
+      m_recordCond.wait(lock, [this] { return m_recordDone; });
+
+      context = std::move(m_recordContext);
+      cmdList = std::move(m_recordedCommands);
+    }
+
+    m_executeCount += 1;
+
+    // Fall back to replaying the chunks if the immediate
+    // context renamed any buffer that the commands use
+    if (cmdList != nullptr && cmdList->isOutdated())
+      DiscardRecordedCommands(cmdList);
+
+    // The secondary command list can only be executed once. If the
+    // command list gets executed again, replay the chunks instead.
+    if (cmdList != nullptr) {
+      ctx->executeCommandList(cmdList);
+      m_recorder->ReleaseContext(std::move(context));
+      return;
+    }
+
+    if (context != nullptr)
+      m_recorder->ReleaseContext(std::move(context));
+
+    // Baked command lists are only invalidated by resource renames.
+    // Command lists that use a renamed buffer will likely do so on
+    // every execution, so do not bother baking them again.
+    if (m_bakedCommands != nullptr) {
+      if (likely(!m_bakedCommands->isOutdated())) {
+        ctx->executeCommandList(m_bakedCommands);
+        return;
+      }
+
+      m_bakedCommands = nullptr;
+      m_bakeFailed = true;
+    }
+
+    if (m_recorder->BakesCommandLists() && m_executeCount > 1 && !m_bakeFailed) {
+      BakeCommands(ctx);
+    } else {
+      for (const auto& chunk : m_chunks)
+        chunk->executeAll(ctx);
+    }
+  }
+
+
+  void D3D11CommandList::BakeCommands(
+          DxvkContext*        ctx) {
+    // Record on the calling thread, which is the CS thread, so
+    // that no buffer can get renamed while we are recording
+    Rc<DxvkContext> context = m_recorder->AcquireContext();
+    context->beginRecording(m_parent->GetDXVKDevice()->createReusableCommandList());
+
+    for (const auto& chunk : m_chunks)
+      chunk->executeAll(context.ptr());
+
+    Rc<DxvkCommandList> cmdList = context->endRecording();
+
+    // Command lists that use staging memory cannot be reused,
+    // but can still be executed once in place of the chunks.
+    // If pipelines were not ready or not optimized yet, try
+    // again on the next execution.
+    if (cmdList->makeReusable())
+      m_bakedCommands = cmdList;
+    else if (!cmdList->isIncomplete())
+      m_bakeFailed = true;
+
+    ctx->executeCommandList(cmdList);
+    m_recorder->ReleaseContext(std::move(context));
+  }
+
+
+  void D3D11CommandList::DiscardRecordedCommands(
+          Rc<DxvkCommandList>& cmdList) {
+    // The command list was never executed, so any staging
+    // memory that it used can be reused right away
+    cmdList->notifySignals();
+    cmdList = nullptr;
+  }
+
+
+  DxvkCsChunkRef D3D11CommandList::CreateExecuteChunk() {
+    DxvkCsChunkRef chunk = m_parent->AllocCsChunk(DxvkCsChunkFlags());
+
+    auto command = [cCommandList = Com<D3D11CommandList, false>(this)]
+    (DxvkContext* ctx) {
+      cCommandList->ExecuteCommands(ctx);
+    };
+
+    chunk->push(command, DxvkCsStateKey(), DXVK_CS_TAG());
+    return chunk;
+  }
+
+
+  D3D11CommandListRecorder::D3D11CommandListRecorder(
+          D3D11Device*              pDevice)
+  : m_device            (pDevice->GetDXVKDevice()),
+    m_relaxedBarriers   (pDevice->GetOptions()->relaxedBarriers),
+    m_parallelRecording (pDevice->GetOptions()->dcParallelRecording),
+    m_bakeCommandLists  (pDevice->GetOptions()->dcBakeCommandLists) {
+    // Single-use command lists lose their commands on execution
+    if (m_bakeCommandLists && pDevice->GetOptions()->dcSingleUseMode) {
+      Logger::warn("D3D11: d3d11.dcBakeCommandLists requires d3d11.dcSingleUseMode to be disabled");
+      m_bakeCommandLists = false;
+    }
+  }
+
+
+  D3D11CommandListRecorder::~D3D11CommandListRecorder() {
+
+  }
+
+
+  Rc<DxvkContext> D3D11CommandListRecorder::AcquireContext() {
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      if (!m_contexts.empty()) {
+        Rc<DxvkContext> context = std::move(m_contexts.back());
+        m_contexts.pop_back();
+        return context;
+      }
+    }
+
+    Rc<DxvkContext> context = m_device->createContext();
+
+    if (m_relaxedBarriers)
+      context->setBarrierControl(DxvkBarrierControl::IgnoreWriteAfterWrite);
+
+    return context;
+  }
+
+
+  void D3D11CommandListRecorder::ReleaseContext(
+          Rc<DxvkContext>&&         Context) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    m_contexts.push_back(std::move(Context));
+  }
   
 }
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "../dxvk/dxvk_thread_pool.h"
+
 #include "d3d11_context.h"
 
 namespace dxvk {
   
+  class D3D11CommandListRecorder;
+
   class D3D11CommandList : public D3D11DeviceChild<ID3D11CommandList> {
     
   public:
@@ -32,6 +36,30 @@ namespace dxvk {
     void EmitToCsThread(
             DxvkCsThread*       CsThread);
     
+    /**
+     * \brief Prevents recording on a worker thread
+     *
+     * Must be called when the command list contains commands
+     * that change the backing storage of a resource, since
+     * doing so ahead of execution would race with other
+     * contexts using the same resource.
+     */
+    void DisableParallelRecording();
+
+    /**
+     * \brief Attaches command list recorder
+     *
+     * If enabled, executes all chunks on a worker context
+     * right away, which records them into a secondary command
+     * list that gets executed by the immediate context in place
+     * of the chunks. Command lists that get executed more than
+     * once may also be baked into a reusable command list. Does
+     * nothing if the command list is not eligible.
+     * \param [in] pRecorder Command list recorder
+     */
+    void AttachRecorder(
+            D3D11CommandListRecorder* pRecorder);
+
   private:
     
     UINT         const m_contextFlags;
@@ -42,8 +70,113 @@ namespace dxvk {
     std::atomic<bool> m_submitted = { false };
     std::atomic<bool> m_warned    = { false };
 
+    bool                      m_parallel = true;
+    D3D11CommandListRecorder* m_recorder = nullptr;
+
+    dxvk::mutex               m_recordMutex;
+    dxvk::condition_variable  m_recordCond;
+    bool                      m_recordDone = false;
+    Rc<DxvkContext>           m_recordContext;
+    Rc<DxvkCommandList>       m_recordedCommands;
+
+    uint32_t                  m_executeCount = 0;
+    bool                      m_bakeFailed   = false;
+    Rc<DxvkCommandList>       m_bakedCommands;
+
     void MarkSubmitted();
+
+    void RecordCommands();
+
+    void BakeCommands(
+            DxvkContext*        ctx);
+
+    void ExecuteCommands(
+            DxvkContext*        ctx);
+
+    void DiscardRecordedCommands(
+            Rc<DxvkCommandList>& cmdList);
+
+    DxvkCsChunkRef CreateExecuteChunk();
     
   };
-  
+
+
+  /**
+   * \brief Deferred command list recorder
+   *
+   * Manages the worker threads and contexts that record
+   * deferred context command lists into secondary command
+   * lists, so that Vulkan command recording for multiple
+   * command lists can run in parallel to the CS thread,
+   * or only needs to happen once for command lists that
+   * get executed repeatedly.
+   */
+  class D3D11CommandListRecorder {
+
+  public:
+
+    D3D11CommandListRecorder(
+            D3D11Device*              pDevice);
+
+    ~D3D11CommandListRecorder();
+
+    /**
+     * \brief Checks whether to record in parallel
+     * \returns \c true if command lists should be
+     *    recorded on worker threads once finished
+     */
+    bool RecordsInParallel() const {
+      return m_parallelRecording;
+    }
+
+    /**
+     * \brief Checks whether to bake command lists
+     * \returns \c true if command lists that get
+     *    executed repeatedly should be baked
+     */
+    bool BakesCommandLists() const {
+      return m_bakeCommandLists;
+    }
+
+    /**
+     * \brief Retrieves a worker context
+     *
+     * Returns an idle context, or creates a new one. The
+     * context must be released once the command list that
+     * it recorded has been executed or discarded, so that
+     * staging memory of the context retires in order.
+     * \returns Context
+     */
+    Rc<DxvkContext> AcquireContext();
+
+    /**
+     * \brief Returns a worker context to the pool
+     * \param [in] Context The context
+     */
+    void ReleaseContext(
+            Rc<DxvkContext>&&         Context);
+
+    /**
+     * \brief Runs a job on a worker thread
+     * \param [in] Job The job
+     */
+    template<typename Fn>
+    void Dispatch(Fn&& Job) {
+      m_workers.enqueue(std::forward<Fn>(Job));
+    }
+
+  private:
+
+    Rc<DxvkDevice>                m_device;
+    bool                          m_relaxedBarriers;
+    bool                          m_parallelRecording;
+    bool                          m_bakeCommandLists;
+
+    dxvk::mutex                   m_mutex;
+    std::vector<Rc<DxvkContext>>  m_contexts;
+
+    DxvkThreadPool                m_workers;
+
+  };
+
 }
@@ -20,9 +20,11 @@ namespace dxvk {
     m_multithread(this, false),
     m_device    (Device),
     m_csFlags   (CsFlags),
-    m_csChunk   (AllocCsChunk()),
     m_cmdData   (nullptr) {
+    if (pParent->GetOptions()->elideRedundantState)
+      m_csFlags.set(DxvkCsChunkFlag::ElideState);
 
+    m_csChunk = AllocCsChunk();
   }
   
   
@@ -472,6 +474,8 @@ namespace dxvk {
         cSrcSlice.offset(),
         sizeof(uint32_t));
     });
+
+    TrackBufferSequenceNumber(buf);
   }
 
 
@@ -980,6 +984,8 @@ namespace dxvk {
             cBufferSlice.length(),
             cDataBuffer.ptr());
         });
+
+        TrackBufferSequenceNumber(bufferResource);
       }
     } else {
       D3D11CommonTexture* dstTexture = GetCommonTexture(pDstResource);
@@ -1301,7 +1307,7 @@ namespace dxvk {
       cmdData->count += 1;
       cmdData->stride = stride;
     } else {
-      cmdData = EmitCsCmd<D3D11CmdDrawIndirectData>(
+      cmdData = EmitCsCmd<D3D11CmdDrawIndirectData>(DXVK_CS_TAG(),
         [] (DxvkContext* ctx, const D3D11CmdDrawIndirectData* data) {
           ctx->drawIndexedIndirect(data->offset, data->count, data->stride);
         });
@@ -1332,7 +1338,7 @@ namespace dxvk {
       cmdData->count += 1;
       cmdData->stride = stride;
     } else {
-      cmdData = EmitCsCmd<D3D11CmdDrawIndirectData>(
+      cmdData = EmitCsCmd<D3D11CmdDrawIndirectData>(DXVK_CS_TAG(),
         [] (DxvkContext* ctx, const D3D11CmdDrawIndirectData* data) {
           ctx->drawIndirect(data->offset, data->count, data->stride);
         });
@@ -2944,13 +2950,13 @@ namespace dxvk {
     auto inputLayout = m_state.ia.inputLayout.prvRef();
 
     if (likely(inputLayout != nullptr)) {
-      EmitCs([
+      EmitCs(DxvkCsStateClass::InputLayout, [
         cInputLayout = std::move(inputLayout)
       ] (DxvkContext* ctx) {
         cInputLayout->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCs(DxvkCsStateClass::InputLayout, [] (DxvkContext* ctx) {
         ctx->setInputLayout(0, nullptr, 0, nullptr);
       });
     }
@@ -2984,7 +2990,7 @@ namespace dxvk {
       iaState = { VK_PRIMITIVE_TOPOLOGY_PATCH_LIST, VK_FALSE, vertexCount };
     }
     
-    EmitCs([iaState] (DxvkContext* ctx) {
+    EmitCs(DxvkCsStateClass::InputAssembly, [iaState] (DxvkContext* ctx) {
       ctx->setInputAssemblyState(iaState);
     });
   }
@@ -2992,14 +2998,14 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyBlendState() {
     if (m_state.om.cbState != nullptr) {
-      EmitCs([
+      EmitCs(DxvkCsStateClass::BlendState, [
         cBlendState = m_state.om.cbState,
         cSampleMask = m_state.om.sampleMask
       ] (DxvkContext* ctx) {
         cBlendState->BindToContext(ctx, cSampleMask);
       });
     } else {
-      EmitCs([
+      EmitCs(DxvkCsStateClass::BlendState, [
         cSampleMask = m_state.om.sampleMask
       ] (DxvkContext* ctx) {
         DxvkBlendMode cbState;
@@ -3018,7 +3024,7 @@ namespace dxvk {
   
   
   void D3D11DeviceContext::ApplyBlendFactor() {
-    EmitCs([
+    EmitCs(DxvkCsStateClass::BlendConstants, [
       cBlendConstants = DxvkBlendConstants {
         m_state.om.blendFactor[0], m_state.om.blendFactor[1],
         m_state.om.blendFactor[2], m_state.om.blendFactor[3] }
@@ -3030,13 +3036,13 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyDepthStencilState() {
     if (m_state.om.dsState != nullptr) {
-      EmitCs([
+      EmitCs(DxvkCsStateClass::DepthStencilState, [
         cDepthStencilState = m_state.om.dsState
       ] (DxvkContext* ctx) {
         cDepthStencilState->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCs(DxvkCsStateClass::DepthStencilState, [] (DxvkContext* ctx) {
         DxvkDepthStencilState dsState;
         InitDefaultDepthStencilState(&dsState);
 
@@ -3047,7 +3053,7 @@ namespace dxvk {
   
   
   void D3D11DeviceContext::ApplyStencilRef() {
-    EmitCs([
+    EmitCs(DxvkCsStateClass::StencilReference, [
       cStencilRef = m_state.om.stencilRef
     ] (DxvkContext* ctx) {
       ctx->setStencilReference(cStencilRef);
@@ -3057,13 +3063,13 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyRasterizerState() {
     if (m_state.rs.state != nullptr) {
-      EmitCs([
+      EmitCs(DxvkCsStateClass::RasterizerState, [
         cRasterizerState = m_state.rs.state
       ] (DxvkContext* ctx) {
         cRasterizerState->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCs(DxvkCsStateClass::RasterizerState, [] (DxvkContext* ctx) {
         DxvkRasterizerState rsState;
         InitDefaultRasterizerState(&rsState);
 
@@ -3142,7 +3148,7 @@ namespace dxvk {
     }
     
     if (likely(viewportCount == 1)) {
-      EmitCs([
+      EmitCs(DxvkCsStateClass::Viewports, [
         cViewport = viewports[0],
         cScissor  = scissors[0]
       ] (DxvkContext* ctx) {
@@ -3151,7 +3157,7 @@ namespace dxvk {
           &cScissor);
       });
     } else {
-      EmitCs([
+      EmitCs(DxvkCsStateClass::Viewports, [
         cViewportCount = viewportCount,
         cViewports     = viewports,
         cScissors      = scissors
@@ -3169,7 +3175,7 @@ namespace dxvk {
   void D3D11DeviceContext::BindShader(
     const D3D11CommonShader*    pShaderModule) {
     // Bind the shader and the ICB at once
-    EmitCs([
+    EmitCs(DxvkCsStateKey(DxvkCsStateClass::Shader, uint32_t(ShaderStage)), [
       cSlice  = pShaderModule           != nullptr
              && pShaderModule->GetIcb() != nullptr
         ? DxvkBufferSlice(pShaderModule->GetIcb())
@@ -3235,7 +3241,7 @@ namespace dxvk {
           D3D11Buffer*                      pBuffer,
           UINT                              Offset,
           UINT                              Stride) {
-    EmitCs([
+    EmitCs(DxvkCsStateKey(DxvkCsStateClass::VertexBuffer, Slot), [
       cSlotId       = Slot,
       cBufferSlice  = pBuffer != nullptr ? pBuffer->GetBufferSlice(Offset) : DxvkBufferSlice(),
       cStride       = Stride
@@ -3253,7 +3259,7 @@ namespace dxvk {
       ? VK_INDEX_TYPE_UINT16
       : VK_INDEX_TYPE_UINT32;
     
-    EmitCs([
+    EmitCs(DxvkCsStateClass::IndexBuffer, [
       cBufferSlice  = pBuffer != nullptr ? pBuffer->GetBufferSlice(Offset) : DxvkBufferSlice(),
       cIndexType    = indexType
     ] (DxvkContext* ctx) {
@@ -3298,7 +3304,7 @@ namespace dxvk {
           D3D11Buffer*                      pBuffer,
           UINT                              Offset,
           UINT                              Length) {
-    EmitCs([
+    EmitCs(DxvkCsStateKey(DxvkCsStateClass::ResourceBuffer, Slot), [
       cSlotId      = Slot,
       cBufferSlice = Length ? pBuffer->GetBufferSlice(16 * Offset, 16 * Length) : DxvkBufferSlice()
     ] (DxvkContext* ctx) {
@@ -3310,7 +3316,7 @@ namespace dxvk {
   void D3D11DeviceContext::BindSampler(
           UINT                              Slot,
           D3D11SamplerState*                pSampler) {
-    EmitCs([
+    EmitCs(DxvkCsStateKey(DxvkCsStateClass::ResourceSampler, Slot), [
       cSlotId   = Slot,
       cSampler  = pSampler != nullptr ? pSampler->GetDXVKSampler() : nullptr
     ] (DxvkContext* ctx) {
@@ -3322,7 +3328,7 @@ namespace dxvk {
   void D3D11DeviceContext::BindShaderResource(
           UINT                              Slot,
           D3D11ShaderResourceView*          pResource) {
-    EmitCs([
+    EmitCs(DxvkCsStateKey(DxvkCsStateClass::ResourceView, Slot), [
       cSlotId     = Slot,
       cImageView  = pResource != nullptr ? pResource->GetImageView()  : nullptr,
       cBufferView = pResource != nullptr ? pResource->GetBufferView() : nullptr
@@ -3394,6 +3400,9 @@ namespace dxvk {
           cSrcBuffer.length());
       }
     });
+
+    TrackBufferSequenceNumber(pDstBuffer);
+    TrackBufferSequenceNumber(pSrcBuffer);
   }
 
 
@@ -3628,6 +3637,9 @@ namespace dxvk {
         }
       }
     }
+
+    TrackTextureSequenceNumber(pDstTexture);
+    TrackTextureSequenceNumber(pSrcTexture);
   }
 
 
@@ -3747,6 +3759,8 @@ namespace dxvk {
         srcPlaneOffset += util::flattenImageExtent(blockCount) * elementSize;
       }
     }
+
+    TrackTextureSequenceNumber(pDstTexture);
   }
 
 
@@ -4386,19 +4400,21 @@ namespace dxvk {
 
 
   DxvkDataSlice D3D11DeviceContext::AllocUpdateBufferSlice(size_t Size) {
+    // Must not exceed the largest size class of the
+    // data buffer pool, or buffers won't get reused
     constexpr size_t UpdateBufferSize = 16 * 1024 * 1024;
     
     if (Size >= UpdateBufferSize) {
-      Rc<DxvkDataBuffer> buffer = new DxvkDataBuffer(Size);
+      Rc<DxvkDataBuffer> buffer = m_device->createDataBuffer(Size);
       return buffer->alloc(Size);
     } else {
       if (m_updateBuffer == nullptr)
-        m_updateBuffer = new DxvkDataBuffer(UpdateBufferSize);
+        m_updateBuffer = m_device->createDataBuffer(UpdateBufferSize);
       
       DxvkDataSlice slice = m_updateBuffer->alloc(Size);
       
       if (slice.ptr() == nullptr) {
-        m_updateBuffer = new DxvkDataBuffer(UpdateBufferSize);
+        m_updateBuffer = m_device->createDataBuffer(UpdateBufferSize);
         slice = m_updateBuffer->alloc(Size);
       }
       
@@ -4428,6 +4444,20 @@ namespace dxvk {
   DxvkCsChunkRef D3D11DeviceContext::AllocCsChunk() {
     return m_parent->AllocCsChunk(m_csFlags);
   }
+
+
+  void D3D11DeviceContext::TrackBufferSequenceNumber(
+          D3D11Buffer*                      pResource) {
+    if (pResource->Desc()->Usage == D3D11_USAGE_STAGING)
+      pResource->TrackSequenceNumber(GetCurrentSequenceNumber());
+  }
+
+
+  void D3D11DeviceContext::TrackTextureSequenceNumber(
+          D3D11CommonTexture*               pResource) {
+    if (pResource->Desc()->Usage == D3D11_USAGE_STAGING)
+      pResource->TrackSequenceNumber(GetCurrentSequenceNumber());
+  }
   
 
   void D3D11DeviceContext::InitDefaultPrimitiveTopology(
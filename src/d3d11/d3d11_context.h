@@ -929,6 +929,12 @@ namespace dxvk {
             VkDeviceSize                      Size);
     
     DxvkCsChunkRef AllocCsChunk();
+
+    void TrackBufferSequenceNumber(
+            D3D11Buffer*                      pResource);
+
+    void TrackTextureSequenceNumber(
+            D3D11CommonTexture*               pResource);
     
     static void InitDefaultPrimitiveTopology(
             DxvkInputAssemblyState*           pIaState);
@@ -959,28 +965,40 @@ namespace dxvk {
     }
     
     template<typename Cmd>
-    void EmitCs(Cmd&& command) {
+    void EmitCs(Cmd&& command, DxvkCsTag tag = DXVK_CS_TAG()) {
+      m_cmdData = nullptr;
+
+      if (unlikely(!m_csChunk->push(command, DxvkCsStateKey(), tag))) {
+        EmitCsChunk(std::move(m_csChunk));
+        
+        m_csChunk = AllocCsChunk();
+        m_csChunk->push(command, DxvkCsStateKey(), tag);
+      }
+    }
+
+    template<typename Cmd>
+    void EmitCs(DxvkCsStateKey key, Cmd&& command, DxvkCsTag tag = DXVK_CS_TAG()) {
       m_cmdData = nullptr;
 
-      if (unlikely(!m_csChunk->push(command))) {
+      if (unlikely(!m_csChunk->push(command, key, tag))) {
         EmitCsChunk(std::move(m_csChunk));
         
         m_csChunk = AllocCsChunk();
-        m_csChunk->push(command);
+        m_csChunk->push(command, key, tag);
       }
     }
 
     template<typename M, typename Cmd, typename... Args>
-    M* EmitCsCmd(Cmd&& command, Args&&... args) {
+    M* EmitCsCmd(DxvkCsTag tag, Cmd&& command, Args&&... args) {
       M* data = m_csChunk->pushCmd<M, Cmd, Args...>(
-        command, std::forward<Args>(args)...);
+        command, tag, std::forward<Args>(args)...);
 
       if (unlikely(!data)) {
         EmitCsChunk(std::move(m_csChunk));
         
         m_csChunk = AllocCsChunk();
         data = m_csChunk->pushCmd<M, Cmd, Args...>(
-          command, std::forward<Args>(args)...);
+          command, tag, std::forward<Args>(args)...);
       }
 
       m_cmdData = data;
@@ -996,6 +1014,8 @@ namespace dxvk {
     }
     
     virtual void EmitCsChunk(DxvkCsChunkRef&& chunk) = 0;
+
+    virtual uint64_t GetCurrentSequenceNumber() = 0;
     
   };
   
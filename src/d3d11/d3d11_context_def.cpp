@@ -165,6 +165,9 @@ namespace dxvk {
     FinalizeQueries();
     FlushCsChunk();
     
+    if (auto recorder = m_parent->GetCommandListRecorder())
+      m_commandList->AttachRecorder(recorder);
+
     if (ppCommandList != nullptr)
       *ppCommandList = m_commandList.ref();
     m_commandList = CreateCommandList();
@@ -275,6 +278,10 @@ namespace dxvk {
     pMapEntry->RowPitch     = pBuffer->Desc()->ByteWidth;
     pMapEntry->DepthPitch   = pBuffer->Desc()->ByteWidth;
     
+    // Invalidating the buffer renames it, which must
+    // happen in order with the immediate context
+    m_commandList->DisableParallelRecording();
+
     if (likely(m_csFlags.test(DxvkCsChunkFlag::SingleUse))) {
       // For resources that cannot be written by the GPU,
       // we may write to the buffer resource directly and
@@ -373,6 +380,14 @@ namespace dxvk {
   }
 
 
+  uint64_t D3D11DeferredContext::GetCurrentSequenceNumber() {
+    // The command list may be executed at any point, so
+    // readbacks always need to fully synchronize with the
+    // CS thread once a deferred context used the resource
+    return DxvkCsThread::SynchronizeAll;
+  }
+
+
   DxvkCsChunkFlags D3D11DeferredContext::GetCsChunkFlags(
           D3D11Device*                  pDevice) {
     return pDevice->GetOptions()->dcSingleUseMode
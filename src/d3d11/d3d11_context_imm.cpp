@@ -15,6 +15,9 @@ namespace dxvk {
   : D3D11DeviceContext(pParent, Device, DxvkCsChunkFlag::SingleUse),
     m_csThread(Device->createContext()),
     m_videoContext(this, Device) {
+    if (pParent->GetOptions()->dynamicBufferRing)
+      m_uploadRing = std::make_unique<D3D11UploadRing>(pParent);
+
     EmitCs([
       cDevice          = m_device,
       cRelaxedBarriers = pParent->GetOptions()->relaxedBarriers
@@ -31,7 +34,7 @@ namespace dxvk {
   
   D3D11ImmediateContext::~D3D11ImmediateContext() {
     Flush();
-    SynchronizeCsThread();
+    SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
     SynchronizeDevice();
   }
   
@@ -156,9 +159,27 @@ namespace dxvk {
     D3D10DeviceLock lock = LockContext();
     
     if (m_csIsBusy || !m_csChunk->empty()) {
+      // End the current upload ring frame so that its
+      // memory can be reused once the GPU is done
+      Rc<sync::Signal> ringSignal;
+      uint64_t ringFrame = 0;
+
+      if (m_uploadRing != nullptr) {
+        EvictUploadRingBuffers();
+
+        ringSignal = m_uploadRing->GetSignal();
+        ringFrame  = m_uploadRing->EndFrame();
+      }
+
       // Add commands to flush the threaded
       // context, then flush the command list
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCs([
+        cSignal = std::move(ringSignal),
+        cValue  = ringFrame
+      ] (DxvkContext* ctx) {
+        if (cValue)
+          ctx->signal(cSignal, cValue);
+
         ctx->flushCommandList();
       });
       
@@ -350,23 +371,44 @@ namespace dxvk {
       // Allocate a new backing slice for the buffer and set
       // it as the 'new' mapped slice. This assumes that the
       // only way to invalidate a buffer is by mapping it.
-      auto physSlice = pResource->DiscardSlice();
+      // Small dynamic buffers may use the upload ring.
+      DxvkBufferSliceHandle physSlice = { };
+
+      bool useRing = m_uploadRing != nullptr
+        && m_uploadRing->IsSupported(pResource);
+
+      if (useRing)
+        physSlice = m_uploadRing->Alloc(pResource);
+
+      bool isExternal = physSlice.handle != VK_NULL_HANDLE;
+
+      if (isExternal) {
+        pResource->SetMappedSlice(physSlice);
+      } else {
+        if (useRing)
+          m_uploadRing->Release(pResource);
+
+        physSlice = pResource->DiscardSlice();
+      }
+
       pMappedResource->pData      = physSlice.mapPtr;
       pMappedResource->RowPitch   = pResource->Desc()->ByteWidth;
       pMappedResource->DepthPitch = pResource->Desc()->ByteWidth;
       
       EmitCs([
         cBuffer      = pResource->GetBuffer(),
-        cBufferSlice = physSlice
+        cBufferSlice = physSlice,
+        cIsExternal  = isExternal
       ] (DxvkContext* ctx) {
-        ctx->invalidateBuffer(cBuffer, cBufferSlice);
+        ctx->invalidateBuffer(cBuffer, cBufferSlice, cIsExternal);
       });
 
+      TrackBufferSequenceNumber(pResource);
       return S_OK;
     } else {
       // Wait until the resource is no longer in use
       if (MapType != D3D11_MAP_WRITE_NO_OVERWRITE) {
-        if (!WaitForResource(pResource->GetBuffer(), MapType, MapFlags))
+        if (!WaitForResource(pResource->GetBuffer(), pResource->GetSequenceNumber(), MapType, MapFlags))
           return DXGI_ERROR_WAS_STILL_DRAWING;
       }
 
@@ -383,6 +425,33 @@ namespace dxvk {
   }
   
   
+  void D3D11ImmediateContext::EvictUploadRingBuffers() {
+    for (const auto& buffer : m_uploadRing->GetIdleBuffers()) {
+      // Move the buffer back to its own storage, preserving its
+      // contents in case it gets mapped with NO_OVERWRITE or is
+      // used for more draws. The ring slice remains valid until
+      // the GPU has completed the current frame.
+      DxvkBufferSliceHandle ringSlice = buffer->GetMappedSlice();
+      DxvkBufferSliceHandle physSlice = buffer->DiscardSlice();
+
+      std::memcpy(physSlice.mapPtr, ringSlice.mapPtr, buffer->Desc()->ByteWidth);
+
+      EmitCs([
+        cBuffer    = buffer->GetBuffer(),
+        cRingSlice = ringSlice,
+        cPhysSlice = physSlice
+      ] (DxvkContext* ctx) {
+        // A command list from a deferred context may
+        // have renamed the buffer in the meantime
+        if (cBuffer->getSliceHandle().eq(cRingSlice))
+          ctx->invalidateBuffer(cBuffer, cPhysSlice);
+        else
+          cBuffer->freeSlice(cPhysSlice);
+      });
+    }
+  }
+
+
   HRESULT D3D11ImmediateContext::MapImage(
           D3D11CommonTexture*         pResource,
           UINT                        Subresource,
@@ -420,7 +489,7 @@ namespace dxvk {
 
     if (mapMode == D3D11_COMMON_TEXTURE_MAP_MODE_DIRECT) {
       // Wait for the resource to become available
-      if (!WaitForResource(mappedImage, MapType, MapFlags))
+      if (!WaitForResource(mappedImage, pResource->GetSequenceNumber(), MapType, MapFlags))
         return DXGI_ERROR_WAS_STILL_DRAWING;
       
       // Query the subresource's memory layout and hope that
@@ -439,13 +508,14 @@ namespace dxvk {
           ctx->invalidateBuffer(cImageBuffer, cBufferSlice);
         });
 
+        TrackTextureSequenceNumber(pResource);
         mapPtr = physSlice.mapPtr;
       } else {
         bool wait = MapType != D3D11_MAP_WRITE_NO_OVERWRITE
                  || mapMode == D3D11_COMMON_TEXTURE_MAP_MODE_BUFFER;
         
         // Wait for mapped buffer to become available
-        if (wait && !WaitForResource(mappedBuffer, MapType, MapFlags))
+        if (wait && !WaitForResource(mappedBuffer, pResource->GetSequenceNumber(), MapType, MapFlags))
           return DXGI_ERROR_WAS_STILL_DRAWING;
         
         mapPtr = pResource->GetMappedSlice(Subresource).mapPtr;
@@ -515,15 +585,16 @@ namespace dxvk {
   }
 
 
-  void D3D11ImmediateContext::SynchronizeCsThread() {
+  void D3D11ImmediateContext::SynchronizeCsThread(uint64_t SequenceNumber) {
     D3D10DeviceLock lock = LockContext();
 
     // Dispatch current chunk so that all commands
     // recorded prior to this function will be run
-    FlushCsChunk();
+    if (SequenceNumber > m_csThread.lastSequenceNumber())
+      FlushCsChunk();
     
     if (m_csThread.isBusy())
-      m_csThread.synchronize();
+      m_csThread.synchronize(SequenceNumber);
   }
   
   
@@ -534,6 +605,7 @@ namespace dxvk {
   
   bool D3D11ImmediateContext::WaitForResource(
     const Rc<DxvkResource>&                 Resource,
+          uint64_t                          SequenceNumber,
           D3D11_MAP                         MapType,
           UINT                              MapFlags) {
     // Determine access type to wait for based on map mode
@@ -543,9 +615,10 @@ namespace dxvk {
     
     // Wait for the any pending D3D11 command to be executed
     // on the CS thread so that we can determine whether the
-    // resource is currently in use or not.
+    // resource is currently in use or not. For staging
+    // resources, only wait for the last chunk using it.
     if (!Resource->isInUse(access))
-      SynchronizeCsThread();
+      SynchronizeCsThread(SequenceNumber);
     
     if (Resource->isInUse(access)) {
       if (MapFlags & D3D11_MAP_FLAG_DO_NOT_WAIT) {
@@ -558,7 +631,7 @@ namespace dxvk {
         // Make sure pending commands using the resource get
         // executed on the the GPU if we have to wait for it
         Flush();
-        SynchronizeCsThread();
+        SynchronizeCsThread(SequenceNumber);
         
         Resource->waitIdle(access);
       }
@@ -574,6 +647,13 @@ namespace dxvk {
   }
 
 
+  uint64_t D3D11ImmediateContext::GetCurrentSequenceNumber() {
+    // The current chunk will get the next sequence
+    // number once it is dispatched to the CS thread
+    return m_csThread.lastSequenceNumber() + 1;
+  }
+
+
   void D3D11ImmediateContext::FlushImplicit(BOOL StrongHint) {
     // Flush only if the GPU is about to go idle, in
     // order to keep the number of submissions low.
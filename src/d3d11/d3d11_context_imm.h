@@ -6,6 +6,7 @@
 
 #include "d3d11_context.h"
 #include "d3d11_state_object.h"
+#include "d3d11_upload_ring.h"
 #include "d3d11_video.h"
 
 namespace dxvk {
@@ -111,7 +112,8 @@ namespace dxvk {
            ID3DDeviceContextState*           pState,
            ID3DDeviceContextState**          ppPreviousState);
 
-    void SynchronizeCsThread();
+    void SynchronizeCsThread(
+            uint64_t                          SequenceNumber);
     
   private:
     
@@ -126,6 +128,8 @@ namespace dxvk {
     
     D3D11VideoContext            m_videoContext;
     Com<D3D11DeviceContextState> m_stateObject;
+
+    std::unique_ptr<D3D11UploadRing> m_uploadRing;
     
     HRESULT MapBuffer(
             D3D11Buffer*                pResource,
@@ -133,6 +137,8 @@ namespace dxvk {
             UINT                        MapFlags,
             D3D11_MAPPED_SUBRESOURCE*   pMappedResource);
     
+    void EvictUploadRingBuffers();
+
     HRESULT MapImage(
             D3D11CommonTexture*         pResource,
             UINT                        Subresource,
@@ -148,11 +154,14 @@ namespace dxvk {
     
     bool WaitForResource(
       const Rc<DxvkResource>&                 Resource,
+            uint64_t                          SequenceNumber,
             D3D11_MAP                         MapType,
             UINT                              MapFlags);
     
     void EmitCsChunk(DxvkCsChunkRef&& chunk);
 
+    uint64_t GetCurrentSequenceNumber();
+
     void FlushImplicit(BOOL StrongHint);
 
     void SignalEvent(HANDLE hEvent);
@@ -41,6 +41,13 @@ namespace dxvk {
     m_d3d11Formats  (m_dxvkAdapter),
     m_d3d11Options  (m_dxvkDevice->instance()->config(), m_dxvkDevice),
     m_dxbcOptions   (m_dxvkDevice, m_d3d11Options) {
+    if (m_d3d11Options.dcParallelRecording || m_d3d11Options.dcBakeCommandLists) {
+      if (m_dxvkDevice->config().enableMemoryDefrag)
+        Logger::warn("D3D11: Command list recording is not supported with memory defragmentation");
+      else
+        m_cmdListRecorder = new D3D11CommandListRecorder(this);
+    }
+
     m_initializer = new D3D11Initializer(this);
     m_context     = new D3D11ImmediateContext(this, m_dxvkDevice);
     m_d3d10Device = new D3D10Device(this, m_context.ptr());
@@ -50,6 +57,7 @@ namespace dxvk {
   D3D11Device::~D3D11Device() {
     delete m_d3d10Device;
     m_context = nullptr;
+    delete m_cmdListRecorder;
     delete m_initializer;
   }
   
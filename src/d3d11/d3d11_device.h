@@ -416,6 +416,10 @@ namespace dxvk {
       return &m_d3d11Options;
     }
 
+    D3D11CommandListRecorder* GetCommandListRecorder() const {
+      return m_cmdListRecorder;
+    }
+
     D3D10Device* GetD3D10Interface() const {
       return m_d3d10Device;
     }
@@ -446,6 +450,7 @@ namespace dxvk {
     DxvkCsChunkPool                 m_csChunkPool;
     
     D3D11Initializer*               m_initializer = nullptr;
+    D3D11CommandListRecorder*       m_cmdListRecorder = nullptr;
     D3D10Device*                    m_d3d10Device = nullptr;
     Com<D3D11ImmediateContext, false> m_context;
 
@@ -8,10 +8,14 @@ namespace dxvk {
     const DxvkDeviceInfo& devInfo = device->properties();
 
     this->dcSingleUseMode       = config.getOption<bool>("d3d11.dcSingleUseMode", true);
+    this->dcParallelRecording   = config.getOption<bool>("d3d11.dcParallelRecording", false);
+    this->dcBakeCommandLists    = config.getOption<bool>("d3d11.dcBakeCommandLists", false);
     this->enableRtOutputNanFixup   = config.getOption<bool>("d3d11.enableRtOutputNanFixup", false);
     this->zeroInitWorkgroupMemory  = config.getOption<bool>("d3d11.zeroInitWorkgroupMemory", false);
     this->forceTgsmBarriers     = config.getOption<bool>("d3d11.forceTgsmBarriers", false);
     this->relaxedBarriers       = config.getOption<bool>("d3d11.relaxedBarriers", false);
+    this->dynamicBufferRing     = config.getOption<bool>("d3d11.dynamicBufferRing", false);
+    this->elideRedundantState   = config.getOption<bool>("d3d11.elideRedundantState", false);
     this->maxTessFactor         = config.getOption<int32_t>("d3d11.maxTessFactor", 0);
     this->samplerAnisotropy     = config.getOption<int32_t>("d3d11.samplerAnisotropy", -1);
     this->invariantPosition     = config.getOption<bool>("d3d11.invariantPosition", true);
@@ -20,6 +20,14 @@ namespace dxvk {
     /// than once.
     bool dcSingleUseMode;
 
+    /// Records deferred context command lists into
+    /// secondary command buffers on worker threads
+    bool dcParallelRecording;
+
+    /// Bakes deferred context command lists that get executed
+    /// more than once into reusable secondary command buffers
+    bool dcBakeCommandLists;
+
     /// Enables workaround to replace NaN render target
     /// outputs with zero
     bool enableRtOutputNanFixup;
@@ -95,6 +103,14 @@ namespace dxvk {
     /// performs the required shader and resolve fixups.
     bool disableMsaa;
 
+    /// Serve discards of small dynamic constant and
+    /// vertex buffers from a shared upload ring
+    bool dynamicBufferRing;
+
+    /// Skip state commands on the worker thread
+    /// that are overwritten before being used
+    bool elideRedundantState;
+
     /// Apitrace mode: Maps all buffers in cached memory.
     /// Enabled automatically if dxgitrace.dll is attached.
     bool apitraceMode;
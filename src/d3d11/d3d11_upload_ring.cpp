@@ -0,0 +1,152 @@
+#include "d3d11_buffer.h"
+#include "d3d11_device.h"
+#include "d3d11_upload_ring.h"
+
+namespace dxvk {
+
+  D3D11UploadRing::D3D11UploadRing(
+          D3D11Device*            pDevice)
+  : m_signal(new sync::Fence()) {
+    Rc<DxvkDevice> device = pDevice->GetDXVKDevice();
+
+    DxvkBufferCreateInfo info;
+    info.size   = RingSize;
+    info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT
+                | pDevice->GetEnabledShaderStages();
+    info.access = VK_ACCESS_TRANSFER_READ_BIT
+                | VK_ACCESS_TRANSFER_WRITE_BIT
+                | VK_ACCESS_UNIFORM_READ_BIT
+                | VK_ACCESS_SHADER_READ_BIT;
+
+    // Index buffers are bound without a size, so robustness would
+    // let out-of-bounds reads return data of other buffers in the
+    // ring. The same goes for vertex buffers, unless they can be
+    // bound with an explicit size.
+    m_bindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+    if (device->features().extExtendedDynamicState.extendedDynamicState) {
+      m_bindFlags |= D3D11_BIND_VERTEX_BUFFER;
+
+      info.usage  |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+      info.stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+      info.access |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    }
+
+    m_buffer = device->createBuffer(info,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // Allocations must satisfy the alignment requirements
+    // of every buffer type that can be served from the ring
+    const auto& limits = device->properties().core.properties.limits;
+
+    m_alignment = std::max<VkDeviceSize>(256, limits.nonCoherentAtomSize);
+    m_alignment = std::max(m_alignment, limits.minUniformBufferOffsetAlignment);
+    m_alignment = std::max(m_alignment, limits.minStorageBufferOffsetAlignment);
+  }
+
+
+  D3D11UploadRing::~D3D11UploadRing() {
+
+  }
+
+
+  bool D3D11UploadRing::IsSupported(
+    const D3D11Buffer*            pBuffer) const {
+    const D3D11_BUFFER_DESC* desc = pBuffer->Desc();
+
+    // Views cache view handles for each slice, so
+    // buffers that can have views are not supported
+    return desc->Usage == D3D11_USAGE_DYNAMIC
+        && desc->ByteWidth <= MaxAllocSize
+        && !(desc->BindFlags & ~m_bindFlags)
+        && !(desc->MiscFlags);
+  }
+
+
+  DxvkBufferSliceHandle D3D11UploadRing::Alloc(
+          D3D11Buffer*            pBuffer) {
+    VkDeviceSize length = pBuffer->Desc()->ByteWidth;
+    VkDeviceSize size = align(length, m_alignment);
+    VkDeviceSize head = align(m_head, m_alignment);
+
+    // Don't wrap allocations around the end of the buffer
+    if ((head % RingSize) + size > RingSize)
+      head = align(head, RingSize);
+
+    if (head + size - m_tail > RingSize) {
+      RetireFrames();
+
+      if (head + size - m_tail > RingSize)
+        return DxvkBufferSliceHandle();
+    }
+
+    m_head = head + size;
+
+    User& user = m_users[pBuffer];
+    user.frameId = m_frameId + 1;
+
+    if (user.buffer == nullptr)
+      user.buffer = pBuffer;
+
+    return m_buffer->getSliceHandle(head % RingSize, length);
+  }
+
+
+  void D3D11UploadRing::Release(
+          D3D11Buffer*            pBuffer) {
+    m_users.erase(pBuffer);
+  }
+
+
+  std::vector<Com<D3D11Buffer, false>> D3D11UploadRing::GetIdleBuffers() {
+    std::vector<Com<D3D11Buffer, false>> result;
+
+    for (auto i = m_users.begin(); i != m_users.end(); ) {
+      if (i->second.frameId <= m_frameId) {
+        result.push_back(std::move(i->second.buffer));
+        i = m_users.erase(i);
+      } else {
+        i++;
+      }
+    }
+
+    return result;
+  }
+
+
+  uint64_t D3D11UploadRing::EndFrame() {
+    // Memory of the previous frame may still be in use by
+    // the frame that is ending now, so we need to signal
+    // even if nothing was allocated during this frame.
+    if (m_head == m_frameStart && m_frames.empty())
+      return 0;
+
+    m_frameId += 1;
+
+    if (m_head != m_frameStart) {
+      m_frames.push({ m_frameId, m_head });
+      m_frameStart = m_head;
+    }
+
+    return m_frameId;
+  }
+
+
+  void D3D11UploadRing::RetireFrames() {
+    uint64_t completed = m_signal->value();
+
+    // Ring memory of a frame can be accessed by the GPU
+    // until the frame after it completes, see above.
+    while (!m_frames.empty() && m_frames.front().id < completed) {
+      m_tail = m_frames.front().end;
+      m_frames.pop();
+    }
+  }
+
+}
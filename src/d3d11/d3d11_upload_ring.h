@@ -0,0 +1,141 @@
+#pragma once
+
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "../dxvk/dxvk_buffer.h"
+
+#include "d3d11_include.h"
+
+namespace dxvk {
+
+  class D3D11Buffer;
+  class D3D11Device;
+
+  /**
+   * \brief Upload ring for dynamic buffers
+   *
+   * Serves \c D3D11_MAP_WRITE_DISCARD on small dynamic
+   * constant buffers, and vertex buffers if they can be
+   * bound with a size, from one large, persistently mapped
+   * buffer instead of renaming each buffer through its own
+   * set of slices.
+   *
+   * Memory is handed out linearly and grouped into frames,
+   * which end whenever the immediate context flushes. Buffers
+   * that were not discarded again during a frame must be moved
+   * back to their own storage at the end of that frame, so
+   * that the memory of any given frame is only ever used by
+   * that frame and the next one, and can be reused once the
+   * GPU has completed the latter. If the ring is full,
+   * allocations fail and buffers must be renamed the
+   * regular way.
+   */
+  class D3D11UploadRing {
+    constexpr static VkDeviceSize RingSize     = 16 << 20;
+    constexpr static VkDeviceSize MaxAllocSize = 64 << 10;
+  public:
+
+    D3D11UploadRing(
+            D3D11Device*            pDevice);
+
+    ~D3D11UploadRing();
+
+    /**
+     * \brief Checks whether a buffer can use the ring
+     *
+     * \param [in] pBuffer The buffer
+     * \returns \c true if discards of the buffer
+     *    can be served from the upload ring
+     */
+    bool IsSupported(
+      const D3D11Buffer*            pBuffer) const;
+
+    /**
+     * \brief Allocates a buffer slice
+     *
+     * The buffer is tracked until it gets discarded the
+     * regular way or is returned by \ref GetIdleBuffers.
+     * \param [in] pBuffer The buffer to allocate for
+     * \returns Buffer slice, or a slice with a null
+     *    handle if the ring does not have enough space
+     */
+    DxvkBufferSliceHandle Alloc(
+            D3D11Buffer*            pBuffer);
+
+    /**
+     * \brief Stops tracking a buffer
+     *
+     * Must be called when a buffer that may currently
+     * use ring memory gets discarded the regular way.
+     * \param [in] pBuffer The buffer
+     */
+    void Release(
+            D3D11Buffer*            pBuffer);
+
+    /**
+     * \brief Retrieves buffers that must leave the ring
+     *
+     * Returns all buffers that use ring memory, but were
+     * not discarded during the current frame. Must be
+     * called right before \ref EndFrame, and the caller
+     * must move these buffers back to their own storage
+     * before the end of the frame is signaled.
+     * \returns Buffers that are no longer tracked
+     */
+    std::vector<Com<D3D11Buffer, false>> GetIdleBuffers();
+
+    /**
+     * \brief Ends the current frame
+     *
+     * The returned value must be signaled through
+     * \ref GetSignal once the GPU is done with all
+     * work that was submitted so far.
+     * \returns Signal value, or 0 if no ring memory
+     *    is waiting for the GPU to complete
+     */
+    uint64_t EndFrame();
+
+    /**
+     * \brief Frame completion signal
+     * \returns Frame completion signal
+     */
+    Rc<sync::Signal> GetSignal() const {
+      return m_signal;
+    }
+
+  private:
+
+    struct Frame {
+      uint64_t      id;
+      VkDeviceSize  end;
+    };
+
+    struct User {
+      Com<D3D11Buffer, false> buffer;
+      uint64_t                frameId;
+    };
+
+    Rc<DxvkBuffer>    m_buffer;
+    Rc<sync::Fence>   m_signal;
+
+    VkDeviceSize      m_alignment = 0;
+    UINT              m_bindFlags = 0;
+
+    // Ring positions increase monotonically and
+    // are mapped to buffer offsets modulo size
+    VkDeviceSize      m_head = 0;
+    VkDeviceSize      m_tail = 0;
+    VkDeviceSize      m_frameStart = 0;
+
+    uint64_t          m_frameId = 0;
+    std::queue<Frame> m_frames;
+
+    std::unordered_map<D3D11Buffer*, User> m_users;
+
+    void RetireFrames();
+
+  };
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../dxvk/dxvk_cs.h"
 #include "../dxvk/dxvk_device.h"
 
 #include "d3d9_device_child.h"
@@ -175,6 +176,31 @@ namespace dxvk {
 
     void PreLoad();
 
+    /**
+     * \brief Tracks sequence number of mapping buffer use
+     *
+     * Must be called whenever a CS command that accesses
+     * the mapping buffer gets recorded, so that locking
+     * the buffer only has to wait for that command.
+     * \param [in] Seq Sequence number of the CS chunk
+     */
+    void TrackMappingBufferSequenceNumber(uint64_t Seq) {
+      m_seq = Seq;
+    }
+
+    /**
+     * \brief Queries sequence number of mapping buffer use
+     *
+     * Buffers that are mapped directly may be used by
+     * any draw, so those always require a full sync.
+     * \returns Sequence number of the last CS chunk that
+     *    accessed the mapping buffer
+     */
+    uint64_t GetMappingBufferSequenceNumber() const {
+      return GetMapMode() == D3D9_COMMON_BUFFER_MAP_MODE_BUFFER
+        ? m_seq : DxvkCsThread::SynchronizeAll;
+    }
+
   private:
 
     Rc<DxvkBuffer> CreateBuffer() const;
@@ -207,6 +233,8 @@ namespace dxvk {
 
     uint32_t                    m_lockCount = 0;
 
+    uint64_t                    m_seq = 0ull;
+
   };
 
 }
\ No newline at end of file
@@ -408,6 +408,27 @@ namespace dxvk {
       return m_dirtyBoxes[layer];
     }
 
+    /**
+     * \brief Tracks sequence number of mapping buffer use
+     *
+     * Must be called whenever a CS command that accesses
+     * one of the mapping buffers gets recorded, so that
+     * locking the texture only has to wait for that command.
+     * \param [in] Seq Sequence number of the CS chunk
+     */
+    void TrackMappingBufferSequenceNumber(uint64_t Seq) {
+      m_seq = Seq;
+    }
+
+    /**
+     * \brief Queries sequence number of mapping buffer use
+     * \returns Sequence number of the last CS chunk that
+     *    accessed any of the texture's mapping buffers
+     */
+    uint64_t GetMappingBufferSequenceNumber() const {
+      return m_seq;
+    }
+
   private:
 
     D3D9DeviceEx*                 m_device;
@@ -428,6 +449,8 @@ namespace dxvk {
 
     int64_t                       m_size = 0;
 
+    uint64_t                      m_seq = 0ull;
+
     bool                          m_systemmemModified = false;
 
     bool                          m_hazardous = false;
@@ -85,7 +85,7 @@ namespace dxvk {
 
   D3D9DeviceEx::~D3D9DeviceEx() {
     Flush();
-    SynchronizeCsThread();
+    SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
     delete m_initializer;
     delete m_converter;
@@ -301,7 +301,7 @@ namespace dxvk {
       return hr;
 
     Flush();
-    SynchronizeCsThread();
+    SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
     return D3D_OK;
   }
@@ -871,6 +871,7 @@ namespace dxvk {
         cLevelExtent);
     });
 
+    dstTexInfo->TrackMappingBufferSequenceNumber(GetCurrentSequenceNumber());
     dstTexInfo->SetWrittenByGPU(dst->GetSubresource(), true);
 
     return D3D_OK;
@@ -2607,6 +2608,8 @@ namespace dxvk {
       ](DxvkContext* ctx) {
         ctx->copyBuffer(cDstBuffer, cOffset, cSrcBuffer, cOffset, cCopySize);
       });
+
+      dst->TrackMappingBufferSequenceNumber(GetCurrentSequenceNumber());
     }
 
     dst->SetWrittenByGPU(true);
@@ -3937,10 +3940,11 @@ namespace dxvk {
 
   bool D3D9DeviceEx::WaitForResource(
   const Rc<DxvkResource>&                 Resource,
+        uint64_t                          SequenceNumber,
         DWORD                             MapFlags) {
-    // Wait for the any pending D3D9 command to be executed
-    // on the CS thread so that we can determine whether the
-    // resource is currently in use or not.
+    // Wait for the last D3D9 command using the resource to be
+    // executed on the CS thread so that we can determine whether
+    // the resource is currently in use or not.
 
     // Determine access type to wait for based on map mode
     DxvkAccess access = (MapFlags & D3DLOCK_READONLY)
@@ -3948,7 +3952,7 @@ namespace dxvk {
       : DxvkAccess::Read;
 
     if (!Resource->isInUse(access))
-      SynchronizeCsThread();
+      SynchronizeCsThread(SequenceNumber);
 
     if (Resource->isInUse(access)) {
       if (MapFlags & D3DLOCK_DONOTWAIT) {
@@ -3962,7 +3966,7 @@ namespace dxvk {
         // Make sure pending commands using the resource get
         // executed on the the GPU if we have to wait for it
         Flush();
-        SynchronizeCsThread();
+        SynchronizeCsThread(SequenceNumber);
 
         Resource->waitIdle(access);
       }
@@ -4091,6 +4095,8 @@ namespace dxvk {
       ] (DxvkContext* ctx) {
         ctx->invalidateBuffer(cImageBuffer, cBufferSlice);
       });
+
+      pResource->TrackMappingBufferSequenceNumber(GetCurrentSequenceNumber());
     }
     else if ((managed && !m_d3d9Options.evictManagedOnUnlock) || scratch || systemmem) {
       // Managed and scratch resources
@@ -4109,7 +4115,7 @@ namespace dxvk {
         std::memset(physSlice.mapPtr, 0, physSlice.length);
       }
       else if (!skipWait) {
-        if (!WaitForResource(mappedBuffer, Flags))
+        if (!WaitForResource(mappedBuffer, pResource->GetMappingBufferSequenceNumber(), Flags))
           return D3DERR_WASSTILLDRAWING;
       }
     }
@@ -4186,7 +4192,9 @@ namespace dxvk {
           }
         });
 
-        if (!WaitForResource(mappedBuffer, Flags))
+        pResource->TrackMappingBufferSequenceNumber(GetCurrentSequenceNumber());
+
+        if (!WaitForResource(mappedBuffer, pResource->GetMappingBufferSequenceNumber(), Flags))
           return D3DERR_WASSTILLDRAWING;
       } else if (alloced) {
         // If we are a new alloc, and we weren't written by the GPU
@@ -4386,7 +4394,7 @@ namespace dxvk {
         pitch, std::min(convertFormat.PlaneCount, 2u) * pitch * texLevelExtentBlockCount.height);
 
       Flush();
-      SynchronizeCsThread();
+      SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
       m_converter->ConvertFormat(
         convertFormat,
@@ -4488,6 +4496,8 @@ namespace dxvk {
         ctx->invalidateBuffer(cBuffer, cBufferSlice);
       });
 
+      pResource->TrackMappingBufferSequenceNumber(GetCurrentSequenceNumber());
+
       pResource->SetWrittenByGPU(false);
       pResource->GPUReadingRange().Clear();
     }
@@ -4507,7 +4517,7 @@ namespace dxvk {
                             quickRead                     ||
                             (boundsCheck && !pResource->GPUReadingRange().Overlaps(pResource->DirtyRange()));
       if (!skipWait) {
-        if (!WaitForResource(mappingBuffer, Flags))
+        if (!WaitForResource(mappingBuffer, pResource->GetMappingBufferSequenceNumber(), Flags))
           return D3DERR_WASSTILLDRAWING;
 
         pResource->SetWrittenByGPU(false);
@@ -4617,15 +4627,16 @@ namespace dxvk {
   }
 
 
-  void D3D9DeviceEx::SynchronizeCsThread() {
+  void D3D9DeviceEx::SynchronizeCsThread(uint64_t SequenceNumber) {
     D3D9DeviceLock lock = LockDevice();
 
     // Dispatch current chunk so that all commands
     // recorded prior to this function will be run
-    FlushCsChunk();
+    if (SequenceNumber > m_csThread.lastSequenceNumber())
+      FlushCsChunk();
 
     if (m_csThread.isBusy())
-      m_csThread.synchronize();
+      m_csThread.synchronize(SequenceNumber);
   }
 
 
@@ -7066,7 +7077,7 @@ namespace dxvk {
       return hr;
 
     Flush();
-    SynchronizeCsThread();
+    SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
     return D3D_OK;
   }
@@ -665,6 +665,7 @@ namespace dxvk {
 
     bool WaitForResource(
       const Rc<DxvkResource>&                 Resource,
+            uint64_t                          SequenceNumber,
             DWORD                             MapFlags);
 
     /**
@@ -734,7 +735,8 @@ namespace dxvk {
 
     void CreateConstantBuffers();
 
-    void SynchronizeCsThread();
+    void SynchronizeCsThread(
+            uint64_t            SequenceNumber);
 
     void Flush();
 
@@ -946,12 +948,12 @@ namespace dxvk {
     }
 
     template<typename Cmd>
-    void EmitCs(Cmd&& command) {
-      if (unlikely(!m_csChunk->push(command))) {
+    void EmitCs(Cmd&& command, DxvkCsTag tag = DXVK_CS_TAG()) {
+      if (unlikely(!m_csChunk->push(command, DxvkCsStateKey(), tag))) {
         EmitCsChunk(std::move(m_csChunk));
 
         m_csChunk = AllocCsChunk();
-        m_csChunk->push(command);
+        m_csChunk->push(command, DxvkCsStateKey(), tag);
       }
     }
 
@@ -964,6 +966,18 @@ namespace dxvk {
       }
     }
 
+    /**
+     * \brief Queries sequence number of the current CS chunk
+     *
+     * This is the sequence number that the chunk holding
+     * the most recently emitted command will get once it
+     * gets dispatched to the CS thread.
+     * \returns Sequence number of the current CS chunk
+     */
+    uint64_t GetCurrentSequenceNumber() const {
+      return m_csThread.lastSequenceNumber() + 1;
+    }
+
     bool CanSWVP() {
       return m_behaviorFlags & (D3DCREATE_MIXED_VERTEXPROCESSING | D3DCREATE_SOFTWARE_VERTEXPROCESSING);
     }
@@ -447,7 +447,8 @@ namespace dxvk {
         cImage, cSubresources, VkOffset3D { 0, 0, 0 },
         cLevelExtent);
     });
-    
+
+    dstTexInfo->TrackMappingBufferSequenceNumber(m_parent->GetCurrentSequenceNumber());
     dstTexInfo->SetWrittenByGPU(dst->GetSubresource(), true);
 
     return D3D_OK;
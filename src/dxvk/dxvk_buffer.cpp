@@ -33,27 +33,111 @@ namespace dxvk {
 
     DxvkBufferSliceHandle slice;
     slice.handle = m_buffer.buffer;
-    slice.offset = 0;
+    slice.offset = m_buffer.offset;
     slice.length = m_physSliceLength;
     slice.mapPtr = m_buffer.memory.mapPtr(0);
 
     m_physSlice = slice;
     m_lazyAlloc = m_physSliceCount > 1;
+
+    // The initial slice can be returned without ever calling
+    // allocSlice if the buffer gets renamed to an external
+    // slice, so there must always be a queue to return it to
+    reserveSlices();
+
+    m_frameId       = device->getCurrentFrameId();
+    m_shrinkFrameId = m_frameId;
+
+    // Buffers need to be copied on the GPU when relocated
+    constexpr VkBufferUsageFlags copyUsage
+      = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+      | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    constexpr VkBufferUsageFlags texelUsage
+      = VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT
+      | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+
+    m_relocatable = !(memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+      && (createInfo.usage & copyUsage) == copyUsage
+      && !(createInfo.usage & texelUsage);
+
+    if (!m_relocatable)
+      m_memAlloc->pinMemory(m_buffer.memory);
+
+    // Buffer views cache view handles for each slice,
+    // so backing buffers must stay alive for those
+    m_shrinkable = !(createInfo.usage & texelUsage);
   }
 
 
   DxvkBuffer::~DxvkBuffer() {
+    // Must happen first since the device may
+    // be shrinking the buffer at the same time
+    if (m_shrinkTracked.load())
+      m_device->untrackRenamedBuffer(this);
+
     auto vkd = m_device->vkd();
 
-    for (const auto& buffer : m_buffers)
-      vkd->vkDestroyBuffer(vkd->device(), buffer.buffer, nullptr);
-    vkd->vkDestroyBuffer(vkd->device(), m_buffer.buffer, nullptr);
+    for (const auto& entry : m_buffers) {
+      if (!entry.handle.isPooled())
+        vkd->vkDestroyBuffer(vkd->device(), entry.handle.buffer, nullptr);
+    }
+
+    if (!m_buffer.isPooled())
+      vkd->vkDestroyBuffer(vkd->device(), m_buffer.buffer, nullptr);
   }
   
   
+  DxvkBufferHandle DxvkBuffer::relocate() {
+    std::lock_guard<sync::Spinlock> freeLock(m_freeMutex);
+
+    // If the buffer has been renamed before, slices of
+    // the current backing buffer may still be in use
+    if (!m_buffers.empty() || (!m_lazyAlloc && m_physSliceCount > 1))
+      return DxvkBufferHandle();
+
+    DxvkBufferHandle handle;
+
+    try {
+      handle = allocBuffer(m_physSliceCount);
+    } catch (const DxvkError& e) {
+      Logger::warn(str::format("DxvkBuffer: Failed to relocate buffer: ", e.message()));
+      return DxvkBufferHandle();
+    }
+
+    incrementVersion();
+
+    m_physSlice.handle = handle.buffer;
+    m_physSlice.offset = handle.offset;
+    m_physSlice.mapPtr = handle.memory.mapPtr(0);
+    return std::exchange(m_buffer, std::move(handle));
+  }
+
+
   DxvkBufferHandle DxvkBuffer::allocBuffer(VkDeviceSize sliceCount) const {
     auto vkd = m_device->vkd();
 
+    // Use high memory priority for GPU-writable resources
+    bool isGpuWritable = (m_info.access & (
+      VK_ACCESS_SHADER_WRITE_BIT |
+      VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT)) != 0;
+    float priority = isGpuWritable ? 1.0f : 0.5f;
+
+    DxvkBufferHandle handle;
+
+    // Small buffers are sub-allocated from a buffer that spans an
+    // entire memory chunk, which saves both memory and driver-side
+    // buffer objects for apps that create lots of tiny buffers.
+    handle.memory = m_memAlloc->allocBufferMemory(
+      m_physSliceStride * sliceCount, computeSliceAlignment(),
+      m_info.usage, m_memFlags, priority);
+
+    if (handle.memory) {
+      handle.buffer = handle.memory.buffer();
+      handle.offset = handle.memory.offset();
+      return handle;
+    }
+
     VkBufferCreateInfo info;
     info.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     info.pNext                 = nullptr;
@@ -63,8 +147,6 @@ namespace dxvk {
     info.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
     info.queueFamilyIndexCount = 0;
     info.pQueueFamilyIndices   = nullptr;
-    
-    DxvkBufferHandle handle;
 
     if (vkd->vkCreateBuffer(vkd->device(),
           &info, nullptr, &handle.buffer) != VK_SUCCESS) {
@@ -98,12 +180,6 @@ namespace dxvk {
     vkd->vkGetBufferMemoryRequirements2(
        vkd->device(), &memReqInfo, &memReq);
 
-    // Use high memory priority for GPU-writable resources
-    bool isGpuWritable = (m_info.access & (
-      VK_ACCESS_SHADER_WRITE_BIT |
-      VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT)) != 0;
-    float priority = isGpuWritable ? 1.0f : 0.5f;
-    
     // Ask driver whether we should be using a dedicated allocation
     handle.memory = m_memAlloc->alloc(&memReq.memoryRequirements,
       dedicatedRequirements, dedMemoryAllocInfo, m_memFlags, priority);
@@ -116,6 +192,128 @@ namespace dxvk {
   }
 
 
+  void DxvkBuffer::collectSlices() {
+    DxvkBufferSliceHandle slice;
+
+    for (const auto& queue : m_freeQueues) {
+      while (queue->pop(slice))
+        m_freeSlices.push_back(slice);
+    }
+  }
+
+
+  void DxvkBuffer::reserveSlices() {
+    auto queue = m_freeQueue.load(std::memory_order_relaxed);
+
+    if (queue && queue->capacity() >= m_totalSliceCount)
+      return;
+
+    // Over-allocate a bit so that we don't have to
+    // replace the queue every time the buffer grows
+    m_freeQueues.push_back(std::make_unique<SliceQueue>(2 * m_totalSliceCount));
+    m_freeQueue.store(m_freeQueues.back().get(), std::memory_order_release);
+  }
+
+
+  void DxvkBuffer::shrinkSlices() {
+    // Only check once per frame since this scans the free list
+    uint32_t frameId = m_device->getCurrentFrameId();
+
+    if (likely(frameId == m_frameId))
+      return;
+
+    m_frameId = frameId;
+
+    if (!m_shrinkable || m_buffers.empty())
+      return;
+
+    // Only the most recently added backing buffer, which is
+    // also the largest one, is considered for release. If the
+    // peak number of slices in use did not leave enough slices
+    // unused to release it, start over, so that buffers that
+    // are needed every now and then don't get reallocated.
+    const BufferEntry& entry = m_buffers.back();
+
+    if (m_peakSliceCount + entry.sliceCount > m_totalSliceCount) {
+      m_shrinkFrameId  = frameId;
+      m_peakSliceCount = m_usedSliceCount.load();
+      return;
+    }
+
+    if (frameId - m_shrinkFrameId < ShrinkFrameCount)
+      return;
+
+    // Some of its slices may still be in use even if
+    // the total count suggests otherwise, so this may
+    // fail. Just try again on the next frame if it does.
+    if (!releaseBuffer(entry))
+      return;
+
+    m_totalSliceCount -= entry.sliceCount;
+    m_physSliceCount   = entry.sliceCount;
+    m_buffers.pop_back();
+
+    m_shrinkFrameId  = frameId;
+    m_peakSliceCount = m_usedSliceCount.load();
+  }
+
+
+  bool DxvkBuffer::shrink() {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex, std::try_to_lock);
+
+    // Don't stall the caller, just try again next frame
+    if (!freeLock)
+      return true;
+
+    shrinkSlices();
+
+    if (!m_buffers.empty())
+      return true;
+
+    m_shrinkTracked.store(false);
+    return false;
+  }
+
+
+  void DxvkBuffer::trackShrink() {
+    m_device->trackRenamedBuffer(this);
+  }
+
+
+  bool DxvkBuffer::releaseBuffer(
+    const BufferEntry&          entry) {
+    const VkDeviceSize rangeBegin = entry.handle.offset;
+    const VkDeviceSize rangeEnd   = entry.handle.offset + entry.sliceCount * m_physSliceStride;
+
+    auto isFromEntry = [&] (const DxvkBufferSliceHandle& slice) {
+      return slice.handle == entry.handle.buffer
+          && slice.offset >= rangeBegin
+          && slice.offset <  rangeEnd;
+    };
+
+    // Slices that are still being returned by
+    // another thread will be missed, which is fine
+    this->collectSlices();
+
+    size_t freeCount = std::count_if(m_freeSlices.begin(), m_freeSlices.end(), isFromEntry);
+
+    if (freeCount != entry.sliceCount)
+      return false;
+
+    m_freeSlices.erase(std::remove_if(m_freeSlices.begin(), m_freeSlices.end(), isFromEntry), m_freeSlices.end());
+
+    // Slices only get returned to the free lists once the
+    // GPU is done with them, so we can destroy the buffer
+    // right away. The memory is freed by the caller.
+    if (!entry.handle.isPooled()) {
+      auto vkd = m_device->vkd();
+      vkd->vkDestroyBuffer(vkd->device(), entry.handle.buffer, nullptr);
+    }
+
+    return true;
+  }
+
+
   VkDeviceSize DxvkBuffer::computeSliceAlignment() const {
     const auto& devInfo = m_device->properties().core.properties;
 
@@ -218,6 +416,20 @@ namespace dxvk {
   }
   
   
+  DxvkRetiredBuffer::DxvkRetiredBuffer(
+    const Rc<vk::DeviceFn>&         vkd,
+          DxvkBufferHandle&&        handle)
+  : m_vkd(vkd), m_handle(std::move(handle)) {
+
+  }
+
+
+  DxvkRetiredBuffer::~DxvkRetiredBuffer() {
+    if (!m_handle.isPooled())
+      m_vkd->vkDestroyBuffer(m_vkd->device(), m_handle.buffer, nullptr);
+  }
+
+
   DxvkBufferTracker:: DxvkBufferTracker() { }
   DxvkBufferTracker::~DxvkBufferTracker() { }
   
@@ -56,10 +56,25 @@ namespace dxvk {
    * 
    * Stores a Vulkan buffer handle and the
    * memory object that is bound to the buffer.
+   * Small buffers may be sub-allocated from a
+   * buffer owned by the memory allocator, in
+   * which case the offset will be non-zero.
    */
   struct DxvkBufferHandle {
     VkBuffer      buffer = VK_NULL_HANDLE;
+    VkDeviceSize  offset = 0;
     DxvkMemory    memory;
+
+    /**
+     * \brief Checks whether the buffer is pooled
+     * 
+     * Pooled buffers are owned by the memory allocator
+     * and must not be destroyed by the buffer object.
+     * \returns \c true if the buffer is shared
+     */
+    bool isPooled() const {
+      return buffer == memory.buffer();
+    }
   };
   
 
@@ -101,6 +116,8 @@ namespace dxvk {
    */
   class DxvkBuffer : public DxvkResource {
     friend class DxvkBufferView;
+
+    constexpr static uint32_t ShrinkFrameCount = 60;
   public:
     
     DxvkBuffer(
@@ -200,11 +217,28 @@ namespace dxvk {
      * not call this directly as this is called implicitly
      * by the context's \c invalidateBuffer method.
      * \param [in] slice The new backing resource
+     * \param [in] external Whether the slice was allocated
+     *    from somewhere other than \ref allocSlice
      * \returns Previous buffer slice
      */
-    DxvkBufferSliceHandle rename(const DxvkBufferSliceHandle& slice) {
+    DxvkBufferSliceHandle rename(const DxvkBufferSliceHandle& slice, bool external) {
+      incrementVersion();
+
+      m_physSliceExternal = external;
       return std::exchange(m_physSlice, slice);
     }
+
+    /**
+     * \brief Checks whether the current slice is external
+     * 
+     * External slices must not be returned to the
+     * buffer via \ref freeSlice once renamed.
+     * \returns \c true if the current slice was not
+     *    allocated from this buffer
+     */
+    bool hasExternalSlice() const {
+      return m_physSliceExternal;
+    }
     
     /**
      * \brief Transform feedback vertex stride
@@ -234,35 +268,54 @@ namespace dxvk {
      */
     DxvkBufferSliceHandle allocSlice() {
       std::lock_guard<sync::Spinlock> freeLock(m_freeMutex);
+
+      // Release backing buffers that went unused
+      // for a while before allocating new ones
+      shrinkSlices();
       
-      // If no slices are available, swap the two free lists.
-      if (unlikely(m_freeSlices.empty())) {
-        std::lock_guard<sync::Spinlock> swapLock(m_swapMutex);
-        std::swap(m_freeSlices, m_nextSlices);
-      }
+      // If no slices are available, take the ones
+      // that have been returned since the last time
+      if (unlikely(m_freeSlices.empty()))
+        collectSlices();
 
       // If there are still no slices available, create a new
       // backing buffer and add all slices to the free list.
       if (unlikely(m_freeSlices.empty())) {
+        // Renamed buffers cannot be relocated anymore
+        m_memAlloc->pinMemory(m_buffer.memory);
+
         if (likely(!m_lazyAlloc)) {
           DxvkBufferHandle handle = allocBuffer(m_physSliceCount);
+          m_memAlloc->pinMemory(handle.memory);
 
           for (uint32_t i = 0; i < m_physSliceCount; i++)
             pushSlice(handle, i);
 
-          m_buffers.push_back(std::move(handle));
+          m_buffers.push_back({ std::move(handle), m_physSliceCount });
+          m_totalSliceCount += m_physSliceCount;
+
+          if (m_shrinkable && !m_shrinkTracked.exchange(true))
+            trackShrink();
           m_physSliceCount = std::min(m_physSliceCount * 2, m_physSliceMaxCount);
         } else {
           for (uint32_t i = 1; i < m_physSliceCount; i++)
             pushSlice(m_buffer, i);
 
+          m_totalSliceCount = m_physSliceCount;
           m_lazyAlloc = false;
         }
+
+        // Must happen before any of the new slices are
+        // handed out, so that they can be returned
+        reserveSlices();
       }
       
       // Take the first slice from the queue
       DxvkBufferSliceHandle result = m_freeSlices.back();
       m_freeSlices.pop_back();
+
+      uint32_t usedCount = m_usedSliceCount.fetch_add(1, std::memory_order_relaxed) + 1;
+      m_peakSliceCount = std::max(m_peakSliceCount, usedCount);
       return result;
     }
     
@@ -275,13 +328,62 @@ namespace dxvk {
      * \param [in] slice The buffer slice to free
      */
     void freeSlice(const DxvkBufferSliceHandle& slice) {
-      // Add slice to a separate free list to reduce lock contention.
-      std::lock_guard<sync::Spinlock> swapLock(m_swapMutex);
-      m_nextSlices.push_back(slice);
+      // The queue can hold every slice of the buffer, so
+      // this can only fail if the queue has been replaced
+      // with a larger one after we loaded the pointer.
+      auto queue = m_freeQueue.load(std::memory_order_acquire);
+
+      while (unlikely(!queue->push(slice)))
+        queue = m_freeQueue.load(std::memory_order_acquire);
+
+      m_usedSliceCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Checks whether the buffer should be relocated
+     * 
+     * This is the case if the backing storage was allocated
+     * from a memory chunk that the allocator tries to free.
+     * Only buffers that cannot be mapped and are not used
+     * as texel buffers can be relocated, since slice handles
+     * of those are not stored outside of the context.
+     * \returns \c true if the buffer should be relocated
+     */
+    bool needsRelocation() const {
+      return m_relocatable && m_buffer.memory.needsRelocation();
     }
+
+    /**
+     * \brief Relocates backing storage
+     * 
+     * Allocates a new backing buffer and makes it the current
+     * one. The caller must copy the buffer contents and keep
+     * the old buffer alive until the GPU is done using it.
+     * Buffers that have been renamed cannot be relocated.
+     * \returns Previous backing buffer, or a null handle
+     *    if the buffer could not be relocated
+     */
+    DxvkBufferHandle relocate();
+
+    /**
+     * \brief Releases unused backing buffers
+     * 
+     * Called once per frame for buffers that have been
+     * renamed, so that buffers which are no longer being
+     * discarded can release their surplus slices too.
+     * Does nothing if the buffer is currently locked.
+     * \returns \c true if the buffer still has
+     *    backing buffers that may be released
+     */
+    bool shrink();
     
   private:
 
+    struct BufferEntry {
+      DxvkBufferHandle  handle;
+      VkDeviceSize      sliceCount;
+    };
+
     DxvkDevice*             m_device;
     DxvkBufferCreateInfo    m_info;
     DxvkMemoryAllocator*    m_memAlloc;
@@ -292,31 +394,64 @@ namespace dxvk {
 
     uint32_t                m_vertexStride = 0;
     uint32_t                m_lazyAlloc = false;
+    bool                    m_relocatable = false;
+    bool                    m_shrinkable  = false;
+    bool                    m_physSliceExternal = false;
+
+    std::atomic<bool>       m_shrinkTracked = { false };
     
+    using SliceQueue = sync::BoundedMpscQueue<DxvkBufferSliceHandle>;
+
+    // Only taken when allocating slices, slices
+    // are returned through a lock-free queue
     sync::Spinlock m_freeMutex;
-    sync::Spinlock m_swapMutex;
     
-    std::vector<DxvkBufferHandle>        m_buffers;
+    std::vector<BufferEntry>             m_buffers;
     std::vector<DxvkBufferSliceHandle>   m_freeSlices;
-    std::vector<DxvkBufferSliceHandle>   m_nextSlices;
+
+    // Previous queues are kept alive since threads
+    // returning slices may still be using them
+    std::atomic<SliceQueue*>                  m_freeQueue = { nullptr };
+    std::vector<std::unique_ptr<SliceQueue>>  m_freeQueues;
     
     VkDeviceSize m_physSliceLength   = 0;
     VkDeviceSize m_physSliceStride   = 0;
     VkDeviceSize m_physSliceCount    = 1;
     VkDeviceSize m_physSliceMaxCount = 1;
 
+    // The current slice is in use, but was never
+    // returned by allocSlice, so start at one
+    std::atomic<uint32_t> m_usedSliceCount = { 1u };
+
+    VkDeviceSize m_totalSliceCount  = 1;
+    uint32_t     m_peakSliceCount   = 1;
+    uint32_t     m_frameId          = 0;
+    uint32_t     m_shrinkFrameId    = 0;
+
     void pushSlice(const DxvkBufferHandle& handle, uint32_t index) {
       DxvkBufferSliceHandle slice;
       slice.handle = handle.buffer;
       slice.length = m_physSliceLength;
       slice.offset = m_physSliceStride * index;
       slice.mapPtr = handle.memory.mapPtr(slice.offset);
+      slice.offset += handle.offset;
       m_freeSlices.push_back(slice);
     }
 
     DxvkBufferHandle allocBuffer(
             VkDeviceSize          sliceCount) const;
 
+    void collectSlices();
+
+    void reserveSlices();
+
+    void shrinkSlices();
+
+    void trackShrink();
+
+    bool releaseBuffer(
+      const BufferEntry&          entry);
+
     VkDeviceSize computeSliceAlignment() const;
     
   };
@@ -643,6 +778,31 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Retired buffer storage
+   * 
+   * Owns a backing buffer that a buffer has been
+   * relocated away from, and destroys it once the
+   * GPU has finished using it.
+   */
+  class DxvkRetiredBuffer : public DxvkResource {
+
+  public:
+
+    DxvkRetiredBuffer(
+      const Rc<vk::DeviceFn>&         vkd,
+            DxvkBufferHandle&&        handle);
+
+    ~DxvkRetiredBuffer();
+
+  private:
+
+    Rc<vk::DeviceFn>  m_vkd;
+    DxvkBufferHandle  m_handle;
+
+  };
+  
+  
   /**
    * \brief Buffer slice tracker
    * 
@@ -668,6 +828,14 @@ namespace dxvk {
     void freeBufferSlice(const Rc<DxvkBuffer>& buffer, const DxvkBufferSliceHandle& slice) {
       m_entries.push_back({ buffer, slice });
     }
+
+    /**
+     * \brief Checks whether any slices are tracked
+     * \returns \c true if no slices are tracked
+     */
+    bool empty() const {
+      return m_entries.empty();
+    }
     
     /**
      * \brief Returns tracked buffer slices
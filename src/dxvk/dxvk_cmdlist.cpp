@@ -3,10 +3,15 @@
 
 namespace dxvk {
     
-  DxvkCommandList::DxvkCommandList(DxvkDevice* device)
+  DxvkCommandList::DxvkCommandList(
+          DxvkDevice*           device,
+          VkCommandBufferLevel  level,
+          VkCommandBufferUsageFlags usage)
   : m_device        (device),
     m_vkd           (device->vkd()),
     m_vki           (device->instance()->vki()),
+    m_level         (level),
+    m_usage         (usage),
     m_cmdBuffersUsed(0),
     m_descriptorPoolTracker(device) {
     const auto& graphicsQueue = m_device->queues().graphics;
@@ -17,7 +22,8 @@ namespace dxvk {
     fenceInfo.pNext = nullptr;
     fenceInfo.flags = 0;
     
-    if (m_vkd->vkCreateFence(m_vkd->device(), &fenceInfo, nullptr, &m_fence) != VK_SUCCESS)
+    // Secondary command lists are never submitted on their own
+    if (!isSecondary() && m_vkd->vkCreateFence(m_vkd->device(), &fenceInfo, nullptr, &m_fence) != VK_SUCCESS)
       throw DxvkError("DxvkCommandList: Failed to create fence");
     
     VkCommandPoolCreateInfo poolInfo;
@@ -40,14 +46,14 @@ namespace dxvk {
     cmdInfoGfx.sType             = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     cmdInfoGfx.pNext             = nullptr;
     cmdInfoGfx.commandPool       = m_graphicsPool;
-    cmdInfoGfx.level             = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdInfoGfx.level             = m_level;
     cmdInfoGfx.commandBufferCount = 1;
     
     VkCommandBufferAllocateInfo cmdInfoDma;
     cmdInfoDma.sType             = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     cmdInfoDma.pNext             = nullptr;
     cmdInfoDma.commandPool       = m_transferPool ? m_transferPool : m_graphicsPool;
-    cmdInfoDma.level             = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdInfoDma.level             = m_level;
     cmdInfoDma.commandBufferCount = 1;
     
     if (m_vkd->vkAllocateCommandBuffers(m_vkd->device(), &cmdInfoGfx, &m_execBuffer) != VK_SUCCESS
@@ -55,7 +61,7 @@ namespace dxvk {
      || m_vkd->vkAllocateCommandBuffers(m_vkd->device(), &cmdInfoDma, &m_sdmaBuffer) != VK_SUCCESS)
       throw DxvkError("DxvkCommandList: Failed to allocate command buffer");
     
-    if (m_device->hasDedicatedTransferQueue()) {
+    if (m_device->hasDedicatedTransferQueue() && !isSecondary()) {
       VkSemaphoreCreateInfo semInfo;
       semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
       semInfo.pNext = nullptr;
@@ -136,11 +142,23 @@ namespace dxvk {
   
   
   void DxvkCommandList::beginRecording() {
+    // Secondary command buffers are always executed
+    // outside of a render pass and without any queries
+    VkCommandBufferInheritanceInfo inheritance;
+    inheritance.sType                = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.pNext                = nullptr;
+    inheritance.renderPass           = VK_NULL_HANDLE;
+    inheritance.subpass              = 0;
+    inheritance.framebuffer          = VK_NULL_HANDLE;
+    inheritance.occlusionQueryEnable = VK_FALSE;
+    inheritance.queryFlags           = 0;
+    inheritance.pipelineStatistics   = 0;
+
     VkCommandBufferBeginInfo info;
     info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     info.pNext            = nullptr;
-    info.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    info.pInheritanceInfo = nullptr;
+    info.flags            = m_usage;
+    info.pInheritanceInfo = isSecondary() ? &inheritance : nullptr;
     
     if ((m_graphicsPool && m_vkd->vkResetCommandPool(m_vkd->device(), m_graphicsPool, 0) != VK_SUCCESS)
      || (m_transferPool && m_vkd->vkResetCommandPool(m_vkd->device(), m_transferPool, 0) != VK_SUCCESS))
@@ -151,7 +169,7 @@ namespace dxvk {
      || m_vkd->vkBeginCommandBuffer(m_sdmaBuffer, &info) != VK_SUCCESS)
       Logger::err("DxvkCommandList: Failed to begin command buffer");
     
-    if (m_vkd->vkResetFences(m_vkd->device(), 1, &m_fence) != VK_SUCCESS)
+    if (m_fence && m_vkd->vkResetFences(m_vkd->device(), 1, &m_fence) != VK_SUCCESS)
       Logger::err("DxvkCommandList: Failed to reset fence");
     
     // Unconditionally mark the exec buffer as used. There
@@ -168,12 +186,74 @@ namespace dxvk {
   }
   
   
+  void DxvkCommandList::executeCommands(
+    const Rc<DxvkCommandList>&      cmdList) {
+    if (cmdList->m_cmdBuffersUsed.test(DxvkCmdBuffer::SdmaBuffer)) {
+      m_cmdBuffersUsed.set(DxvkCmdBuffer::SdmaBuffer);
+      m_vkd->vkCmdExecuteCommands(m_sdmaBuffer, 1, &cmdList->m_sdmaBuffer);
+    }
+
+    // Initialization commands of the secondary command list must
+    // not be moved ahead of any commands that were recorded into
+    // our exec buffer so far, so execute both in the exec buffer
+    std::array<VkCommandBuffer, 2> cmdBuffers;
+    uint32_t cmdBufferCount = 0;
+
+    if (cmdList->m_cmdBuffersUsed.test(DxvkCmdBuffer::InitBuffer))
+      cmdBuffers[cmdBufferCount++] = cmdList->m_initBuffer;
+    if (cmdList->m_cmdBuffersUsed.test(DxvkCmdBuffer::ExecBuffer))
+      cmdBuffers[cmdBufferCount++] = cmdList->m_execBuffer;
+
+    if (cmdBufferCount)
+      m_vkd->vkCmdExecuteCommands(m_execBuffer, cmdBufferCount, cmdBuffers.data());
+
+    m_statCounters.merge(cmdList->m_statCounters);
+
+    if (cmdList->isReusable())
+      m_resources.trackResources(cmdList->m_resources);
+    else
+      cmdList->m_statCounters.reset();
+
+    m_secondaryLists.push_back(cmdList);
+  }
+
+
+  bool DxvkCommandList::makeReusable() {
+    if (!isSecondary() || !(m_usage & VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT))
+      return false;
+
+    if (m_incomplete)
+      return false;
+
+    // Signals and returned buffer slices would only be
+    // handled once, and e.g. staging memory that gets
+    // retired via a signal will be overwritten later
+    if (!m_signalTracker.empty() || !m_bufferTracker.empty())
+      return false;
+
+    m_resources.detach();
+    m_reusable = true;
+    return true;
+  }
+
+
   void DxvkCommandList::reset() {
     // Signal resources and events to
     // avoid stalling main thread
     m_signalTracker.reset();
     m_resources.reset();
 
+    // Secondary command lists can be reused
+    // once this command list has completed
+    for (const auto& cmdList : m_secondaryLists) {
+      if (!cmdList->isReusable()) {
+        cmdList->reset();
+        m_device->recycleCommandList(cmdList);
+      }
+    }
+
+    m_secondaryLists.clear();
+
     // Recycle heavy Vulkan objects
     m_descriptorPoolTracker.reset();
 
@@ -186,6 +266,8 @@ namespace dxvk {
 
     // Less important stuff
     m_statCounters.reset();
+
+    m_incomplete = false;
   }
 
 
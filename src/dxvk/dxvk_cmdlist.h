@@ -60,9 +60,94 @@ namespace dxvk {
     
   public:
     
-    DxvkCommandList(DxvkDevice* device);
+    DxvkCommandList(
+            DxvkDevice*           device,
+            VkCommandBufferLevel  level,
+            VkCommandBufferUsageFlags usage);
+
     ~DxvkCommandList();
     
+    /**
+     * \brief Checks whether this is a secondary command list
+     *
+     * Secondary command lists cannot be submitted directly,
+     * they must be executed by a primary command list.
+     * \returns \c true for secondary command lists
+     */
+    bool isSecondary() const {
+      return m_level == VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    }
+
+    /**
+     * \brief Checks whether the command list is reusable
+     *
+     * Reusable command lists can be executed by any number
+     * of primary command lists, and are neither reset nor
+     * recycled when those complete.
+     * \returns \c true if \ref makeReusable succeeded
+     */
+    bool isReusable() const {
+      return m_reusable;
+    }
+
+    /**
+     * \brief Marks the command list as incomplete
+     *
+     * Must be called if commands could not be recorded as
+     * intended, e.g. because a draw was skipped while its
+     * pipeline was still being compiled, or used a pipeline
+     * that is still being optimized. Incomplete command
+     * lists cannot be made reusable.
+     */
+    void markIncomplete() {
+      m_incomplete = true;
+    }
+
+    /**
+     * \brief Checks whether the command list is incomplete
+     * \returns \c true if \ref markIncomplete was called
+     */
+    bool isIncomplete() const {
+      return m_incomplete;
+    }
+
+    /**
+     * \brief Makes a secondary command list reusable
+     *
+     * Must be called after recording has ended. Fails if
+     * the command list was not created for simultaneous
+     * use, if it is incomplete, or if it has any one-shot
+     * side effects, such as signals or buffer slices to
+     * return on completion.
+     * \returns \c true on success
+     */
+    bool makeReusable();
+
+    /**
+     * \brief Enables resource version tracking
+     *
+     * Must be called before recording a secondary command
+     * list that is executed some time after it has been
+     * recorded, so that \ref isOutdated can be used to
+     * check whether it is still valid.
+     */
+    void trackResourceVersions() {
+      m_resources.trackVersions();
+    }
+
+    /**
+     * \brief Checks whether a command list is outdated
+     *
+     * The command list must not be executed if the backing
+     * storage of any resource it uses has changed since it
+     * was made reusable, or since that resource was used
+     * if resource version tracking is enabled.
+     * \returns \c true if the command list is outdated
+     */
+    bool isOutdated() const {
+      return m_resources.hasChangedResources();
+    }
+
     /**
      * \brief Submits command list
      * 
@@ -102,7 +187,7 @@ namespace dxvk {
      * \param [in] ctr The counter to increment
      * \param [in] val The value to add
      */
-    void addStatCtr(DxvkStatCounter ctr, uint32_t val) {
+    void addStatCtr(DxvkStatCounter ctr, uint64_t val) {
       m_statCounters.addCtr(ctr, val);
     }
     
@@ -198,6 +283,9 @@ namespace dxvk {
      */
     void notifySignals() {
       m_signalTracker.notify();
+
+      for (const auto& cmdList : m_secondaryLists)
+        cmdList->notifySignals();
     }
     
     /**
@@ -210,6 +298,19 @@ namespace dxvk {
      */
     void reset();
     
+    /**
+     * \brief Executes a secondary command list
+     *
+     * Records the secondary command buffers into the
+     * corresponding command buffers of this command list.
+     * The secondary command list is kept alive and reset
+     * along with this command list, unless it is reusable,
+     * in which case only its resources are tracked again.
+     * \param [in] cmdList Secondary command list
+     */
+    void executeCommands(
+      const Rc<DxvkCommandList>&      cmdList);
+
     void updateDescriptorSets(
             uint32_t                      descriptorWriteCount,
       const VkWriteDescriptorSet*         pDescriptorWrites) {
@@ -774,7 +875,12 @@ namespace dxvk {
     Rc<vk::DeviceFn>    m_vkd;
     Rc<vk::InstanceFn>  m_vki;
     
-    VkFence             m_fence;
+    VkCommandBufferLevel m_level;
+    VkCommandBufferUsageFlags m_usage;
+    bool                m_reusable = false;
+    bool                m_incomplete = false;
+
+    VkFence             m_fence = VK_NULL_HANDLE;
     
     VkCommandPool       m_graphicsPool = VK_NULL_HANDLE;
     VkCommandPool       m_transferPool = VK_NULL_HANDLE;
@@ -794,6 +900,8 @@ namespace dxvk {
     DxvkBufferTracker   m_bufferTracker;
     DxvkStatCounters    m_statCounters;
 
+    std::vector<Rc<DxvkCommandList>> m_secondaryLists;
+
     VkCommandBuffer getCmdBuffer(DxvkCmdBuffer cmdBuffer) const {
       if (cmdBuffer == DxvkCmdBuffer::ExecBuffer) return m_execBuffer;
       if (cmdBuffer == DxvkCmdBuffer::InitBuffer) return m_initBuffer;
@@ -137,6 +137,7 @@ namespace dxvk {
       Logger::debug(str::format("DxvkComputePipeline: Finished in ", td.count(), " ms"));
     }
 
+    m_pipeMgr->m_cache->notifyPipelineCompiled();
     return pipeline;
   }
 
@@ -21,6 +21,11 @@ namespace dxvk {
       m_features.set(DxvkContextFeature::NullDescriptors);
     if (m_device->features().extExtendedDynamicState.extendedDynamicState)
       m_features.set(DxvkContextFeature::ExtendedDynamicState);
+
+    m_tracer = m_device->getCsTracer();
+
+    if (unlikely(m_tracer != nullptr))
+      m_traceId = m_tracer->registerContext();
   }
   
   
@@ -37,6 +42,65 @@ namespace dxvk {
     m_vbTracked.clear();
     m_rcTracked.clear();
     
+    this->resetCommandBufferState();
+  }
+  
+  
+  Rc<DxvkCommandList> DxvkContext::endRecording() {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSubmit(m_traceId);
+
+    // Secondary command lists get executed as part of another
+    // context's command list, which expects all render targets
+    // to be in their default layout, so end the render pass.
+    this->spillRenderPass(!m_cmd->isSecondary());
+    this->flushSharedImages();
+    this->relocateBuffers();
+
+    m_sdmaBarriers.recordCommands(m_cmd);
+    m_initBarriers.recordCommands(m_cmd);
+    m_execBarriers.recordCommands(m_cmd);
+
+    m_staging.endCommandList(m_cmd);
+
+    // Secondary command lists may be executed out of order or
+    // more than once, so they must own their descriptor sets
+    if (m_cmd->isSecondary() && m_descPool != nullptr)
+      m_cmd->trackDescriptorPool(std::move(m_descPool));
+
+    m_cmd->endRecording();
+    return std::exchange(m_cmd, nullptr);
+  }
+
+
+  void DxvkContext::flushCommandList() {
+    m_device->submitCommandList(
+      this->endRecording(),
+      VK_NULL_HANDLE,
+      VK_NULL_HANDLE);
+    
+    this->beginRecording(
+      m_device->createCommandList());
+  }
+  
+  
+  void DxvkContext::executeCommandList(
+    const Rc<DxvkCommandList>& cmdList) {
+    this->spillRenderPass(false);
+
+    m_sdmaBarriers.recordCommands(m_cmd);
+    m_initBarriers.recordCommands(m_cmd);
+    m_execBarriers.recordCommands(m_cmd);
+
+    m_cmd->executeCommands(cmdList);
+
+    // The state of the primary command buffer is
+    // undefined after executing secondary ones
+    this->resetCommandBufferState();
+  }
+  
+  
+  void DxvkContext::resetCommandBufferState() {
     // The current state of the internal command buffer is
     // undefined, so we have to bind and set up everything
     // before any draw or dispatch command is recorded.
@@ -48,6 +112,7 @@ namespace dxvk {
       DxvkContextFlag::GpDirtyFramebuffer,
       DxvkContextFlag::GpDirtyPipeline,
       DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyStateHash,
       DxvkContextFlag::GpDirtyResources,
       DxvkContextFlag::GpDirtyVertexBuffers,
       DxvkContextFlag::GpDirtyIndexBuffer,
@@ -64,30 +129,6 @@ namespace dxvk {
   }
   
   
-  Rc<DxvkCommandList> DxvkContext::endRecording() {
-    this->spillRenderPass(true);
-    this->flushSharedImages();
-
-    m_sdmaBarriers.recordCommands(m_cmd);
-    m_initBarriers.recordCommands(m_cmd);
-    m_execBarriers.recordCommands(m_cmd);
-
-    m_cmd->endRecording();
-    return std::exchange(m_cmd, nullptr);
-  }
-
-
-  void DxvkContext::flushCommandList() {
-    m_device->submitCommandList(
-      this->endRecording(),
-      VK_NULL_HANDLE,
-      VK_NULL_HANDLE);
-    
-    this->beginRecording(
-      m_device->createCommandList());
-  }
-  
-  
   void DxvkContext::beginQuery(const Rc<DxvkGpuQuery>& query) {
     m_queryManager.enableQuery(m_cmd, query);
   }
@@ -100,6 +141,9 @@ namespace dxvk {
   
   void DxvkContext::bindRenderTargets(
     const DxvkRenderTargets&    targets) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordBindRenderTargets(m_traceId, targets);
+
     // Set up default render pass ops
     m_state.om.renderTargets = targets;
     
@@ -122,6 +166,9 @@ namespace dxvk {
   void DxvkContext::bindDrawBuffers(
     const DxvkBufferSlice&      argBuffer,
     const DxvkBufferSlice&      cntBuffer) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordBindDrawBuffers(m_traceId, argBuffer, cntBuffer);
+
     m_state.id.argBuffer = argBuffer;
     m_state.id.cntBuffer = cntBuffer;
 
@@ -132,6 +179,9 @@ namespace dxvk {
   void DxvkContext::bindIndexBuffer(
     const DxvkBufferSlice&      buffer,
           VkIndexType           indexType) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordBindIndexBuffer(m_traceId, buffer, indexType);
+
     if (!m_state.vi.indexBuffer.matchesBuffer(buffer))
       m_vbTracked.clr(MaxNumVertexBindings);
 
@@ -145,6 +195,9 @@ namespace dxvk {
   void DxvkContext::bindResourceBuffer(
           uint32_t              slot,
     const DxvkBufferSlice&      buffer) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordBindResourceBuffer(m_traceId, slot, buffer);
+
     bool needsUpdate = !m_rc[slot].bufferSlice.matchesBuffer(buffer);
 
     if (likely(needsUpdate))
@@ -170,6 +223,9 @@ namespace dxvk {
           uint32_t              slot,
     const Rc<DxvkImageView>&    imageView,
     const Rc<DxvkBufferView>&   bufferView) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordBindResourceView(m_traceId, slot, imageView, bufferView);
+
     m_rc[slot].imageView   = imageView;
     m_rc[slot].bufferView  = bufferView;
     m_rc[slot].bufferSlice = bufferView != nullptr
@@ -186,6 +242,9 @@ namespace dxvk {
   void DxvkContext::bindResourceSampler(
           uint32_t              slot,
     const Rc<DxvkSampler>&      sampler) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordBindResourceSampler(m_traceId, slot, sampler);
+
     m_rc[slot].sampler = sampler;
     m_rcTracked.clr(slot);
 
@@ -198,6 +257,9 @@ namespace dxvk {
   void DxvkContext::bindShader(
           VkShaderStageFlagBits stage,
     const Rc<DxvkShader>&       shader) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordBindShader(m_traceId, stage, shader);
+
     Rc<DxvkShader>* shaderStage;
     
     switch (stage) {
@@ -230,6 +292,9 @@ namespace dxvk {
           uint32_t              binding,
     const DxvkBufferSlice&      buffer,
           uint32_t              stride) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordBindVertexBuffer(m_traceId, binding, buffer, stride);
+
     if (!m_state.vi.vertexBuffers[binding].matchesBuffer(buffer))
       m_vbTracked.clr(binding);
 
@@ -333,6 +398,9 @@ namespace dxvk {
           VkDeviceSize          offset,
           VkDeviceSize          length,
           uint32_t              value) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordClearBuffer(m_traceId, buffer, offset, length, value);
+
     this->spillRenderPass(true);
     
     length = align(length, sizeof(uint32_t));
@@ -575,6 +643,9 @@ namespace dxvk {
     const Rc<DxvkImageView>&    imageView,
           VkImageAspectFlags    clearAspects,
           VkClearValue          clearValue) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordClearRenderTarget(m_traceId, imageView, clearAspects, clearValue);
+
     // Make sure the color components are ordered correctly
     if (clearAspects & VK_IMAGE_ASPECT_COLOR_BIT) {
       clearValue.color = util::swizzleClearColor(clearValue.color,
@@ -632,6 +703,9 @@ namespace dxvk {
           VkExtent3D            extent,
           VkImageAspectFlags    aspect,
           VkClearValue          value) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordClearImageView(m_traceId, imageView, offset, extent, aspect, value);
+
     const VkImageUsageFlags viewUsage = imageView->info().usage;
 
     if (aspect & VK_IMAGE_ASPECT_COLOR_BIT) {
@@ -652,6 +726,10 @@ namespace dxvk {
     const Rc<DxvkBuffer>&       srcBuffer,
           VkDeviceSize          srcOffset,
           VkDeviceSize          numBytes) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordCopyBuffer(m_traceId,
+        dstBuffer, dstOffset, srcBuffer, srcOffset, numBytes);
+
     if (numBytes == 0)
       return;
     
@@ -794,6 +872,10 @@ namespace dxvk {
           VkImageSubresourceLayers srcSubresource,
           VkOffset3D            srcOffset,
           VkExtent3D            extent) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordCopyImage(m_traceId,
+        dstImage, dstSubresource, dstOffset, srcImage, srcSubresource, srcOffset, extent);
+
     this->spillRenderPass(true);
 
     if (this->copyImageClear(dstImage, dstSubresource, dstOffset, extent, srcImage, srcSubresource))
@@ -1417,11 +1499,14 @@ namespace dxvk {
 
   void DxvkContext::discardBuffer(
     const Rc<DxvkBuffer>&       buffer) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordDiscardBuffer(m_traceId, buffer);
+
     if (buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
       return;
 
     if (m_execBarriers.isBufferDirty(buffer->getSliceHandle(), DxvkAccess::Write))
-      this->invalidateBuffer(buffer, buffer->allocSlice());
+      this->invalidateBufferSlice(buffer, buffer->allocSlice(), false);
   }
 
 
@@ -1444,6 +1529,9 @@ namespace dxvk {
           uint32_t x,
           uint32_t y,
           uint32_t z) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordDispatch(m_traceId, x, y, z);
+
     if (this->commitComputeState()) {
       this->commitComputeInitBarriers();
 
@@ -1464,6 +1552,9 @@ namespace dxvk {
   
   void DxvkContext::dispatchIndirect(
           VkDeviceSize      offset) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordDispatchIndirect(m_traceId, offset);
+
     auto bufferSlice = m_state.id.argBuffer.getSliceHandle(
       offset, sizeof(VkDispatchIndirectCommand));
 
@@ -1503,6 +1594,10 @@ namespace dxvk {
           uint32_t instanceCount,
           uint32_t firstVertex,
           uint32_t firstInstance) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordDraw(m_traceId,
+        vertexCount, instanceCount, firstVertex, firstInstance);
+
     if (this->commitGraphicsState<false, false>()) {
       m_cmd->cmdDraw(
         vertexCount, instanceCount,
@@ -1517,6 +1612,9 @@ namespace dxvk {
           VkDeviceSize      offset,
           uint32_t          count,
           uint32_t          stride) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordDrawIndirect(m_traceId, offset, count, stride);
+
     if (this->commitGraphicsState<false, true>()) {
       auto descriptor = m_state.id.argBuffer.getDescriptor();
       
@@ -1557,6 +1655,10 @@ namespace dxvk {
           uint32_t firstIndex,
           uint32_t vertexOffset,
           uint32_t firstInstance) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordDrawIndexed(m_traceId,
+        indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+
     if (this->commitGraphicsState<true, false>()) {
       m_cmd->cmdDrawIndexed(
         indexCount, instanceCount,
@@ -1572,6 +1674,9 @@ namespace dxvk {
           VkDeviceSize      offset,
           uint32_t          count,
           uint32_t          stride) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordDrawIndexedIndirect(m_traceId, offset, count, stride);
+
     if (this->commitGraphicsState<true, true>()) {
       auto descriptor = m_state.id.argBuffer.getDescriptor();
       
@@ -1654,6 +1759,9 @@ namespace dxvk {
   void DxvkContext::generateMipmaps(
     const Rc<DxvkImageView>&        imageView,
           VkFilter                  filter) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordGenerateMipmaps(m_traceId, imageView, filter);
+
     if (imageView->info().numLevels <= 1)
       return;
     
@@ -1757,10 +1865,27 @@ namespace dxvk {
   
   void DxvkContext::invalidateBuffer(
     const Rc<DxvkBuffer>&           buffer,
-    const DxvkBufferSliceHandle&    slice) {
-    // Allocate new backing resource
-    DxvkBufferSliceHandle prevSlice = buffer->rename(slice);
-    m_cmd->freeBufferSlice(buffer, prevSlice);
+    const DxvkBufferSliceHandle&    slice,
+          bool                      external) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordInvalidateBuffer(m_traceId, buffer);
+
+    this->invalidateBufferSlice(buffer, slice, external);
+  }
+
+
+  void DxvkContext::invalidateBufferSlice(
+    const Rc<DxvkBuffer>&           buffer,
+    const DxvkBufferSliceHandle&    slice,
+          bool                      external) {
+    // Allocate new backing resource. External slices are
+    // not owned by the buffer and must not be returned.
+    bool prevExternal = buffer->hasExternalSlice();
+
+    DxvkBufferSliceHandle prevSlice = buffer->rename(slice, external);
+
+    if (!prevExternal)
+      m_cmd->freeBufferSlice(buffer, prevSlice);
     
     // We also need to update all bindings that the buffer
     // may be bound to either directly or through views.
@@ -1805,6 +1930,9 @@ namespace dxvk {
           uint32_t                  offset,
           uint32_t                  size,
     const void*                     data) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordPushConstants(m_traceId, offset, size, data);
+
     std::memcpy(&m_state.pc.data[offset], data, size);
 
     m_flags.set(DxvkContextFlag::DirtyPushConstants);
@@ -2136,11 +2264,17 @@ namespace dxvk {
           VkDeviceSize              offset,
           VkDeviceSize              size,
     const void*                     data) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordUpdateBuffer(m_traceId, buffer, offset, size, data);
+
     bool isHostVisible = buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 
+    // Replacing the buffer changes state that other contexts
+    // may access, so only do it for primary command lists
     bool replaceBuffer = (size == buffer->info().size)
                       && (size <= (1 << 20))
-                      && !isHostVisible;
+                      && !isHostVisible
+                      && !m_cmd->isSecondary();
     
     DxvkBufferSliceHandle bufferSlice;
     DxvkCmdBuffer         cmdBuffer;
@@ -2157,7 +2291,7 @@ namespace dxvk {
       bufferSlice = buffer->allocSlice();
       cmdBuffer   = DxvkCmdBuffer::InitBuffer;
 
-      this->invalidateBuffer(buffer, bufferSlice);
+      this->invalidateBufferSlice(buffer, bufferSlice, false);
     } else {
       this->spillRenderPass(true);
     
@@ -2181,20 +2315,7 @@ namespace dxvk {
         bufferSlice.length,
         data);
     } else {
-      auto stagingSlice  = m_staging.alloc(CACHE_LINE_SIZE, size);
-      auto stagingHandle = stagingSlice.getSliceHandle();
-
-      std::memcpy(stagingHandle.mapPtr, data, size);
-
-      VkBufferCopy region;
-      region.srcOffset = stagingHandle.offset;
-      region.dstOffset = bufferSlice.offset;
-      region.size      = size;
-
-      m_cmd->cmdCopyBuffer(cmdBuffer,
-        stagingHandle.handle, bufferSlice.handle, 1, &region);
-      
-      m_cmd->trackResource<DxvkAccess::Read>(stagingSlice.buffer());
+      this->copyBufferHostData(cmdBuffer, bufferSlice, data);
     }
 
     auto& barriers = replaceBuffer
@@ -2220,6 +2341,10 @@ namespace dxvk {
     const void*                     data,
           VkDeviceSize              pitchPerRow,
           VkDeviceSize              pitchPerLayer) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordUpdateImage(m_traceId,
+        image, subresources, imageOffset, imageExtent, data, pitchPerRow, pitchPerLayer);
+
     this->spillRenderPass(true);
 
     // Prepare the image layout. If the given extent covers
@@ -2311,19 +2436,13 @@ namespace dxvk {
   void DxvkContext::uploadBuffer(
     const Rc<DxvkBuffer>&           buffer,
     const void*                     data) {
-    auto bufferSlice = buffer->getSliceHandle();
-
-    auto stagingSlice = m_staging.alloc(CACHE_LINE_SIZE, bufferSlice.length);
-    auto stagingHandle = stagingSlice.getSliceHandle();
-    std::memcpy(stagingHandle.mapPtr, data, bufferSlice.length);
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordUploadBuffer(m_traceId, buffer, data);
 
-    VkBufferCopy region;
-    region.srcOffset = stagingHandle.offset;
-    region.dstOffset = bufferSlice.offset;
-    region.size      = bufferSlice.length;
+    auto bufferSlice = buffer->getSliceHandle();
 
-    m_cmd->cmdCopyBuffer(DxvkCmdBuffer::SdmaBuffer,
-      stagingHandle.handle, bufferSlice.handle, 1, &region);
+    this->copyBufferHostData(DxvkCmdBuffer::SdmaBuffer,
+      bufferSlice, data);
 
     m_sdmaBarriers.releaseBuffer(
       m_initBarriers, bufferSlice,
@@ -2333,8 +2452,7 @@ namespace dxvk {
       m_device->queues().graphics.queueFamily,
       buffer->info().stages,
       buffer->info().access);
-    
-    m_cmd->trackResource<DxvkAccess::Read>(stagingSlice.buffer());
+
     m_cmd->trackResource<DxvkAccess::Write>(buffer);
   }
 
@@ -2345,6 +2463,10 @@ namespace dxvk {
     const void*                     data,
           VkDeviceSize              pitchPerRow,
           VkDeviceSize              pitchPerLayer) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordUploadImage(m_traceId,
+        image, subresources, data, pitchPerRow, pitchPerLayer);
+
     VkOffset3D imageOffset = { 0, 0, 0 };
     VkExtent3D imageExtent = image->mipLevelExtent(subresources.mipLevel);
 
@@ -2401,9 +2523,14 @@ namespace dxvk {
           uint32_t            viewportCount,
     const VkViewport*         viewports,
     const VkRect2D*           scissorRects) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetViewports(m_traceId, viewportCount, viewports, scissorRects);
+
     if (m_state.gp.state.rs.viewportCount() != viewportCount) {
       m_state.gp.state.rs.setViewportCount(viewportCount);
-      m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+      m_flags.set(
+        DxvkContextFlag::GpDirtyPipelineState,
+        DxvkContextFlag::GpDirtyStateHash);
     }
     
     for (uint32_t i = 0; i < viewportCount; i++) {
@@ -2428,6 +2555,9 @@ namespace dxvk {
   
   void DxvkContext::setBlendConstants(
           DxvkBlendConstants  blendConstants) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetBlendConstants(m_traceId, blendConstants);
+
     if (m_state.dyn.blendConstants != blendConstants) {
       m_state.dyn.blendConstants = blendConstants;
       m_flags.set(DxvkContextFlag::GpDirtyBlendConstants);
@@ -2437,6 +2567,9 @@ namespace dxvk {
   
   void DxvkContext::setDepthBias(
           DxvkDepthBias       depthBias) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetDepthBias(m_traceId, depthBias);
+
     if (m_state.dyn.depthBias != depthBias) {
       m_state.dyn.depthBias = depthBias;
       m_flags.set(DxvkContextFlag::GpDirtyDepthBias);
@@ -2453,13 +2586,18 @@ namespace dxvk {
 
     if (m_state.gp.state.ds.enableDepthBoundsTest() != depthBounds.enableDepthBounds) {
       m_state.gp.state.ds.setEnableDepthBoundsTest(depthBounds.enableDepthBounds);
-      m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+      m_flags.set(
+        DxvkContextFlag::GpDirtyPipelineState,
+        DxvkContextFlag::GpDirtyStateHash);
     }
   }
   
   
   void DxvkContext::setStencilReference(
           uint32_t            reference) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetStencilReference(m_traceId, reference);
+
     if (m_state.dyn.stencilReference != reference) {
       m_state.dyn.stencilReference = reference;
       m_flags.set(DxvkContextFlag::GpDirtyStencilRef);
@@ -2468,12 +2606,17 @@ namespace dxvk {
   
   
   void DxvkContext::setInputAssemblyState(const DxvkInputAssemblyState& ia) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetInputAssemblyState(m_traceId, ia);
+
     m_state.gp.state.ia = DxvkIaInfo(
       ia.primitiveTopology,
       ia.primitiveRestart,
       ia.patchVertexCount);
     
-    m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+    m_flags.set(
+      DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyStateHash);
   }
   
   
@@ -2482,8 +2625,13 @@ namespace dxvk {
     const DxvkVertexAttribute* attributes,
           uint32_t             bindingCount,
     const DxvkVertexBinding*   bindings) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetInputLayout(m_traceId,
+        attributeCount, attributes, bindingCount, bindings);
+
     m_flags.set(
       DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyStateHash,
       DxvkContextFlag::GpDirtyVertexBuffers);
     
     for (uint32_t i = 0; i < attributeCount; i++) {
@@ -2509,6 +2657,9 @@ namespace dxvk {
   
   
   void DxvkContext::setRasterizerState(const DxvkRasterizerState& rs) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetRasterizerState(m_traceId, rs);
+
     m_state.gp.state.rs = DxvkRsInfo(
       rs.depthClipEnable,
       rs.depthBiasEnable,
@@ -2519,21 +2670,31 @@ namespace dxvk {
       rs.sampleCount,
       rs.conservativeMode);
 
-    m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+    m_flags.set(
+      DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyStateHash);
   }
   
   
   void DxvkContext::setMultisampleState(const DxvkMultisampleState& ms) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetMultisampleState(m_traceId, ms);
+
     m_state.gp.state.ms = DxvkMsInfo(
       m_state.gp.state.ms.sampleCount(),
       ms.sampleMask,
       ms.enableAlphaToCoverage);
     
-    m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+    m_flags.set(
+      DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyStateHash);
   }
   
   
   void DxvkContext::setDepthStencilState(const DxvkDepthStencilState& ds) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetDepthStencilState(m_traceId, ds);
+
     m_state.gp.state.ds = DxvkDsInfo(
       ds.enableDepthTest,
       ds.enableDepthWrite,
@@ -2544,22 +2705,32 @@ namespace dxvk {
     m_state.gp.state.dsFront = DxvkDsStencilOp(ds.stencilOpFront);
     m_state.gp.state.dsBack  = DxvkDsStencilOp(ds.stencilOpBack);
     
-    m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+    m_flags.set(
+      DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyStateHash);
   }
   
   
   void DxvkContext::setLogicOpState(const DxvkLogicOpState& lo) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetLogicOpState(m_traceId, lo);
+
     m_state.gp.state.om = DxvkOmInfo(
       lo.enableLogicOp,
       lo.logicOp);
     
-    m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+    m_flags.set(
+      DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyStateHash);
   }
   
   
   void DxvkContext::setBlendMode(
           uint32_t            attachment,
     const DxvkBlendMode&      blendMode) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetBlendMode(m_traceId, attachment, blendMode);
+
     m_state.gp.state.omBlend[attachment] = DxvkOmAttachmentBlend(
       blendMode.enableBlending,
       blendMode.colorSrcFactor,
@@ -2570,7 +2741,9 @@ namespace dxvk {
       blendMode.alphaBlendOp,
       blendMode.writeMask);
     
-    m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+    m_flags.set(
+      DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyStateHash);
   }
 
 
@@ -2578,6 +2751,9 @@ namespace dxvk {
           VkPipelineBindPoint pipeline,
           uint32_t            index,
           uint32_t            value) {
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordSetSpecConstant(m_traceId, pipeline, index, value);
+
     auto& specConst = pipeline == VK_PIPELINE_BIND_POINT_GRAPHICS
       ? m_state.gp.state.sc.specConstants[index]
       : m_state.cp.state.sc.specConstants[index];
@@ -2585,9 +2761,13 @@ namespace dxvk {
     if (specConst != value) {
       specConst = value;
 
-      m_flags.set(pipeline == VK_PIPELINE_BIND_POINT_GRAPHICS
-        ? DxvkContextFlag::GpDirtyPipelineState
-        : DxvkContextFlag::CpDirtyPipelineState);
+      if (pipeline == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+        m_flags.set(
+          DxvkContextFlag::GpDirtyPipelineState,
+          DxvkContextFlag::GpDirtyStateHash);
+      } else {
+        m_flags.set(DxvkContextFlag::CpDirtyPipelineState);
+      }
     }
   }
   
@@ -2995,28 +3175,161 @@ namespace dxvk {
         }
 
         auto blockCount = util::computeBlockCount(extent, formatInfo->blockSize);
-        auto stagingSlice  = m_staging.alloc(CACHE_LINE_SIZE, elementSize * util::flattenImageExtent(blockCount));
-        auto stagingHandle = stagingSlice.getSliceHandle();
-
-        util::packImageData(stagingHandle.mapPtr, layerData,
-          blockCount, elementSize, rowPitch, slicePitch);
+        auto dataSize = elementSize * util::flattenImageExtent(blockCount);
 
         auto subresource = imageSubresource;
         subresource.aspectMask = aspect;
+        subresource.baseArrayLayer += i;
+        subresource.layerCount = 1;
+
+        if (m_staging.needsStreaming(dataSize) && !formatInfo->flags.test(DxvkFormatFlag::MultiPlane) && !m_cmd->isSecondary()) {
+          this->streamImageHostData(cmd,
+            image, subresource, imageOffset, imageExtent,
+            layerData, rowPitch, slicePitch);
+        } else {
+          auto stagingSlice  = m_staging.alloc(CACHE_LINE_SIZE, dataSize);
+          auto stagingHandle = stagingSlice.getSliceHandle();
+
+          util::packImageData(stagingHandle.mapPtr, layerData,
+            blockCount, elementSize, rowPitch, slicePitch);
+
+          this->copyImageBufferData<true>(cmd,
+            image, subresource, imageOffset, imageExtent,
+            image->pickLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
+            stagingHandle, 0, 0);
+
+          m_cmd->trackResource<DxvkAccess::Read>(stagingSlice.buffer());
+        }
+
+        layerData += blockCount.height * rowPitch;
+      }
+    }
+  }
+
+
+  void DxvkContext::streamImageHostData(
+          DxvkCmdBuffer         cmd,
+    const Rc<DxvkImage>&        image,
+    const VkImageSubresourceLayers& imageSubresource,
+          VkOffset3D            imageOffset,
+          VkExtent3D            imageExtent,
+    const char*                 hostData,
+          VkDeviceSize          rowPitch,
+          VkDeviceSize          slicePitch) {
+    auto formatInfo = image->formatInfo();
+    auto blockSize  = formatInfo->blockSize;
+    auto blockCount = util::computeBlockCount(imageExtent, blockSize);
+
+    // Split the upload into pieces of whole slices if a
+    // slice fits into one chunk, or whole rows otherwise
+    VkDeviceSize rowSize   = formatInfo->elementSize * blockCount.width;
+    VkDeviceSize sliceSize = rowSize * blockCount.height;
+
+    VkExtent3D chunkBlocks = blockCount;
+
+    if (sliceSize > DxvkStagingDataAlloc::StreamChunkSize) {
+      chunkBlocks.height = uint32_t(std::max<VkDeviceSize>(DxvkStagingDataAlloc::StreamChunkSize / rowSize, 1));
+      chunkBlocks.depth  = 1;
+    } else {
+      chunkBlocks.depth  = uint32_t(DxvkStagingDataAlloc::StreamChunkSize / sliceSize);
+    }
+
+    for (uint32_t z = 0; z < blockCount.depth; z += chunkBlocks.depth) {
+      for (uint32_t y = 0; y < blockCount.height; y += chunkBlocks.height) {
+        VkExtent3D chunkCount = {
+          blockCount.width,
+          std::min(chunkBlocks.height, blockCount.height - y),
+          std::min(chunkBlocks.depth,  blockCount.depth  - z) };
+
+        VkOffset3D chunkOffset = {
+          imageOffset.x,
+          imageOffset.y + int32_t(y * blockSize.height),
+          imageOffset.z + int32_t(z * blockSize.depth) };
+
+        VkExtent3D chunkExtent = {
+          imageExtent.width,
+          std::min(chunkCount.height * blockSize.height, imageExtent.height - y * blockSize.height),
+          std::min(chunkCount.depth  * blockSize.depth,  imageExtent.depth  - z * blockSize.depth) };
+
+        auto stagingSlice  = this->allocStagingChunk(
+          formatInfo->elementSize * util::flattenImageExtent(chunkCount));
+        auto stagingHandle = stagingSlice.getSliceHandle();
+
+        util::packImageData(stagingHandle.mapPtr,
+          hostData + z * slicePitch + y * rowPitch, chunkCount,
+          formatInfo->elementSize, rowPitch, slicePitch);
 
         this->copyImageBufferData<true>(cmd,
-          image, subresource, imageOffset, imageExtent,
+          image, imageSubresource, chunkOffset, chunkExtent,
           image->pickLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
           stagingHandle, 0, 0);
 
-        layerData += blockCount.height * rowPitch;
-
         m_cmd->trackResource<DxvkAccess::Read>(stagingSlice.buffer());
       }
     }
   }
 
 
+  void DxvkContext::copyBufferHostData(
+          DxvkCmdBuffer         cmd,
+    const DxvkBufferSliceHandle& bufferSlice,
+    const void*                 hostData) {
+    auto srcData = reinterpret_cast<const char*>(hostData);
+
+    // Large uploads are streamed in pieces so that they do not
+    // need a dedicated staging buffer. Streaming may need to
+    // submit the command list, which secondary ones cannot do.
+    bool streaming = m_staging.needsStreaming(bufferSlice.length)
+                  && !m_cmd->isSecondary();
+
+    VkDeviceSize chunkSize = streaming
+      ? DxvkStagingDataAlloc::StreamChunkSize
+      : bufferSlice.length;
+
+    for (VkDeviceSize offset = 0; offset < bufferSlice.length; offset += chunkSize) {
+      VkDeviceSize size = std::min(chunkSize, bufferSlice.length - offset);
+
+      auto stagingSlice = streaming
+        ? this->allocStagingChunk(size)
+        : m_staging.alloc(CACHE_LINE_SIZE, size);
+      auto stagingHandle = stagingSlice.getSliceHandle();
+
+      std::memcpy(stagingHandle.mapPtr, srcData + offset, size);
+
+      VkBufferCopy region;
+      region.srcOffset = stagingHandle.offset;
+      region.dstOffset = bufferSlice.offset + offset;
+      region.size      = size;
+
+      m_cmd->cmdCopyBuffer(cmd,
+        stagingHandle.handle, bufferSlice.handle, 1, &region);
+
+      m_cmd->trackResource<DxvkAccess::Read>(stagingSlice.buffer());
+    }
+  }
+
+
+  DxvkBufferSlice DxvkContext::allocStagingChunk(
+          VkDeviceSize          size) {
+    auto slice = m_staging.allocStream(CACHE_LINE_SIZE, size);
+
+    if (!slice.defined()) {
+      // The current command list holds its share of the staging
+      // window, submit it so that the GPU can start copying data
+      this->flushCommandList();
+
+      slice = m_staging.allocStream(CACHE_LINE_SIZE, size);
+
+      // This should not fail after a flush, but make
+      // sure that callers always get a usable slice
+      if (unlikely(!slice.defined()))
+        slice = m_staging.alloc(CACHE_LINE_SIZE, size);
+    }
+
+    return slice;
+  }
+
+
   void DxvkContext::clearImageViewFb(
     const Rc<DxvkImageView>&    imageView,
           VkOffset3D            offset,
@@ -4174,7 +4487,19 @@ namespace dxvk {
     // Set up vertex buffer strides for active bindings
     for (uint32_t i = 0; i < m_state.gp.state.il.bindingCount(); i++) {
       const uint32_t binding = m_state.gp.state.ilBindings[i].binding();
-      m_state.gp.state.ilBindings[i].setStride(m_state.vi.vertexStrides[binding]);
+      const uint32_t stride  = m_state.vi.vertexStrides[binding];
+
+      if (m_state.gp.state.ilBindings[i].stride() != stride) {
+        m_state.gp.state.ilBindings[i].setStride(stride);
+        m_flags.set(DxvkContextFlag::GpDirtyStateHash);
+      }
+    }
+
+    // Only rehash the state vector if it actually changed, since
+    // the pipeline may be dirty only because shaders were changed
+    if (m_flags.test(DxvkContextFlag::GpDirtyStateHash)) {
+      m_state.gp.stateHash = m_state.gp.state.hash();
+      m_flags.clr(DxvkContextFlag::GpDirtyStateHash);
     }
     
     // Check which dynamic states need to be active. States that
@@ -4201,10 +4526,21 @@ namespace dxvk {
       : DxvkContextFlag::GpDirtyStencilRef);
     
     // Retrieve and bind actual Vulkan pipeline handle
-    m_gpActivePipeline = m_state.gp.pipeline->getPipelineHandle(m_state.gp.state, m_state.om.framebuffer->getRenderPass());
+    bool optimizing = false;
 
-    if (unlikely(!m_gpActivePipeline))
+    m_gpActivePipeline = m_state.gp.pipeline->getPipelineHandle(m_state.gp.state,
+      m_state.gp.stateHash, m_state.om.framebuffer->getRenderPass(), optimizing);
+
+    if (unlikely(!m_gpActivePipeline)) {
+      m_cmd->addStatCtr(DxvkStatCounter::CmdDrawsSkipped, 1);
+      m_cmd->markIncomplete();
       return false;
+    }
+
+    // Command lists that get reused must not keep
+    // using the pipeline once it has been optimized
+    if (unlikely(optimizing))
+      m_cmd->markIncomplete();
 
     m_cmd->cmdBindPipeline(
       VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -4345,8 +4681,10 @@ namespace dxvk {
           if (res.bufferSlice.defined()) {
             descriptors[i] = res.bufferSlice.getDescriptor();
             
-            if (m_rcTracked.set(binding.slot))
+            if (m_rcTracked.set(binding.slot)) {
               m_cmd->trackResource<DxvkAccess::Read>(res.bufferSlice.buffer());
+              this->checkRelocation(res.bufferSlice.buffer());
+            }
           } else {
             bindMask.clr(i);
             descriptors[i].buffer = m_common->dummyResources().bufferDescriptor();
@@ -4356,8 +4694,10 @@ namespace dxvk {
           if (res.bufferSlice.defined()) {
             descriptors[i] = res.bufferSlice.getDescriptor();
             
-            if (m_rcTracked.set(binding.slot))
+            if (m_rcTracked.set(binding.slot)) {
               m_cmd->trackResource<DxvkAccess::Write>(res.bufferSlice.buffer());
+              this->checkRelocation(res.bufferSlice.buffer());
+            }
           } else {
             bindMask.clr(i);
             descriptors[i].buffer = m_common->dummyResources().bufferDescriptor();
@@ -4368,8 +4708,10 @@ namespace dxvk {
             descriptors[i] = res.bufferSlice.getDescriptor();
             descriptors[i].buffer.offset = 0;
             
-            if (m_rcTracked.set(binding.slot))
+            if (m_rcTracked.set(binding.slot)) {
               m_cmd->trackResource<DxvkAccess::Read>(res.bufferSlice.buffer());
+              this->checkRelocation(res.bufferSlice.buffer());
+            }
           } else {
             bindMask.clr(i);
             descriptors[i].buffer = m_common->dummyResources().bufferDescriptor();
@@ -4402,9 +4744,13 @@ namespace dxvk {
     if (refMask != bindMask) {
       refMask = bindMask;
 
-      m_flags.set(BindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS
-        ? DxvkContextFlag::GpDirtyPipelineState
-        : DxvkContextFlag::CpDirtyPipelineState);
+      if (BindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+        m_flags.set(
+          DxvkContextFlag::GpDirtyPipelineState,
+          DxvkContextFlag::GpDirtyStateHash);
+      } else {
+        m_flags.set(DxvkContextFlag::CpDirtyPipelineState);
+      }
     }
   }
   
@@ -4455,7 +4801,9 @@ namespace dxvk {
         m_state.gp.state.omSwizzle[i] = DxvkOmAttachmentSwizzle(mapping);
       }
 
-      m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
+      m_flags.set(
+        DxvkContextFlag::GpDirtyPipelineState,
+        DxvkContextFlag::GpDirtyStateHash);
     }
   }
 
@@ -4656,8 +5004,10 @@ namespace dxvk {
       bufferInfo.buffer.offset,
       m_state.vi.indexType);
 
-    if (m_vbTracked.set(MaxNumVertexBindings))
+    if (m_vbTracked.set(MaxNumVertexBindings)) {
       m_cmd->trackResource<DxvkAccess::Read>(m_state.vi.indexBuffer.buffer());
+      this->checkRelocation(m_state.vi.indexBuffer.buffer());
+    }
 
     return true;
   }
@@ -4684,8 +5034,10 @@ namespace dxvk {
         offsets[i] = vbo.buffer.offset;
         lengths[i] = vbo.buffer.range;
         
-        if (m_vbTracked.set(binding))
+        if (m_vbTracked.set(binding)) {
           m_cmd->trackResource<DxvkAccess::Read>(m_state.vi.vertexBuffers[binding].buffer());
+          this->checkRelocation(m_state.vi.vertexBuffers[binding].buffer());
+        }
       } else if (m_features.test(DxvkContextFeature::NullDescriptors)) {
         buffers[i] = VK_NULL_HANDLE;
         offsets[i] = 0;
@@ -5338,5 +5690,72 @@ namespace dxvk {
     m_execBarriers.recordCommands(m_cmd);
     return m_zeroBuffer;
   }
+
+
+  void DxvkContext::queueRelocation(
+    const Rc<DxvkBuffer>&           buffer) {
+    for (const auto& entry : m_relocations) {
+      if (entry == buffer)
+        return;
+    }
+
+    // Relocations are copied at the end of the command list,
+    // so limit the amount of data to move at once. Always
+    // allow at least one buffer so that large buffers
+    // do not prevent the chunk from being evacuated.
+    VkDeviceSize size = buffer->info().size;
+
+    if (!m_relocations.empty() && m_relocationSize + size > MaxRelocationSize)
+      return;
+
+    m_relocations.push_back(buffer);
+    m_relocationSize += size;
+  }
+
+
+  void DxvkContext::relocateBuffers() {
+    for (const auto& buffer : m_relocations) {
+      auto srcSlice = buffer->getSliceHandle();
+
+      DxvkBufferHandle oldHandle = buffer->relocate();
+
+      if (!oldHandle.buffer)
+        continue;
+
+      auto dstSlice = buffer->getSliceHandle();
+
+      if (m_execBarriers.isBufferDirty(srcSlice, DxvkAccess::Read))
+        m_execBarriers.recordCommands(m_cmd);
+
+      VkBufferCopy bufferRegion;
+      bufferRegion.srcOffset = srcSlice.offset;
+      bufferRegion.dstOffset = dstSlice.offset;
+      bufferRegion.size      = dstSlice.length;
+
+      m_cmd->cmdCopyBuffer(DxvkCmdBuffer::ExecBuffer,
+        srcSlice.handle, dstSlice.handle, 1, &bufferRegion);
+
+      m_execBarriers.accessBuffer(srcSlice,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        buffer->info().stages,
+        buffer->info().access);
+
+      m_execBarriers.accessBuffer(dstSlice,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        buffer->info().stages,
+        buffer->info().access);
+
+      // Keep the old backing buffer alive until the
+      // GPU is done with all commands that use it
+      m_cmd->trackResource<DxvkAccess::Write>(buffer);
+      m_cmd->trackResource<DxvkAccess::None>(
+        new DxvkRetiredBuffer(m_device->vkd(), std::move(oldHandle)));
+    }
+
+    m_relocations.clear();
+    m_relocationSize = 0;
+  }
   
 }
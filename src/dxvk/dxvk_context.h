@@ -9,6 +9,8 @@
 #include "dxvk_util.h"
 
 namespace dxvk {
+
+  class DxvkCsTracer;
   
   /**
    * \brief DXVk context
@@ -18,7 +20,7 @@ namespace dxvk {
    * recorded.
    */
   class DxvkContext : public RcObject {
-    
+    constexpr static VkDeviceSize MaxRelocationSize = 16 << 20;
   public:
     
     DxvkContext(const Rc<DxvkDevice>& device);
@@ -56,6 +58,20 @@ namespace dxvk {
      */
     void flushCommandList();
     
+    /**
+     * \brief Executes a secondary command list
+     *
+     * Ends the current render pass and flushes all pending
+     * barriers, so that the secondary command list starts
+     * with all images in their default layout, and records
+     * its command buffers into the active command list.
+     * The secondary command list must have been recorded
+     * by another context.
+     * \param [in] cmdList Secondary command list
+     */
+    void executeCommandList(
+      const Rc<DxvkCommandList>& cmdList);
+
     /**
      * \brief Begins generating query data
      * \param [in] query The query to end
@@ -698,10 +714,14 @@ namespace dxvk {
      * invalidating it will result in undefined behaviour.
      * \param [in] buffer The buffer to invalidate
      * \param [in] slice New buffer slice handle
+     * \param [in] external Whether the slice was allocated
+     *    from another buffer, e.g. an upload ring, rather
+     *    than by the buffer's own \c allocSlice method
      */
     void invalidateBuffer(
       const Rc<DxvkBuffer>&           buffer,
-      const DxvkBufferSliceHandle&    slice);
+      const DxvkBufferSliceHandle&    slice,
+            bool                      external = false);
     
     /**
      * \brief Updates push constants
@@ -1015,6 +1035,19 @@ namespace dxvk {
       const Rc<sync::Signal>&   signal,
             uint64_t            value);
     
+    /**
+     * \brief Increments a stat counter
+     * 
+     * The value will be added to the device's
+     * counters once the current command list
+     * gets submitted.
+     * \param [in] ctr The counter
+     * \param [in] val Value to add
+     */
+    void addStatCtr(DxvkStatCounter ctr, uint64_t val) {
+      m_cmd->addStatCtr(ctr, val);
+    }
+    
     /**
      * \brief Trims staging buffers
      * 
@@ -1072,6 +1105,9 @@ namespace dxvk {
     
     DxvkGpuQueryManager     m_queryManager;
     DxvkStagingDataAlloc    m_staging;
+
+    DxvkCsTracer*           m_tracer  = nullptr;
+    uint32_t                m_traceId = 0;
     
     DxvkRenderTargetLayouts m_rtLayouts = { };
 
@@ -1086,10 +1122,15 @@ namespace dxvk {
 
     std::vector<DxvkDeferredClear> m_deferredClears;
 
+    std::vector<Rc<DxvkBuffer>>   m_relocations;
+    VkDeviceSize                  m_relocationSize = 0;
+
     std::array<DxvkShaderResourceSlot, MaxNumResourceSlots>  m_rc;
     std::array<DxvkGraphicsPipeline*, 4096> m_gpLookupCache = { };
     std::array<DxvkComputePipeline*,   256> m_cpLookupCache = { };
 
+    void resetCommandBufferState();
+
     void blitImageFb(
       const Rc<DxvkImage>&        dstImage,
       const Rc<DxvkImage>&        srcImage,
@@ -1125,6 +1166,24 @@ namespace dxvk {
             VkDeviceSize          rowPitch,
             VkDeviceSize          slicePitch);
 
+    void streamImageHostData(
+            DxvkCmdBuffer         cmd,
+      const Rc<DxvkImage>&        image,
+      const VkImageSubresourceLayers& imageSubresource,
+            VkOffset3D            imageOffset,
+            VkExtent3D            imageExtent,
+      const char*                 hostData,
+            VkDeviceSize          rowPitch,
+            VkDeviceSize          slicePitch);
+
+    void copyBufferHostData(
+            DxvkCmdBuffer         cmd,
+      const DxvkBufferSliceHandle& bufferSlice,
+      const void*                 hostData);
+
+    DxvkBufferSlice allocStagingChunk(
+            VkDeviceSize          size);
+
     void clearImageViewFb(
       const Rc<DxvkImageView>&    imageView,
             VkOffset3D            offset,
@@ -1200,6 +1259,11 @@ namespace dxvk {
       const Rc<DxvkImageView>&        imageView,
             VkImageAspectFlags        discardAspects);
 
+    void invalidateBufferSlice(
+      const Rc<DxvkBuffer>&           buffer,
+      const DxvkBufferSliceHandle&    slice,
+            bool                      external);
+
     void flushClears(
             bool                      useRenderPass);
 
@@ -1335,6 +1399,16 @@ namespace dxvk {
     Rc<DxvkBuffer> createZeroBuffer(
             VkDeviceSize              size);
 
+    void queueRelocation(
+      const Rc<DxvkBuffer>&           buffer);
+
+    void relocateBuffers();
+
+    void checkRelocation(const Rc<DxvkBuffer>& buffer) {
+      if (unlikely(buffer->needsRelocation()))
+        this->queueRelocation(buffer);
+    }
+
   };
   
 }
@@ -27,6 +27,7 @@ namespace dxvk {
     GpDirtyFramebuffer,         ///< Framebuffer binding is out of date
     GpDirtyPipeline,            ///< Graphics pipeline binding is out of date
     GpDirtyPipelineState,       ///< Graphics pipeline needs to be recompiled
+    GpDirtyStateHash,           ///< Graphics pipeline state vector has changed
     GpDirtyResources,           ///< Graphics pipeline resource bindings are out of date
     GpDirtyDescriptorBinding,   ///< Graphics descriptor set needs to be rebound
     GpDirtyVertexBuffers,       ///< Vertex buffer bindings are out of date
@@ -123,6 +124,7 @@ namespace dxvk {
   struct DxvkGraphicsPipelineState {
     DxvkGraphicsPipelineShaders   shaders;
     DxvkGraphicsPipelineStateInfo state;
+    size_t                        stateHash = 0;
     DxvkGraphicsPipelineFlags     flags;
     DxvkGraphicsPipeline*         pipeline = nullptr;
   };
@@ -18,6 +18,14 @@ namespace dxvk {
 
 
   void DxvkCsChunk::executeAll(DxvkContext* ctx) {
+    if (m_flags.test(DxvkCsChunkFlag::ElideState)) {
+      if (!m_stateElided)
+        this->elideState();
+
+      if (m_skippedCount)
+        ctx->addStatCtr(DxvkStatCounter::CsCmdsSkipped, m_skippedCount);
+    }
+
     auto cmd = m_head;
     
     if (m_flags.test(DxvkCsChunkFlag::SingleUse)) {
@@ -25,19 +33,65 @@ namespace dxvk {
       
       while (cmd != nullptr) {
         auto next = cmd->next();
-        cmd->exec(ctx);
+
+        if (likely(!cmd->isSkipped()))
+          this->execute(ctx, cmd);
+
         cmd->~DxvkCsCmd();
         cmd = next;
       }
 
       m_head = nullptr;
       m_tail = nullptr;
+
+      m_stateElided  = false;
+      m_skippedCount = 0;
     } else {
       while (cmd != nullptr) {
-        cmd->exec(ctx);
+        if (likely(!cmd->isSkipped()))
+          this->execute(ctx, cmd);
+
         cmd = cmd->next();
       }
     }
+
+#ifdef DXVK_CS_PROFILING
+    DxvkCsProfiler::instance().dumpPeriodic(dxvk::high_resolution_clock::now());
+#endif
+  }
+
+
+  void DxvkCsChunk::elideState() {
+    constexpr uint32_t MaxStateCount = 64;
+
+    // Most recent command for each piece of state that
+    // was set since the last command that may use state
+    std::array<DxvkCsCmd*, MaxStateCount> stateCmds;
+    uint32_t stateCount = 0;
+
+    for (auto cmd = m_head; cmd != nullptr; cmd = cmd->next()) {
+      uint32_t key = cmd->stateKey();
+
+      if (!key) {
+        stateCount = 0;
+        continue;
+      }
+
+      uint32_t index = 0;
+
+      while (index < stateCount && stateCmds[index]->stateKey() != key)
+        index += 1;
+
+      if (index < stateCount) {
+        stateCmds[index]->skip();
+        stateCmds[index] = cmd;
+        m_skippedCount += 1;
+      } else if (stateCount < MaxStateCount) {
+        stateCmds[stateCount++] = cmd;
+      }
+    }
+
+    m_stateElided = true;
   }
   
   
@@ -54,6 +108,9 @@ namespace dxvk {
     m_tail = nullptr;
 
     m_commandOffset = 0;
+
+    m_stateElided  = false;
+    m_skippedCount = 0;
   }
   
   
@@ -96,7 +153,8 @@ namespace dxvk {
   
   
   DxvkCsThread::DxvkCsThread(const Rc<DxvkContext>& context)
-  : m_context(context), m_thread([this] { threadFunc(); }) {
+  : m_context(context), m_chunksQueued(QueueSize),
+    m_thread([this] { threadFunc(); }) {
     
   }
   
@@ -111,55 +169,100 @@ namespace dxvk {
   }
   
   
-  void DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
-    { std::lock_guard<dxvk::mutex> lock(m_mutex);
-      m_chunksQueued.push(std::move(chunk));
-      m_chunksPending += 1;
+  uint64_t DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
+    uint64_t seq = ++m_chunksDispatched;
+
+    // If the queue is full, wait for the worker to
+    // catch up. The chunk is only moved on success.
+    while (unlikely(!m_chunksQueued.push(std::move(chunk)))) {
+      this->waitForWorker([this, seq] {
+        return seq - m_chunksExecuted.load() <= m_chunksQueued.capacity();
+      });
     }
-    
-    m_condOnAdd.notify_one();
+
+    // Pairs with the fence in dequeueChunk, so that either
+    // we see the parked flag or the worker sees the chunk
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_consumerParked.load()) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_condOnAdd.notify_one();
+    }
+
+    return seq;
   }
   
   
-  void DxvkCsThread::synchronize() {
-    std::unique_lock<dxvk::mutex> lock(m_mutex);
-    
-    m_condOnSync.wait(lock, [this] {
-      return !m_chunksPending.load();
+  void DxvkCsThread::synchronize(uint64_t seq) {
+    seq = std::min(seq, m_chunksDispatched);
+
+    this->waitForWorker([this, seq] {
+      return m_chunksExecuted.load() >= seq;
     });
   }
   
   
+  bool DxvkCsThread::dequeueChunk(DxvkCsChunkRef& chunk) {
+    // Spin for a short while before going to sleep, since
+    // the application will likely submit more work soon
+    for (uint32_t i = 0; i < SpinCount; i++) {
+      if (m_chunksQueued.pop(chunk))
+        return true;
+
+      _mm_pause();
+    }
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+    m_consumerParked.store(true);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    m_condOnAdd.wait(lock, [this, &chunk] {
+      return m_chunksQueued.pop(chunk)
+          || m_stopped.load();
+    });
+
+    m_consumerParked.store(false);
+    return bool(chunk);
+  }
+
+
+  template<typename Pred>
+  void DxvkCsThread::waitForWorker(const Pred& pred) {
+    for (uint32_t i = 0; i < SpinCount; i++) {
+      if (pred())
+        return;
+
+      _mm_pause();
+    }
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+    m_producerParked.store(true);
+
+    m_condOnSync.wait(lock, pred);
+
+    m_producerParked.store(false);
+  }
+
+
   void DxvkCsThread::threadFunc() {
     env::setThreadName("dxvk-cs");
 
     DxvkCsChunkRef chunk;
 
     try {
-      while (!m_stopped.load()) {
-        { std::unique_lock<dxvk::mutex> lock(m_mutex);
-          if (chunk) {
-            if (--m_chunksPending == 0)
-              m_condOnSync.notify_one();
-            
-            chunk = DxvkCsChunkRef();
-          }
-          
-          if (m_chunksQueued.size() == 0) {
-            m_condOnAdd.wait(lock, [this] {
-              return (m_chunksQueued.size() != 0)
-                  || (m_stopped.load());
-            });
-          }
-          
-          if (m_chunksQueued.size() != 0) {
-            chunk = std::move(m_chunksQueued.front());
-            m_chunksQueued.pop();
-          }
+      while (!m_stopped.load() && dequeueChunk(chunk)) {
+        chunk->executeAll(m_context.ptr());
+        chunk = DxvkCsChunkRef();
+
+        // Both operations are sequentially consistent, so either
+        // the waiting thread sees the new count or we see the flag
+        m_chunksExecuted += 1;
+
+        if (m_producerParked.load()) {
+          std::lock_guard<dxvk::mutex> lock(m_mutex);
+          m_condOnSync.notify_one();
         }
-        
-        if (chunk)
-          chunk->executeAll(m_context.ptr());
       }
     } catch (const DxvkError& e) {
       Logger::err("Exception on CS thread!");
@@ -167,4 +270,4 @@ namespace dxvk {
     }
   }
   
-}
\ No newline at end of file
+}
@@ -8,8 +8,86 @@
 #include "../util/thread.h"
 #include "dxvk_context.h"
 
+#ifdef DXVK_CS_PROFILING
+#include "dxvk_cs_profiler.h"
+#endif
+
 namespace dxvk {
-  
+
+#ifdef DXVK_CS_PROFILING
+  /**
+   * \brief CS command tag
+   *
+   * Name of the function that emitted a command.
+   */
+  using DxvkCsTag = const char*;
+
+  #define DXVK_CS_TAG() __builtin_FUNCTION()
+#else
+  /**
+   * \brief CS command tag
+   *
+   * Empty unless CS profiling is enabled.
+   */
+  struct DxvkCsTag { };
+
+  #define DXVK_CS_TAG() DxvkCsTag()
+#endif
+
+  /**
+   * \brief State classes for CS commands
+   *
+   * Used to tag commands that do nothing but set a
+   * piece of context state, and which fully replace
+   * whatever a previous command of the same class
+   * and slot has set.
+   */
+  enum class DxvkCsStateClass : uint32_t {
+    None,
+    InputLayout,
+    InputAssembly,
+    BlendState,
+    BlendConstants,
+    DepthStencilState,
+    StencilReference,
+    RasterizerState,
+    Viewports,
+    Shader,
+    VertexBuffer,
+    IndexBuffer,
+    ResourceBuffer,
+    ResourceView,
+    ResourceSampler,
+  };
+
+
+  /**
+   * \brief State key for CS commands
+   *
+   * Identifies the state class and slot that a
+   * command sets. Commands with the default key
+   * may use any state, and are never skipped.
+   */
+  class DxvkCsStateKey {
+
+  public:
+
+    DxvkCsStateKey() { }
+
+    DxvkCsStateKey(DxvkCsStateClass stateClass, uint32_t slot = 0)
+    : m_key((uint32_t(stateClass) << 24) | slot) { }
+
+    uint32_t raw() const {
+      return m_key;
+    }
+
+  private:
+
+    uint32_t m_key = 0;
+
+  };
+
+
   /**
    * \brief Command stream operation
    * 
@@ -41,6 +119,58 @@ namespace dxvk {
       m_next = next;
     }
     
+    /**
+     * \brief Retrieves state key
+     * \returns Raw state key, or 0 if the
+     *    command is not a state command
+     */
+    uint32_t stateKey() const {
+      return m_stateKey;
+    }
+
+    /**
+     * \brief Sets state key
+     * \param [in] key State key
+     */
+    void setStateKey(DxvkCsStateKey key) {
+      m_stateKey = key.raw();
+    }
+
+    /**
+     * \brief Checks whether the command is skipped
+     * \returns \c true if the command has no effect
+     */
+    bool isSkipped() const {
+      return m_skip;
+    }
+
+    /**
+     * \brief Marks the command as skipped
+     */
+    void skip() {
+      m_skip = true;
+    }
+    
+#ifdef DXVK_CS_PROFILING
+    /**
+     * \brief Retrieves profiling tag
+     * \returns Tag of the emitting function
+     */
+    const char* tag() const {
+      return m_tag;
+    }
+#endif
+
+    /**
+     * \brief Sets profiling tag
+     * \param [in] tag Command tag
+     */
+    void setTag(DxvkCsTag tag) {
+#ifdef DXVK_CS_PROFILING
+      m_tag = tag;
+#endif
+    }
+    
     /**
      * \brief Executes embedded commands
      * \param [in] ctx The target context
@@ -49,7 +179,12 @@ namespace dxvk {
     
   private:
     
-    DxvkCsCmd* m_next = nullptr;
+    DxvkCsCmd* m_next     = nullptr;
+    uint32_t   m_stateKey = 0;
+    bool       m_skip     = false;
+#ifdef DXVK_CS_PROFILING
+    const char* m_tag     = nullptr;
+#endif
     
   };
   
@@ -125,6 +260,9 @@ namespace dxvk {
     /// Indicates that the submitted chunk will
     /// no longer be needed after one submission.
     SingleUse,
+    /// Skip state commands that are overwritten
+    /// before any other command is executed.
+    ElideState,
   };
 
   using DxvkCsChunkFlags = Flags<DxvkCsChunkFlag>;
@@ -157,11 +295,13 @@ namespace dxvk {
      * will be consumed. Otherwise, a new chunk must be
      * created which is large enough to hold the command.
      * \param [in] command The command to add
+     * \param [in] key State key of the command
+     * \param [in] tag Profiling tag of the command
      * \returns \c true on success, \c false if
      *          a new chunk needs to be allocated
      */
     template<typename T>
-    bool push(T& command) {
+    bool push(T& command, DxvkCsStateKey key = DxvkCsStateKey(), DxvkCsTag tag = DxvkCsTag()) {
       using FuncType = DxvkCsTypedCmd<T>;
       
       if (unlikely(m_commandOffset > MaxBlockSize - sizeof(FuncType)))
@@ -171,6 +311,8 @@ namespace dxvk {
       
       m_tail = new (m_data + m_commandOffset)
         FuncType(std::move(command));
+      m_tail->setStateKey(key);
+      m_tail->setTag(tag);
       
       if (likely(tail != nullptr))
         tail->setNext(m_tail);
@@ -185,11 +327,12 @@ namespace dxvk {
      * \brief Adds a command with data to the chunk 
      * 
      * \param [in] command The command to add
+     * \param [in] tag Profiling tag of the command
      * \param [in] args Constructor args for the data object
      * \returns Pointer to the data object, or \c nullptr
      */
     template<typename M, typename T, typename... Args>
-    M* pushCmd(T& command, Args&&... args) {
+    M* pushCmd(T& command, DxvkCsTag tag, Args&&... args) {
       using FuncType = DxvkCsDataCmd<T, M>;
       
       if (unlikely(m_commandOffset > MaxBlockSize - sizeof(FuncType)))
@@ -197,6 +340,7 @@ namespace dxvk {
       
       FuncType* func = new (m_data + m_commandOffset)
         FuncType(std::move(command), std::forward<Args>(args)...);
+      func->setTag(tag);
       
       if (likely(m_tail != nullptr))
         m_tail->setNext(func);
@@ -240,6 +384,24 @@ namespace dxvk {
     DxvkCsCmd* m_tail = nullptr;
 
     DxvkCsChunkFlags m_flags;
+
+    bool     m_stateElided  = false;
+    uint32_t m_skippedCount = 0;
+
+    void elideState();
+
+    void execute(DxvkContext* ctx, const DxvkCsCmd* cmd) {
+#ifdef DXVK_CS_PROFILING
+      auto t0 = dxvk::high_resolution_clock::now();
+      cmd->exec(ctx);
+      auto t1 = dxvk::high_resolution_clock::now();
+
+      DxvkCsProfiler::instance().record(cmd->tag(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+#else
+      cmd->exec(ctx);
+#endif
+    }
     
     alignas(64)
     char m_data[MaxBlockSize];
@@ -377,8 +539,11 @@ namespace dxvk {
    * commands on a DXVK context. 
    */
   class DxvkCsThread {
-    
+    constexpr static uint32_t QueueSize = 1024;
+    constexpr static uint32_t SpinCount = 1000;
   public:
+
+    constexpr static uint64_t SynchronizeAll = ~0ull;
     
     DxvkCsThread(const Rc<DxvkContext>& context);
     ~DxvkCsThread();
@@ -389,18 +554,21 @@ namespace dxvk {
      * Can be used to efficiently play back large
      * command lists recorded on another thread.
      * \param [in] chunk The chunk to dispatch
+     * \returns Sequence number of the chunk
      */
-    void dispatchChunk(DxvkCsChunkRef&& chunk);
+    uint64_t dispatchChunk(DxvkCsChunkRef&& chunk);
     
     /**
      * \brief Synchronizes with the thread
      * 
-     * This waits for all chunks in the dispatch
-     * queue to be processed by the thread. Note
-     * that this does \e not implicitly call
-     * \ref flush.
+     * This waits for all chunks up to and including
+     * the chunk with the given sequence number to be
+     * processed by the thread. Note that this does
+     * \e not implicitly call \ref flush.
+     * \param [in] seq Sequence number to wait for,
+     *    or \c SynchronizeAll to wait for all chunks
      */
-    void synchronize();
+    void synchronize(uint64_t seq);
     
     /**
      * \brief Checks whether the worker thread is busy
@@ -411,7 +579,17 @@ namespace dxvk {
      * \returns \c true if there is still work to do
      */
     bool isBusy() const {
-      return m_chunksPending.load() != 0;
+      return m_chunksExecuted.load() != m_chunksDispatched;
+    }
+
+    /**
+     * \brief Queries last dispatched sequence number
+     *
+     * Must only be called from the dispatching thread.
+     * \returns Sequence number of the last chunk
+     */
+    uint64_t lastSequenceNumber() const {
+      return m_chunksDispatched;
     }
     
   private:
@@ -419,13 +597,23 @@ namespace dxvk {
     const Rc<DxvkContext>       m_context;
     
     std::atomic<bool>           m_stopped = { false };
+    std::atomic<bool>           m_consumerParked = { false };
+    std::atomic<bool>           m_producerParked = { false };
     dxvk::mutex                 m_mutex;
     dxvk::condition_variable    m_condOnAdd;
     dxvk::condition_variable    m_condOnSync;
-    std::queue<DxvkCsChunkRef>  m_chunksQueued;
-    std::atomic<uint32_t>       m_chunksPending = { 0u };
+    uint64_t                    m_chunksDispatched = 0ull;
+    std::atomic<uint64_t>       m_chunksExecuted   = { 0ull };
+
+    sync::BoundedSpscQueue<DxvkCsChunkRef> m_chunksQueued;
+
     dxvk::thread                m_thread;
     
+    bool dequeueChunk(DxvkCsChunkRef& chunk);
+
+    template<typename Pred>
+    void waitForWorker(const Pred& pred);
+
     void threadFunc();
     
   };
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+#include "dxvk_cs_profiler.h"
+
+namespace dxvk {
+
+  DxvkCsProfiler DxvkCsProfiler::s_instance;
+
+
+  DxvkCsProfiler::DxvkCsProfiler()
+  : m_startTime(dxvk::high_resolution_clock::now()),
+    m_lastDump (m_startTime) {
+
+  }
+
+
+  DxvkCsProfiler::~DxvkCsProfiler() {
+
+  }
+
+
+  void DxvkCsProfiler::record(const char* tag, uint64_t timeNs) {
+    if (!tag)
+      tag = "(untagged)";
+
+    // Tags are string literals, so hash the pointer
+    uint64_t hash = uint64_t(reinterpret_cast<uintptr_t>(tag)) * 0x9e3779b97f4a7c15ull;
+
+    for (uint32_t i = 0; i < SlotCount; i++) {
+      Slot& slot = m_slots[((hash >> 32) + i) % SlotCount];
+      const char* slotTag = slot.tag.load(std::memory_order_acquire);
+
+      if (!slotTag && slot.tag.compare_exchange_strong(slotTag, tag))
+        slotTag = tag;
+
+      if (slotTag == tag) {
+        slot.count.fetch_add(1, std::memory_order_relaxed);
+        slot.timeNs.fetch_add(timeNs, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+
+  std::vector<DxvkCsProfileEntry> DxvkCsProfiler::getEntries() const {
+    std::unordered_map<std::string, DxvkCsProfileEntry> merged;
+
+    for (const auto& slot : m_slots) {
+      const char* tag = slot.tag.load(std::memory_order_acquire);
+
+      if (!tag)
+        continue;
+
+      auto& entry = merged[tag];
+      entry.name    = tag;
+      entry.count  += slot.count.load(std::memory_order_relaxed);
+      entry.timeNs += slot.timeNs.load(std::memory_order_relaxed);
+    }
+
+    std::vector<DxvkCsProfileEntry> result;
+    result.reserve(merged.size());
+
+    for (auto& entry : merged)
+      result.push_back(std::move(entry.second));
+
+    std::sort(result.begin(), result.end(),
+      [] (const DxvkCsProfileEntry& a, const DxvkCsProfileEntry& b) {
+        return a.timeNs > b.timeNs;
+      });
+
+    return result;
+  }
+
+
+  void DxvkCsProfiler::dumpPeriodic(dxvk::high_resolution_clock::time_point time) {
+    std::unique_lock<sync::Spinlock> lock(m_dumpLock, std::try_to_lock);
+
+    if (!lock.owns_lock())
+      return;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastDump);
+
+    if (elapsed.count() < DumpInterval)
+      return;
+
+    m_lastDump = time;
+
+    if (!m_csvOpened) {
+      std::filesystem::path csvPath = env::getEnvVar(L"DXVK_CS_PROFILE_CSV");
+
+      if (!csvPath.empty()) {
+        m_csv.open(csvPath, std::ios_base::out | std::ios_base::trunc);
+        m_csv << "time_s,tag,count,time_us" << std::endl;
+      }
+
+      m_csvOpened = true;
+    }
+
+    // Compute results for the last interval only
+    std::vector<DxvkCsProfileEntry> entries = getEntries();
+
+    for (auto& entry : entries) {
+      auto& prev = m_prevEntries[entry.name];
+
+      DxvkCsProfileEntry total = entry;
+      entry.count  -= prev.count;
+      entry.timeNs -= prev.timeNs;
+      prev = std::move(total);
+    }
+
+    std::sort(entries.begin(), entries.end(),
+      [] (const DxvkCsProfileEntry& a, const DxvkCsProfileEntry& b) {
+        return a.timeNs > b.timeNs;
+      });
+
+    double seconds = std::chrono::duration<double>(time - m_startTime).count();
+    std::stringstream log;
+    log << "CS profile at " << uint32_t(seconds) << " s:";
+
+    for (uint32_t i = 0; i < entries.size() && i < DumpCount; i++) {
+      const auto& entry = entries[i];
+
+      if (!entry.count)
+        break;
+
+      log << std::endl << "  " << std::setw(40) << std::left << entry.name
+          << std::setw(10) << std::right << entry.count << " cmds, "
+          << std::setw(10) << (entry.timeNs / 1000) << " us, "
+          << std::setw(8) << (entry.timeNs / entry.count) << " ns/cmd";
+    }
+
+    Logger::info(log.str());
+
+    if (m_csv.is_open()) {
+      for (const auto& entry : entries) {
+        if (entry.count) {
+          m_csv << seconds << "," << entry.name << ","
+                << entry.count << "," << (entry.timeNs / 1000) << "\n";
+        }
+      }
+
+      m_csv.flush();
+    }
+  }
+
+}
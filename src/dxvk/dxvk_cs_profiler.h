@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_include.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  /**
+   * \brief CS profile entry
+   *
+   * Number of commands executed and the total
+   * time spent executing them for a given tag.
+   */
+  struct DxvkCsProfileEntry {
+    std::string name;
+    uint64_t    count;
+    uint64_t    timeNs;
+  };
+
+
+  /**
+   * \brief CS command profiler
+   *
+   * Accumulates execution counts and times of CS
+   * commands per tag, where the tag names the
+   * function that emitted the command. Only used
+   * in builds with \c DXVK_CS_PROFILING defined.
+   *
+   * Results are written to the log periodically,
+   * and to a CSV file if \c DXVK_CS_PROFILE_CSV
+   * is set to a file path.
+   */
+  class DxvkCsProfiler {
+    constexpr static uint32_t SlotCount    = 1024;
+    constexpr static uint32_t DumpCount    = 16;
+    constexpr static int64_t  DumpInterval = 5'000'000;
+  public:
+
+    DxvkCsProfiler();
+
+    ~DxvkCsProfiler();
+
+    /**
+     * \brief Global profiler instance
+     * \returns The profiler
+     */
+    static DxvkCsProfiler& instance() {
+      return s_instance;
+    }
+
+    /**
+     * \brief Records command execution
+     *
+     * Thread-safe and lock-free.
+     * \param [in] tag Command tag, may be \c nullptr
+     * \param [in] timeNs Execution time, in nanoseconds
+     */
+    void record(const char* tag, uint64_t timeNs);
+
+    /**
+     * \brief Retrieves accumulated results
+     *
+     * Entries with the same name are merged.
+     * \returns Entries, sorted by total time
+     */
+    std::vector<DxvkCsProfileEntry> getEntries() const;
+
+    /**
+     * \brief Writes results periodically
+     *
+     * Writes the results for the last interval to the
+     * log and the CSV file if enough time has passed
+     * since the previous call that wrote results.
+     * \param [in] time Current time
+     */
+    void dumpPeriodic(dxvk::high_resolution_clock::time_point time);
+
+  private:
+
+    struct Slot {
+      std::atomic<const char*>  tag     = { nullptr };
+      std::atomic<uint64_t>     count   = { 0ull };
+      std::atomic<uint64_t>     timeNs  = { 0ull };
+    };
+
+    std::array<Slot, SlotCount> m_slots;
+
+    sync::Spinlock              m_dumpLock;
+
+    dxvk::high_resolution_clock::time_point m_startTime;
+    dxvk::high_resolution_clock::time_point m_lastDump;
+
+    std::unordered_map<std::string, DxvkCsProfileEntry> m_prevEntries;
+
+    bool                        m_csvOpened = false;
+    std::ofstream               m_csv;
+
+    static DxvkCsProfiler s_instance;
+
+  };
+
+}
@@ -0,0 +1,750 @@
+#include <sstream>
+
+#include "dxvk_cs_trace.h"
+
+namespace dxvk {
+
+  struct DxvkCsTraceRecordHeader {
+    uint16_t op;
+    uint16_t context;
+    uint32_t size;
+  };
+
+
+  DxvkCsTracer::DxvkCsTracer(
+    const std::filesystem::path&            fileName)
+  : m_stream(fileName, std::ios_base::binary | std::ios_base::trunc) {
+    if (!m_stream) {
+      Logger::err(str::format("CS: Failed to create trace file ", fileName.c_str()));
+      return;
+    }
+
+    DxvkCsTraceHeader header;
+    header.magic   = Magic;
+    header.version = Version;
+
+    m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    Logger::info(str::format("CS: Recording command trace to ", fileName.c_str()));
+  }
+
+
+  DxvkCsTracer::~DxvkCsTracer() {
+    m_stream.flush();
+  }
+
+
+  uint32_t DxvkCsTracer::registerContext() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    return m_contextCount++;
+  }
+
+
+  void DxvkCsTracer::recordFrame() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    writeRecord(0, DxvkCsTraceOp::EndFrame, 0, nullptr);
+
+    m_frameId += 1;
+
+    // Drop objects that have not been used in a while, so that
+    // we don't keep every object that the app ever created alive.
+    // Objects are redefined if they are used again later.
+    for (auto i = m_objects.begin(); i != m_objects.end(); ) {
+      if (i->second.lastFrame + ObjectRetireFrames < m_frameId) {
+        writeRecord(0, DxvkCsTraceOp::DestroyObject,
+          sizeof(i->second.id), &i->second.id);
+        i = m_objects.erase(i);
+      } else {
+        i++;
+      }
+    }
+
+    m_stream.flush();
+  }
+
+
+  void DxvkCsTracer::recordSubmit(uint32_t context) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    writeRecord(context, DxvkCsTraceOp::Submit, 0, nullptr);
+  }
+
+
+  void DxvkCsTracer::recordBindRenderTargets(uint32_t context,
+    const DxvkRenderTargets&        targets) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    DxvkCsTraceBindRenderTargets args = { };
+    args.depthView   = getObjectId(targets.depth.view);
+    args.depthLayout = targets.depth.layout;
+
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      args.colorViews[i]   = getObjectId(targets.color[i].view);
+      args.colorLayouts[i] = targets.color[i].layout;
+    }
+
+    write(context, DxvkCsTraceOp::BindRenderTargets, args);
+  }
+
+
+  void DxvkCsTracer::recordBindDrawBuffers(uint32_t context,
+    const DxvkBufferSlice&          argBuffer,
+    const DxvkBufferSlice&          cntBuffer) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::BindDrawBuffers,
+      DxvkCsTraceBindDrawBuffers { getSlice(argBuffer), getSlice(cntBuffer) });
+  }
+
+
+  void DxvkCsTracer::recordBindIndexBuffer(uint32_t context,
+    const DxvkBufferSlice&          buffer,
+          VkIndexType               indexType) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::BindIndexBuffer,
+      DxvkCsTraceBindIndexBuffer { getSlice(buffer), indexType });
+  }
+
+
+  void DxvkCsTracer::recordBindResourceBuffer(uint32_t context,
+          uint32_t                  slot,
+    const DxvkBufferSlice&          buffer) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::BindResourceBuffer,
+      DxvkCsTraceBindResourceBuffer { slot, getSlice(buffer) });
+  }
+
+
+  void DxvkCsTracer::recordBindResourceView(uint32_t context,
+          uint32_t                  slot,
+    const Rc<DxvkImageView>&        imageView,
+    const Rc<DxvkBufferView>&       bufferView) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::BindResourceView,
+      DxvkCsTraceBindResourceView { slot, getObjectId(imageView), getObjectId(bufferView) });
+  }
+
+
+  void DxvkCsTracer::recordBindResourceSampler(uint32_t context,
+          uint32_t                  slot,
+    const Rc<DxvkSampler>&          sampler) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::BindResourceSampler,
+      DxvkCsTraceBindResourceSampler { slot, getObjectId(sampler) });
+  }
+
+
+  void DxvkCsTracer::recordBindShader(uint32_t context,
+          VkShaderStageFlagBits     stage,
+    const Rc<DxvkShader>&           shader) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::BindShader,
+      DxvkCsTraceBindShader { stage, getObjectId(shader) });
+  }
+
+
+  void DxvkCsTracer::recordBindVertexBuffer(uint32_t context,
+          uint32_t                  binding,
+    const DxvkBufferSlice&          buffer,
+          uint32_t                  stride) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::BindVertexBuffer,
+      DxvkCsTraceBindVertexBuffer { binding, getSlice(buffer), stride });
+  }
+
+
+  void DxvkCsTracer::recordClearBuffer(uint32_t context,
+    const Rc<DxvkBuffer>&           buffer,
+          VkDeviceSize              offset,
+          VkDeviceSize              length,
+          uint32_t                  value) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::ClearBuffer,
+      DxvkCsTraceClearBuffer { getObjectId(buffer), offset, length, value });
+  }
+
+
+  void DxvkCsTracer::recordClearRenderTarget(uint32_t context,
+    const Rc<DxvkImageView>&        imageView,
+          VkImageAspectFlags        aspects,
+          VkClearValue              value) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::ClearRenderTarget,
+      DxvkCsTraceClearRenderTarget { getObjectId(imageView), aspects, value });
+  }
+
+
+  void DxvkCsTracer::recordClearImageView(uint32_t context,
+    const Rc<DxvkImageView>&        imageView,
+          VkOffset3D                offset,
+          VkExtent3D                extent,
+          VkImageAspectFlags        aspects,
+          VkClearValue              value) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::ClearImageView,
+      DxvkCsTraceClearImageView { getObjectId(imageView), offset, extent, aspects, value });
+  }
+
+
+  void DxvkCsTracer::recordCopyBuffer(uint32_t context,
+    const Rc<DxvkBuffer>&           dstBuffer,
+          VkDeviceSize              dstOffset,
+    const Rc<DxvkBuffer>&           srcBuffer,
+          VkDeviceSize              srcOffset,
+          VkDeviceSize              numBytes) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::CopyBuffer, DxvkCsTraceCopyBuffer {
+      getObjectId(dstBuffer), dstOffset,
+      getObjectId(srcBuffer), srcOffset, numBytes });
+  }
+
+
+  void DxvkCsTracer::recordCopyImage(uint32_t context,
+    const Rc<DxvkImage>&            dstImage,
+          VkImageSubresourceLayers  dstSubresource,
+          VkOffset3D                dstOffset,
+    const Rc<DxvkImage>&            srcImage,
+          VkImageSubresourceLayers  srcSubresource,
+          VkOffset3D                srcOffset,
+          VkExtent3D                extent) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::CopyImage, DxvkCsTraceCopyImage {
+      getObjectId(dstImage), dstSubresource, dstOffset,
+      getObjectId(srcImage), srcSubresource, srcOffset, extent });
+  }
+
+
+  void DxvkCsTracer::recordDiscardBuffer(uint32_t context,
+    const Rc<DxvkBuffer>&           buffer) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::DiscardBuffer,
+      DxvkCsTraceBuffer { getObjectId(buffer) });
+  }
+
+
+  void DxvkCsTracer::recordDispatch(uint32_t context,
+          uint32_t                  x,
+          uint32_t                  y,
+          uint32_t                  z) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::Dispatch,
+      DxvkCsTraceDispatch { x, y, z });
+  }
+
+
+  void DxvkCsTracer::recordDispatchIndirect(uint32_t context,
+          VkDeviceSize              offset) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::DispatchIndirect,
+      DxvkCsTraceDispatchIndirect { offset });
+  }
+
+
+  void DxvkCsTracer::recordDraw(uint32_t context,
+          uint32_t                  vertexCount,
+          uint32_t                  instanceCount,
+          uint32_t                  firstVertex,
+          uint32_t                  firstInstance) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::Draw, DxvkCsTraceDraw {
+      vertexCount, instanceCount, firstVertex, firstInstance });
+  }
+
+
+  void DxvkCsTracer::recordDrawIndirect(uint32_t context,
+          VkDeviceSize              offset,
+          uint32_t                  count,
+          uint32_t                  stride) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::DrawIndirect,
+      DxvkCsTraceDrawIndirect { offset, count, stride });
+  }
+
+
+  void DxvkCsTracer::recordDrawIndexed(uint32_t context,
+          uint32_t                  indexCount,
+          uint32_t                  instanceCount,
+          uint32_t                  firstIndex,
+          uint32_t                  vertexOffset,
+          uint32_t                  firstInstance) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::DrawIndexed, DxvkCsTraceDrawIndexed {
+      indexCount, instanceCount, firstIndex, vertexOffset, firstInstance });
+  }
+
+
+  void DxvkCsTracer::recordDrawIndexedIndirect(uint32_t context,
+          VkDeviceSize              offset,
+          uint32_t                  count,
+          uint32_t                  stride) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::DrawIndexedIndirect,
+      DxvkCsTraceDrawIndirect { offset, count, stride });
+  }
+
+
+  void DxvkCsTracer::recordGenerateMipmaps(uint32_t context,
+    const Rc<DxvkImageView>&        imageView,
+          VkFilter                  filter) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::GenerateMipmaps,
+      DxvkCsTraceGenerateMipmaps { getObjectId(imageView), filter });
+  }
+
+
+  void DxvkCsTracer::recordInvalidateBuffer(uint32_t context,
+    const Rc<DxvkBuffer>&           buffer) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::InvalidateBuffer,
+      DxvkCsTraceBuffer { getObjectId(buffer) });
+  }
+
+
+  void DxvkCsTracer::recordPushConstants(uint32_t context,
+          uint32_t                  offset,
+          uint32_t                  size,
+    const void*                     data) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::PushConstants,
+      DxvkCsTracePushConstants { offset, size }, size, data);
+  }
+
+
+  void DxvkCsTracer::recordUpdateBuffer(uint32_t context,
+    const Rc<DxvkBuffer>&           buffer,
+          VkDeviceSize              offset,
+          VkDeviceSize              size,
+    const void*                     data) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::UpdateBuffer,
+      DxvkCsTraceUpdateBuffer { getObjectId(buffer), offset, size }, size, data);
+  }
+
+
+  void DxvkCsTracer::recordUpdateImage(uint32_t context,
+    const Rc<DxvkImage>&            image,
+    const VkImageSubresourceLayers& subresources,
+          VkOffset3D                imageOffset,
+          VkExtent3D                imageExtent,
+    const void*                     data,
+          VkDeviceSize              pitchPerRow,
+          VkDeviceSize              pitchPerLayer) {
+    VkDeviceSize dataSize = computeImageDataSize(image,
+      subresources, imageExtent, pitchPerRow, pitchPerLayer);
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::UpdateImage, DxvkCsTraceUpdateImage {
+      getObjectId(image), subresources, imageOffset, imageExtent,
+      pitchPerRow, pitchPerLayer }, dataSize, data);
+  }
+
+
+  void DxvkCsTracer::recordUploadBuffer(uint32_t context,
+    const Rc<DxvkBuffer>&           buffer,
+    const void*                     data) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::UploadBuffer,
+      DxvkCsTraceBuffer { getObjectId(buffer) },
+      buffer->info().size, data);
+  }
+
+
+  void DxvkCsTracer::recordUploadImage(uint32_t context,
+    const Rc<DxvkImage>&            image,
+    const VkImageSubresourceLayers& subresources,
+    const void*                     data,
+          VkDeviceSize              pitchPerRow,
+          VkDeviceSize              pitchPerLayer) {
+    VkExtent3D imageExtent = image->mipLevelExtent(subresources.mipLevel);
+
+    VkDeviceSize dataSize = computeImageDataSize(image,
+      subresources, imageExtent, pitchPerRow, pitchPerLayer);
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::UploadImage, DxvkCsTraceUpdateImage {
+      getObjectId(image), subresources, VkOffset3D { 0, 0, 0 }, imageExtent,
+      pitchPerRow, pitchPerLayer }, dataSize, data);
+  }
+
+
+  void DxvkCsTracer::recordSetViewports(uint32_t context,
+          uint32_t                  viewportCount,
+    const VkViewport*               viewports,
+    const VkRect2D*                 scissorRects) {
+    size_t viewportSize = viewportCount * sizeof(VkViewport);
+    size_t scissorSize  = viewportCount * sizeof(VkRect2D);
+
+    std::vector<char> data(viewportSize + scissorSize);
+
+    if (viewportCount) {
+      std::memcpy(&data[0], viewports, viewportSize);
+      std::memcpy(&data[viewportSize], scissorRects, scissorSize);
+    }
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetViewports,
+      DxvkCsTraceSetViewports { viewportCount },
+      data.size(), data.data());
+  }
+
+
+  void DxvkCsTracer::recordSetBlendConstants(uint32_t context,
+          DxvkBlendConstants        blendConstants) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetBlendConstants, blendConstants);
+  }
+
+
+  void DxvkCsTracer::recordSetDepthBias(uint32_t context,
+          DxvkDepthBias             depthBias) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetDepthBias, depthBias);
+  }
+
+
+  void DxvkCsTracer::recordSetStencilReference(uint32_t context,
+          uint32_t                  reference) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetStencilReference,
+      DxvkCsTraceSetStencilReference { reference });
+  }
+
+
+  void DxvkCsTracer::recordSetInputAssemblyState(uint32_t context,
+    const DxvkInputAssemblyState&   ia) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetInputAssemblyState, ia);
+  }
+
+
+  void DxvkCsTracer::recordSetInputLayout(uint32_t context,
+          uint32_t                  attributeCount,
+    const DxvkVertexAttribute*      attributes,
+          uint32_t                  bindingCount,
+    const DxvkVertexBinding*        bindings) {
+    size_t attributeSize = attributeCount * sizeof(DxvkVertexAttribute);
+    size_t bindingSize   = bindingCount   * sizeof(DxvkVertexBinding);
+
+    std::vector<char> data(attributeSize + bindingSize);
+
+    if (attributeSize)
+      std::memcpy(&data[0], attributes, attributeSize);
+
+    if (bindingSize)
+      std::memcpy(&data[attributeSize], bindings, bindingSize);
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetInputLayout,
+      DxvkCsTraceSetInputLayout { attributeCount, bindingCount },
+      data.size(), data.data());
+  }
+
+
+  void DxvkCsTracer::recordSetRasterizerState(uint32_t context,
+    const DxvkRasterizerState&      rs) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetRasterizerState, rs);
+  }
+
+
+  void DxvkCsTracer::recordSetMultisampleState(uint32_t context,
+    const DxvkMultisampleState&     ms) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetMultisampleState, ms);
+  }
+
+
+  void DxvkCsTracer::recordSetDepthStencilState(uint32_t context,
+    const DxvkDepthStencilState&    ds) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetDepthStencilState, ds);
+  }
+
+
+  void DxvkCsTracer::recordSetLogicOpState(uint32_t context,
+    const DxvkLogicOpState&         lo) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetLogicOpState, lo);
+  }
+
+
+  void DxvkCsTracer::recordSetBlendMode(uint32_t context,
+          uint32_t                  attachment,
+    const DxvkBlendMode&            blendMode) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetBlendMode,
+      DxvkCsTraceSetBlendMode { attachment, blendMode });
+  }
+
+
+  void DxvkCsTracer::recordSetSpecConstant(uint32_t context,
+          VkPipelineBindPoint       pipeline,
+          uint32_t                  index,
+          uint32_t                  value) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    write(context, DxvkCsTraceOp::SetSpecConstant,
+      DxvkCsTraceSetSpecConstant { pipeline, index, value });
+  }
+
+
+  bool DxvkCsTracer::readHeader(
+          std::istream&             stream,
+          DxvkCsTraceHeader&        header) {
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
+
+    return header.magic   == Magic
+        && header.version == Version;
+  }
+
+
+  bool DxvkCsTracer::readRecord(
+          std::istream&             stream,
+          DxvkCsTraceRecord&        record) {
+    DxvkCsTraceRecordHeader header;
+
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
+
+    record.op      = DxvkCsTraceOp(header.op);
+    record.context = header.context;
+    record.payload.resize(header.size);
+
+    return !header.size
+        || stream.read(record.payload.data(), header.size);
+  }
+
+
+  VkDeviceSize DxvkCsTracer::computeImageDataSize(
+    const Rc<DxvkImage>&            image,
+    const VkImageSubresourceLayers& subresources,
+          VkExtent3D                extent,
+          VkDeviceSize              pitchPerRow,
+          VkDeviceSize              pitchPerLayer) {
+    auto formatInfo = image->formatInfo();
+
+    // Mirrors the way DxvkContext reads host image data, with
+    // aspects stored one after another within each layer
+    VkDeviceSize aspectOffset = 0;
+    VkDeviceSize layerSize = 0;
+
+    for (auto aspects = subresources.aspectMask; aspects; ) {
+      auto aspect = vk::getNextAspect(aspects);
+      auto aspectExtent = extent;
+
+      VkDeviceSize elementSize = formatInfo->elementSize;
+
+      if (formatInfo->flags.test(DxvkFormatFlag::MultiPlane)) {
+        const auto& plane = formatInfo->planes[vk::getPlaneIndex(aspect)];
+        aspectExtent.width  /= plane.blockSize.width;
+        aspectExtent.height /= plane.blockSize.height;
+        elementSize = plane.elementSize;
+      }
+
+      auto blockCount = util::computeBlockCount(aspectExtent, formatInfo->blockSize);
+
+      VkDeviceSize aspectEnd = aspectOffset
+        + (blockCount.depth  - 1) * pitchPerLayer
+        + (blockCount.height - 1) * pitchPerRow
+        +  blockCount.width * elementSize;
+
+      layerSize = std::max(layerSize, aspectEnd);
+      aspectOffset += blockCount.height * pitchPerRow;
+    }
+
+    return (subresources.layerCount - 1) * pitchPerLayer + layerSize;
+  }
+
+
+  uint32_t DxvkCsTracer::getObjectId(const Rc<DxvkBuffer>& buffer) {
+    if (buffer == nullptr)
+      return 0;
+
+    uint32_t id = findObject(buffer.ptr());
+
+    if (!id) {
+      id = addObject(buffer.ptr(), buffer, nullptr);
+
+      write(0, DxvkCsTraceOp::CreateBuffer, DxvkCsTraceCreateBuffer {
+        id, buffer->memFlags(), buffer->info() });
+    }
+
+    return id;
+  }
+
+
+  uint32_t DxvkCsTracer::getObjectId(const Rc<DxvkBufferView>& bufferView) {
+    if (bufferView == nullptr)
+      return 0;
+
+    uint32_t id = findObject(bufferView.ptr());
+
+    if (!id) {
+      uint32_t bufferId = getObjectId(bufferView->buffer());
+      id = addObject(bufferView.ptr(), bufferView, nullptr);
+
+      write(0, DxvkCsTraceOp::CreateBufferView, DxvkCsTraceCreateBufferView {
+        id, bufferId, bufferView->info() });
+    }
+
+    return id;
+  }
+
+
+  uint32_t DxvkCsTracer::getObjectId(const Rc<DxvkImage>& image) {
+    if (image == nullptr)
+      return 0;
+
+    uint32_t id = findObject(image.ptr());
+
+    if (!id) {
+      id = addObject(image.ptr(), image, nullptr);
+
+      DxvkCsTraceCreateImage args = { id, image->memFlags(), image->info() };
+      args.info.viewFormats = nullptr;
+
+      write(0, DxvkCsTraceOp::CreateImage, args,
+        image->info().viewFormatCount * sizeof(VkFormat),
+        image->info().viewFormats);
+    }
+
+    return id;
+  }
+
+
+  uint32_t DxvkCsTracer::getObjectId(const Rc<DxvkImageView>& imageView) {
+    if (imageView == nullptr)
+      return 0;
+
+    uint32_t id = findObject(imageView.ptr());
+
+    if (!id) {
+      uint32_t imageId = getObjectId(imageView->image());
+      id = addObject(imageView.ptr(), imageView, nullptr);
+
+      write(0, DxvkCsTraceOp::CreateImageView, DxvkCsTraceCreateImageView {
+        id, imageId, imageView->info() });
+    }
+
+    return id;
+  }
+
+
+  uint32_t DxvkCsTracer::getObjectId(const Rc<DxvkSampler>& sampler) {
+    if (sampler == nullptr)
+      return 0;
+
+    uint32_t id = findObject(sampler.ptr());
+
+    if (!id) {
+      id = addObject(sampler.ptr(), sampler, nullptr);
+
+      write(0, DxvkCsTraceOp::CreateSampler, DxvkCsTraceCreateSampler {
+        id, sampler->info() });
+    }
+
+    return id;
+  }
+
+
+  uint32_t DxvkCsTracer::getObjectId(const Rc<DxvkShader>& shader) {
+    if (shader == nullptr)
+      return 0;
+
+    uint32_t id = findObject(shader.ptr());
+
+    if (!id) {
+      id = addObject(shader.ptr(), nullptr, shader);
+
+      std::stringstream code;
+      shader->dump(code);
+
+      std::string codeData = code.str();
+
+      const auto& slots = shader->resourceSlots();
+      const auto& constData = shader->shaderConstants();
+
+      DxvkCsTraceCreateShader args = { };
+      args.id           = id;
+      args.stage        = shader->stage();
+      args.iface        = shader->interfaceSlots();
+      args.options      = shader->shaderOptions();
+      args.hash         = shader->getShaderKey().sha1();
+      args.slotCount    = uint32_t(slots.size());
+      args.constDwords  = uint32_t(constData.sizeInBytes() / sizeof(uint32_t));
+      args.codeDwords   = uint32_t(codeData.size() / sizeof(uint32_t));
+
+      size_t slotSize = slots.size() * sizeof(DxvkResourceSlot);
+
+      std::vector<char> data(slotSize + constData.sizeInBytes() + codeData.size());
+
+      if (slotSize)
+        std::memcpy(&data[0], slots.data(), slotSize);
+
+      if (constData.sizeInBytes())
+        std::memcpy(&data[slotSize], constData.data(), constData.sizeInBytes());
+
+      if (codeData.size())
+        std::memcpy(&data[slotSize + constData.sizeInBytes()], codeData.data(), codeData.size());
+
+      write(0, DxvkCsTraceOp::CreateShader, args, data.size(), data.data());
+    }
+
+    return id;
+  }
+
+
+  DxvkCsTraceSlice DxvkCsTracer::getSlice(const DxvkBufferSlice& slice) {
+    if (!slice.defined())
+      return DxvkCsTraceSlice { 0, 0, 0 };
+
+    return DxvkCsTraceSlice { getObjectId(slice.buffer()), slice.offset(), slice.length() };
+  }
+
+
+  uint32_t DxvkCsTracer::findObject(const void* object) {
+    auto entry = m_objects.find(object);
+
+    if (entry == m_objects.end())
+      return 0;
+
+    entry->second.lastFrame = m_frameId;
+    return entry->second.id;
+  }
+
+
+  uint32_t DxvkCsTracer::addObject(
+    const void*                     key,
+    const Rc<DxvkResource>&         resource,
+    const Rc<DxvkShader>&           shader) {
+    ObjectEntry entry;
+    entry.resource  = resource;
+    entry.shader    = shader;
+    entry.id        = m_nextId++;
+    entry.lastFrame = m_frameId;
+
+    m_objects.insert({ key, entry });
+    return entry.id;
+  }
+
+
+  void DxvkCsTracer::writeRecord(
+          uint32_t                  context,
+          DxvkCsTraceOp             op,
+          size_t                    argSize,
+    const void*                     args,
+          size_t                    dataSize,
+    const void*                     data) {
+    DxvkCsTraceRecordHeader header;
+    header.op      = uint16_t(op);
+    header.context = uint16_t(context);
+    header.size    = uint32_t(argSize + dataSize);
+
+    m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (argSize)
+      m_stream.write(reinterpret_cast<const char*>(args), argSize);
+
+    if (dataSize)
+      m_stream.write(reinterpret_cast<const char*>(data), dataSize);
+  }
+
+}
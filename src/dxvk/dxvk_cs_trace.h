@@ -0,0 +1,669 @@
+#pragma once
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_buffer.h"
+#include "dxvk_constant_state.h"
+#include "dxvk_framebuffer.h"
+#include "dxvk_image.h"
+#include "dxvk_sampler.h"
+#include "dxvk_shader.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Command trace header
+   */
+  struct DxvkCsTraceHeader {
+    uint32_t magic;
+    uint32_t version;
+  };
+
+
+  /**
+   * \brief Command trace operation
+   *
+   * Object creation and destruction records are
+   * emitted by the tracer itself, all other records
+   * correspond to a \ref DxvkContext method.
+   */
+  enum class DxvkCsTraceOp : uint16_t {
+    CreateBuffer,
+    CreateBufferView,
+    CreateImage,
+    CreateImageView,
+    CreateSampler,
+    CreateShader,
+    DestroyObject,
+    EndFrame,
+    Submit,
+    BindRenderTargets,
+    BindDrawBuffers,
+    BindIndexBuffer,
+    BindResourceBuffer,
+    BindResourceView,
+    BindResourceSampler,
+    BindShader,
+    BindVertexBuffer,
+    ClearBuffer,
+    ClearRenderTarget,
+    ClearImageView,
+    CopyBuffer,
+    CopyImage,
+    DiscardBuffer,
+    Dispatch,
+    DispatchIndirect,
+    Draw,
+    DrawIndirect,
+    DrawIndexed,
+    DrawIndexedIndirect,
+    GenerateMipmaps,
+    InvalidateBuffer,
+    PushConstants,
+    UpdateBuffer,
+    UpdateImage,
+    UploadBuffer,
+    UploadImage,
+    SetViewports,
+    SetBlendConstants,
+    SetDepthBias,
+    SetStencilReference,
+    SetInputAssemblyState,
+    SetInputLayout,
+    SetRasterizerState,
+    SetMultisampleState,
+    SetDepthStencilState,
+    SetLogicOpState,
+    SetBlendMode,
+    SetSpecConstant,
+  };
+
+
+  /**
+   * \brief Buffer slice in a command trace
+   */
+  struct DxvkCsTraceSlice {
+    uint32_t                  buffer;
+    VkDeviceSize              offset;
+    VkDeviceSize              length;
+  };
+
+  struct DxvkCsTraceCreateBuffer {
+    uint32_t                  id;
+    VkMemoryPropertyFlags     memFlags;
+    DxvkBufferCreateInfo      info;
+  };
+
+  struct DxvkCsTraceCreateBufferView {
+    uint32_t                  id;
+    uint32_t                  buffer;
+    DxvkBufferViewCreateInfo  info;
+  };
+
+  /// Followed by the image's view formats
+  struct DxvkCsTraceCreateImage {
+    uint32_t                  id;
+    VkMemoryPropertyFlags     memFlags;
+    DxvkImageCreateInfo       info;
+  };
+
+  struct DxvkCsTraceCreateImageView {
+    uint32_t                  id;
+    uint32_t                  image;
+    DxvkImageViewCreateInfo   info;
+  };
+
+  struct DxvkCsTraceCreateSampler {
+    uint32_t                  id;
+    DxvkSamplerCreateInfo     info;
+  };
+
+  /// Followed by resource slots, constant data and SPIR-V code
+  struct DxvkCsTraceCreateShader {
+    uint32_t                  id;
+    VkShaderStageFlagBits     stage;
+    DxvkInterfaceSlots        iface;
+    DxvkShaderOptions         options;
+    Sha1Hash                  hash;
+    uint32_t                  slotCount;
+    uint32_t                  constDwords;
+    uint32_t                  codeDwords;
+  };
+
+  struct DxvkCsTraceDestroyObject {
+    uint32_t                  id;
+  };
+
+  struct DxvkCsTraceBindRenderTargets {
+    uint32_t                  depthView;
+    VkImageLayout             depthLayout;
+    uint32_t                  colorViews[MaxNumRenderTargets];
+    VkImageLayout             colorLayouts[MaxNumRenderTargets];
+  };
+
+  struct DxvkCsTraceBindDrawBuffers {
+    DxvkCsTraceSlice          argBuffer;
+    DxvkCsTraceSlice          cntBuffer;
+  };
+
+  struct DxvkCsTraceBindIndexBuffer {
+    DxvkCsTraceSlice          buffer;
+    VkIndexType               indexType;
+  };
+
+  struct DxvkCsTraceBindResourceBuffer {
+    uint32_t                  slot;
+    DxvkCsTraceSlice          buffer;
+  };
+
+  struct DxvkCsTraceBindResourceView {
+    uint32_t                  slot;
+    uint32_t                  imageView;
+    uint32_t                  bufferView;
+  };
+
+  struct DxvkCsTraceBindResourceSampler {
+    uint32_t                  slot;
+    uint32_t                  sampler;
+  };
+
+  struct DxvkCsTraceBindShader {
+    VkShaderStageFlagBits     stage;
+    uint32_t                  shader;
+  };
+
+  struct DxvkCsTraceBindVertexBuffer {
+    uint32_t                  binding;
+    DxvkCsTraceSlice          buffer;
+    uint32_t                  stride;
+  };
+
+  struct DxvkCsTraceClearBuffer {
+    uint32_t                  buffer;
+    VkDeviceSize              offset;
+    VkDeviceSize              length;
+    uint32_t                  value;
+  };
+
+  struct DxvkCsTraceClearRenderTarget {
+    uint32_t                  imageView;
+    VkImageAspectFlags        aspects;
+    VkClearValue              value;
+  };
+
+  struct DxvkCsTraceClearImageView {
+    uint32_t                  imageView;
+    VkOffset3D                offset;
+    VkExtent3D                extent;
+    VkImageAspectFlags        aspects;
+    VkClearValue              value;
+  };
+
+  struct DxvkCsTraceCopyBuffer {
+    uint32_t                  dstBuffer;
+    VkDeviceSize              dstOffset;
+    uint32_t                  srcBuffer;
+    VkDeviceSize              srcOffset;
+    VkDeviceSize              numBytes;
+  };
+
+  struct DxvkCsTraceCopyImage {
+    uint32_t                  dstImage;
+    VkImageSubresourceLayers  dstSubresource;
+    VkOffset3D                dstOffset;
+    uint32_t                  srcImage;
+    VkImageSubresourceLayers  srcSubresource;
+    VkOffset3D                srcOffset;
+    VkExtent3D                extent;
+  };
+
+  struct DxvkCsTraceBuffer {
+    uint32_t                  buffer;
+  };
+
+  struct DxvkCsTraceDispatch {
+    uint32_t                  x;
+    uint32_t                  y;
+    uint32_t                  z;
+  };
+
+  struct DxvkCsTraceDispatchIndirect {
+    VkDeviceSize              offset;
+  };
+
+  struct DxvkCsTraceDraw {
+    uint32_t                  vertexCount;
+    uint32_t                  instanceCount;
+    uint32_t                  firstVertex;
+    uint32_t                  firstInstance;
+  };
+
+  struct DxvkCsTraceDrawIndexed {
+    uint32_t                  indexCount;
+    uint32_t                  instanceCount;
+    uint32_t                  firstIndex;
+    uint32_t                  vertexOffset;
+    uint32_t                  firstInstance;
+  };
+
+  struct DxvkCsTraceDrawIndirect {
+    VkDeviceSize              offset;
+    uint32_t                  count;
+    uint32_t                  stride;
+  };
+
+  struct DxvkCsTraceGenerateMipmaps {
+    uint32_t                  imageView;
+    VkFilter                  filter;
+  };
+
+  /// Followed by push constant data
+  struct DxvkCsTracePushConstants {
+    uint32_t                  offset;
+    uint32_t                  size;
+  };
+
+  /// Followed by buffer data
+  struct DxvkCsTraceUpdateBuffer {
+    uint32_t                  buffer;
+    VkDeviceSize              offset;
+    VkDeviceSize              size;
+  };
+
+  /// Followed by image data
+  struct DxvkCsTraceUpdateImage {
+    uint32_t                  image;
+    VkImageSubresourceLayers  subresources;
+    VkOffset3D                offset;
+    VkExtent3D                extent;
+    VkDeviceSize              pitchPerRow;
+    VkDeviceSize              pitchPerLayer;
+  };
+
+  /// Followed by viewports and scissor rects
+  struct DxvkCsTraceSetViewports {
+    uint32_t                  viewportCount;
+  };
+
+  struct DxvkCsTraceSetStencilReference {
+    uint32_t                  reference;
+  };
+
+  /// Followed by vertex attributes and bindings
+  struct DxvkCsTraceSetInputLayout {
+    uint32_t                  attributeCount;
+    uint32_t                  bindingCount;
+  };
+
+  struct DxvkCsTraceSetBlendMode {
+    uint32_t                  attachment;
+    DxvkBlendMode             blendMode;
+  };
+
+  struct DxvkCsTraceSetSpecConstant {
+    VkPipelineBindPoint       pipeline;
+    uint32_t                  index;
+    uint32_t                  value;
+  };
+
+
+  /**
+   * \brief Command trace record
+   *
+   * Stores the fixed-size arguments of an operation,
+   * followed by a variable amount of additional data.
+   */
+  struct DxvkCsTraceRecord {
+    DxvkCsTraceOp     op;
+    uint32_t          context;
+    std::vector<char> payload;
+
+    template<typename T>
+    T args() const {
+      T result;
+      std::memcpy(&result, payload.data(), sizeof(T));
+      return result;
+    }
+
+    template<typename T>
+    const char* data() const {
+      return payload.data() + sizeof(T);
+    }
+  };
+
+
+  /**
+   * \brief Command tracer
+   *
+   * Writes the commands that are recorded into each
+   * \ref DxvkContext to a binary trace, along with the
+   * objects that they use and any data that they upload.
+   * The trace can be replayed on a different device in
+   * order to benchmark the backend without running the
+   * application.
+   *
+   * Objects are defined in the trace the first time a
+   * command uses them, and dropped if they remain unused
+   * for a while. Data written to mapped buffer memory
+   * by the application is not captured, and neither
+   * are queries, blits, resolves, transform feedback,
+   * and other less common operations.
+   */
+  class DxvkCsTracer {
+    constexpr static uint32_t Magic   = 0x54435844; // "DXCT"
+    constexpr static uint32_t Version = 1;
+
+    constexpr static uint64_t ObjectRetireFrames = 300;
+  public:
+
+    DxvkCsTracer(
+      const std::filesystem::path&            fileName);
+
+    ~DxvkCsTracer();
+
+    /**
+     * \brief Registers a context
+     * \returns Context ID to pass to record methods
+     */
+    uint32_t registerContext();
+
+    /**
+     * \brief Records end of a frame
+     *
+     * Also drops objects that have not been
+     * used for a large number of frames.
+     */
+    void recordFrame();
+
+    /**
+     * \brief Records command list submission
+     * \param [in] context Context ID
+     */
+    void recordSubmit(uint32_t context);
+
+    void recordBindRenderTargets(uint32_t context,
+      const DxvkRenderTargets&        targets);
+
+    void recordBindDrawBuffers(uint32_t context,
+      const DxvkBufferSlice&          argBuffer,
+      const DxvkBufferSlice&          cntBuffer);
+
+    void recordBindIndexBuffer(uint32_t context,
+      const DxvkBufferSlice&          buffer,
+            VkIndexType               indexType);
+
+    void recordBindResourceBuffer(uint32_t context,
+            uint32_t                  slot,
+      const DxvkBufferSlice&          buffer);
+
+    void recordBindResourceView(uint32_t context,
+            uint32_t                  slot,
+      const Rc<DxvkImageView>&        imageView,
+      const Rc<DxvkBufferView>&       bufferView);
+
+    void recordBindResourceSampler(uint32_t context,
+            uint32_t                  slot,
+      const Rc<DxvkSampler>&          sampler);
+
+    void recordBindShader(uint32_t context,
+            VkShaderStageFlagBits     stage,
+      const Rc<DxvkShader>&           shader);
+
+    void recordBindVertexBuffer(uint32_t context,
+            uint32_t                  binding,
+      const DxvkBufferSlice&          buffer,
+            uint32_t                  stride);
+
+    void recordClearBuffer(uint32_t context,
+      const Rc<DxvkBuffer>&           buffer,
+            VkDeviceSize              offset,
+            VkDeviceSize              length,
+            uint32_t                  value);
+
+    void recordClearRenderTarget(uint32_t context,
+      const Rc<DxvkImageView>&        imageView,
+            VkImageAspectFlags        aspects,
+            VkClearValue              value);
+
+    void recordClearImageView(uint32_t context,
+      const Rc<DxvkImageView>&        imageView,
+            VkOffset3D                offset,
+            VkExtent3D                extent,
+            VkImageAspectFlags        aspects,
+            VkClearValue              value);
+
+    void recordCopyBuffer(uint32_t context,
+      const Rc<DxvkBuffer>&           dstBuffer,
+            VkDeviceSize              dstOffset,
+      const Rc<DxvkBuffer>&           srcBuffer,
+            VkDeviceSize              srcOffset,
+            VkDeviceSize              numBytes);
+
+    void recordCopyImage(uint32_t context,
+      const Rc<DxvkImage>&            dstImage,
+            VkImageSubresourceLayers  dstSubresource,
+            VkOffset3D                dstOffset,
+      const Rc<DxvkImage>&            srcImage,
+            VkImageSubresourceLayers  srcSubresource,
+            VkOffset3D                srcOffset,
+            VkExtent3D                extent);
+
+    void recordDiscardBuffer(uint32_t context,
+      const Rc<DxvkBuffer>&           buffer);
+
+    void recordDispatch(uint32_t context,
+            uint32_t                  x,
+            uint32_t                  y,
+            uint32_t                  z);
+
+    void recordDispatchIndirect(uint32_t context,
+            VkDeviceSize              offset);
+
+    void recordDraw(uint32_t context,
+            uint32_t                  vertexCount,
+            uint32_t                  instanceCount,
+            uint32_t                  firstVertex,
+            uint32_t                  firstInstance);
+
+    void recordDrawIndirect(uint32_t context,
+            VkDeviceSize              offset,
+            uint32_t                  count,
+            uint32_t                  stride);
+
+    void recordDrawIndexed(uint32_t context,
+            uint32_t                  indexCount,
+            uint32_t                  instanceCount,
+            uint32_t                  firstIndex,
+            uint32_t                  vertexOffset,
+            uint32_t                  firstInstance);
+
+    void recordDrawIndexedIndirect(uint32_t context,
+            VkDeviceSize              offset,
+            uint32_t                  count,
+            uint32_t                  stride);
+
+    void recordGenerateMipmaps(uint32_t context,
+      const Rc<DxvkImageView>&        imageView,
+            VkFilter                  filter);
+
+    void recordInvalidateBuffer(uint32_t context,
+      const Rc<DxvkBuffer>&           buffer);
+
+    void recordPushConstants(uint32_t context,
+            uint32_t                  offset,
+            uint32_t                  size,
+      const void*                     data);
+
+    void recordUpdateBuffer(uint32_t context,
+      const Rc<DxvkBuffer>&           buffer,
+            VkDeviceSize              offset,
+            VkDeviceSize              size,
+      const void*                     data);
+
+    void recordUpdateImage(uint32_t context,
+      const Rc<DxvkImage>&            image,
+      const VkImageSubresourceLayers& subresources,
+            VkOffset3D                imageOffset,
+            VkExtent3D                imageExtent,
+      const void*                     data,
+            VkDeviceSize              pitchPerRow,
+            VkDeviceSize              pitchPerLayer);
+
+    void recordUploadBuffer(uint32_t context,
+      const Rc<DxvkBuffer>&           buffer,
+      const void*                     data);
+
+    void recordUploadImage(uint32_t context,
+      const Rc<DxvkImage>&            image,
+      const VkImageSubresourceLayers& subresources,
+      const void*                     data,
+            VkDeviceSize              pitchPerRow,
+            VkDeviceSize              pitchPerLayer);
+
+    void recordSetViewports(uint32_t context,
+            uint32_t                  viewportCount,
+      const VkViewport*               viewports,
+      const VkRect2D*                 scissorRects);
+
+    void recordSetBlendConstants(uint32_t context,
+            DxvkBlendConstants        blendConstants);
+
+    void recordSetDepthBias(uint32_t context,
+            DxvkDepthBias             depthBias);
+
+    void recordSetStencilReference(uint32_t context,
+            uint32_t                  reference);
+
+    void recordSetInputAssemblyState(uint32_t context,
+      const DxvkInputAssemblyState&   ia);
+
+    void recordSetInputLayout(uint32_t context,
+            uint32_t                  attributeCount,
+      const DxvkVertexAttribute*      attributes,
+            uint32_t                  bindingCount,
+      const DxvkVertexBinding*        bindings);
+
+    void recordSetRasterizerState(uint32_t context,
+      const DxvkRasterizerState&      rs);
+
+    void recordSetMultisampleState(uint32_t context,
+      const DxvkMultisampleState&     ms);
+
+    void recordSetDepthStencilState(uint32_t context,
+      const DxvkDepthStencilState&    ds);
+
+    void recordSetLogicOpState(uint32_t context,
+      const DxvkLogicOpState&         lo);
+
+    void recordSetBlendMode(uint32_t context,
+            uint32_t                  attachment,
+      const DxvkBlendMode&            blendMode);
+
+    void recordSetSpecConstant(uint32_t context,
+            VkPipelineBindPoint       pipeline,
+            uint32_t                  index,
+            uint32_t                  value);
+
+    /**
+     * \brief Reads trace header
+     *
+     * \param [in] stream Input stream
+     * \param [out] header Trace header
+     * \returns \c true if the header is valid
+     */
+    static bool readHeader(
+            std::istream&             stream,
+            DxvkCsTraceHeader&        header);
+
+    /**
+     * \brief Reads next trace record
+     *
+     * \param [in] stream Input stream
+     * \param [out] record Trace record
+     * \returns \c true on success, \c false at
+     *          the end of the trace
+     */
+    static bool readRecord(
+            std::istream&             stream,
+            DxvkCsTraceRecord&        record);
+
+    /**
+     * \brief Computes size of host image data
+     *
+     * Number of bytes that an image upload
+     * with the given parameters reads.
+     * \param [in] image The image
+     * \param [in] subresources Image subresources
+     * \param [in] extent Image area extent
+     * \param [in] pitchPerRow Row pitch
+     * \param [in] pitchPerLayer Layer pitch
+     * \returns Size of the image data, in bytes
+     */
+    static VkDeviceSize computeImageDataSize(
+      const Rc<DxvkImage>&            image,
+      const VkImageSubresourceLayers& subresources,
+            VkExtent3D                extent,
+            VkDeviceSize              pitchPerRow,
+            VkDeviceSize              pitchPerLayer);
+
+  private:
+
+    struct ObjectEntry {
+      Rc<DxvkResource>  resource;
+      Rc<DxvkShader>    shader;
+      uint32_t          id;
+      uint64_t          lastFrame;
+    };
+
+    dxvk::mutex     m_mutex;
+    std::ofstream   m_stream;
+
+    uint32_t        m_contextCount = 0;
+    uint32_t        m_nextId = 1;
+    uint64_t        m_frameId = 0;
+
+    std::unordered_map<const void*, ObjectEntry> m_objects;
+
+    uint32_t getObjectId(const Rc<DxvkBuffer>&      buffer);
+    uint32_t getObjectId(const Rc<DxvkBufferView>&  bufferView);
+    uint32_t getObjectId(const Rc<DxvkImage>&       image);
+    uint32_t getObjectId(const Rc<DxvkImageView>&   imageView);
+    uint32_t getObjectId(const Rc<DxvkSampler>&     sampler);
+    uint32_t getObjectId(const Rc<DxvkShader>&      shader);
+
+    DxvkCsTraceSlice getSlice(const DxvkBufferSlice& slice);
+
+    uint32_t findObject(const void* object);
+
+    uint32_t addObject(
+      const void*                     key,
+      const Rc<DxvkResource>&         resource,
+      const Rc<DxvkShader>&           shader);
+
+    void writeRecord(
+            uint32_t                  context,
+            DxvkCsTraceOp             op,
+            size_t                    argSize,
+      const void*                     args,
+            size_t                    dataSize = 0,
+      const void*                     data = nullptr);
+
+    template<typename T>
+    void write(
+            uint32_t                  context,
+            DxvkCsTraceOp             op,
+      const T&                        args,
+            size_t                    dataSize = 0,
+      const void*                     data = nullptr) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      writeRecord(context, op, sizeof(T), &args, dataSize, data);
+    }
+
+  };
+
+}
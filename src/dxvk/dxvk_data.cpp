@@ -2,6 +2,8 @@
 
 #include "dxvk_data.h"
 
+#include "../util/util_bit.h"
+
 namespace dxvk {
   
   DxvkDataBuffer:: DxvkDataBuffer() { }
@@ -9,8 +11,18 @@ namespace dxvk {
   : m_data(new char[size]), m_size(size) { }
   
   
+  DxvkDataBuffer::DxvkDataBuffer(
+    const Rc<DxvkDataBufferPool>& pool,
+          char*               data,
+          size_t              size)
+  : m_pool(pool), m_data(data), m_size(size) { }
+
+
   DxvkDataBuffer::~DxvkDataBuffer() {
-    delete[] m_data;
+    if (m_pool != nullptr)
+      m_pool->free(m_data, m_size);
+    else
+      delete[] m_data;
   }
   
   
@@ -23,4 +35,83 @@ namespace dxvk {
     } return DxvkDataSlice();
   }
   
-}
\ No newline at end of file
+  
+  DxvkDataBufferPool::DxvkDataBufferPool() {
+
+  }
+
+
+  DxvkDataBufferPool::~DxvkDataBufferPool() {
+    for (const auto& list : m_freeLists) {
+      for (char* data : list)
+        delete[] data;
+    }
+  }
+
+
+  Rc<DxvkDataBuffer> DxvkDataBufferPool::alloc(size_t size) {
+    m_allocCount += 1;
+
+    uint32_t sizeClass = getSizeClass(size);
+
+    if (sizeClass >= SizeClassCount)
+      return new DxvkDataBuffer(this, new char[size], size);
+
+    size_t classSize = size_t(1) << (MinSizeClassLog2 + sizeClass);
+    char* data = nullptr;
+
+    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+      auto& list = m_freeLists[sizeClass];
+
+      if (!list.empty()) {
+        data = list.back();
+        list.pop_back();
+      }
+    }
+
+    if (data)
+      m_reuseCount += 1;
+    else
+      data = new char[classSize];
+
+    return new DxvkDataBuffer(this, data, classSize);
+  }
+
+
+  void DxvkDataBufferPool::free(char* data, size_t size) {
+    uint32_t sizeClass = getSizeClass(size);
+
+    if (sizeClass < SizeClassCount) {
+      // Always keep one buffer per size class around,
+      // but limit the amount of memory held by the pool
+      size_t maxCount = std::max<size_t>(MaxCachedSize >> (MinSizeClassLog2 + sizeClass), 1);
+
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
+      auto& list = m_freeLists[sizeClass];
+
+      if (list.size() < maxCount) {
+        list.push_back(data);
+        return;
+      }
+    }
+
+    delete[] data;
+  }
+
+
+  DxvkDataBufferPoolStats DxvkDataBufferPool::getStats() const {
+    DxvkDataBufferPoolStats stats;
+    stats.allocCount = m_allocCount.load();
+    stats.reuseCount = m_reuseCount.load();
+    return stats;
+  }
+
+
+  uint32_t DxvkDataBufferPool::getSizeClass(size_t size) {
+    if (size <= (size_t(1) << MinSizeClassLog2))
+      return 0;
+
+    return (64 - bit::lzcnt(uint64_t(size - 1))) - MinSizeClassLog2;
+  }
+  
+}
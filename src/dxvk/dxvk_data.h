@@ -1,9 +1,13 @@
 #pragma once
 
+#include <array>
+#include <vector>
+
 #include "dxvk_include.h"
 
 namespace dxvk {
   
+  class DxvkDataBufferPool;
   class DxvkDataSlice;
   
   /**
@@ -20,6 +24,10 @@ namespace dxvk {
     
     DxvkDataBuffer();
     DxvkDataBuffer(size_t size);
+    DxvkDataBuffer(
+      const Rc<DxvkDataBufferPool>& pool,
+            char*               data,
+            size_t              size);
     ~DxvkDataBuffer();
     
     /**
@@ -35,6 +43,8 @@ namespace dxvk {
     
   private:
     
+    Rc<DxvkDataBufferPool> m_pool;
+
     char*   m_data   = nullptr;
     size_t  m_size   = 0;
     size_t  m_offset = 0;
@@ -77,6 +87,77 @@ namespace dxvk {
     size_t             m_length = 0;
     
   };
+
+
+  /**
+   * \brief Data buffer pool statistics
+   */
+  struct DxvkDataBufferPoolStats {
+    uint64_t allocCount;
+    uint64_t reuseCount;
+  };
+
+
+  /**
+   * \brief Data buffer pool
+   * 
+   * Recycles the storage of data buffers in power-of-two
+   * size classes, so that contexts which allocate update
+   * data every frame do not hit the system allocator in
+   * steady state. Data buffers return their storage to
+   * the pool when they get destroyed. The largest size
+   * class matches the size of the update buffers that
+   * contexts allocate. Larger buffers are allocated with
+   * their exact size and never cached, so that rounding
+   * does not waste memory. Thread-safe.
+   */
+  class DxvkDataBufferPool : public RcObject {
+    constexpr static uint32_t MinSizeClassLog2 = 16; // 64 kiB
+    constexpr static uint32_t MaxSizeClassLog2 = 24; // 16 MiB
+    constexpr static uint32_t SizeClassCount   = MaxSizeClassLog2 - MinSizeClassLog2 + 1;
+    constexpr static size_t   MaxCachedSize    = 64 << 20;
+  public:
+
+    DxvkDataBufferPool();
+
+    ~DxvkDataBufferPool();
+
+    /**
+     * \brief Allocates a data buffer
+     *
+     * The buffer may be larger than requested
+     * if its size is within a pooled size class.
+     * \param [in] size Minimum buffer size
+     * \returns The data buffer
+     */
+    Rc<DxvkDataBuffer> alloc(size_t size);
+
+    /**
+     * \brief Returns buffer storage to the pool
+     *
+     * Called when a pooled data buffer is destroyed.
+     * \param [in] data Buffer storage
+     * \param [in] size Buffer size
+     */
+    void free(char* data, size_t size);
+
+    /**
+     * \brief Queries allocation statistics
+     * \returns Number of allocations and the number
+     *    of allocations that reused pooled storage
+     */
+    DxvkDataBufferPoolStats getStats() const;
+
+  private:
+
+    sync::Spinlock                                  m_mutex;
+    std::array<std::vector<char*>, SizeClassCount>  m_freeLists;
+
+    std::atomic<uint64_t> m_allocCount = { 0ull };
+    std::atomic<uint64_t> m_reuseCount = { 0ull };
+
+    static uint32_t getSizeClass(size_t size);
+
+  };
   
-  
-}
\ No newline at end of file
+}
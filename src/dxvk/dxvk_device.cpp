@@ -18,10 +18,16 @@ namespace dxvk {
     m_properties        (adapter->devicePropertiesExt()),
     m_perfHints         (getPerfHints()),
     m_objects           (this),
+    m_dataBufferPool    (new DxvkDataBufferPool()),
     m_submissionQueue   (this) {
     auto queueFamilies = m_adapter->findQueueFamilies();
     m_queues.graphics = getQueue(queueFamilies.graphics, 0);
     m_queues.transfer = getQueue(queueFamilies.transfer, 0);
+
+    std::filesystem::path traceFile = env::getEnvVar(L"DXVK_CS_TRACE");
+
+    if (!traceFile.empty())
+      m_csTracer = std::make_unique<DxvkCsTracer>(traceFile);
   }
   
   
@@ -66,12 +72,30 @@ namespace dxvk {
     Rc<DxvkCommandList> cmdList = m_recycledCommandLists.retrieveObject();
     
     if (cmdList == nullptr)
-      cmdList = new DxvkCommandList(this);
+      cmdList = new DxvkCommandList(this, VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
     
     return cmdList;
   }
 
 
+  Rc<DxvkCommandList> DxvkDevice::createSecondaryCommandList() {
+    Rc<DxvkCommandList> cmdList = m_recycledSecondaryLists.retrieveObject();
+
+    if (cmdList == nullptr)
+      cmdList = new DxvkCommandList(this, VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+    return cmdList;
+  }
+
+
+  Rc<DxvkCommandList> DxvkDevice::createReusableCommandList() {
+    return new DxvkCommandList(this, VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+      VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+  }
+
+
   Rc<DxvkDescriptorPool> DxvkDevice::createDescriptorPool() {
     Rc<DxvkDescriptorPool> pool = m_recycledDescriptorPools.retrieveObject();
 
@@ -122,6 +146,12 @@ namespace dxvk {
   }
   
   
+  Rc<DxvkDataBuffer> DxvkDevice::createDataBuffer(
+          size_t                size) {
+    return m_dataBufferPool->alloc(size);
+  }
+
+
   Rc<DxvkBufferView> DxvkDevice::createBufferView(
     const Rc<DxvkBuffer>&           buffer,
     const DxvkBufferViewCreateInfo& createInfo) {
@@ -177,6 +207,10 @@ namespace dxvk {
     result.setCtr(DxvkStatCounter::PipeCompilerBusy,  m_objects.pipelineManager().isCompilingShaders());
     result.setCtr(DxvkStatCounter::GpuIdleTicks,      m_submissionQueue.gpuIdleTicks());
 
+    DxvkDataBufferPoolStats dataStats = m_dataBufferPool->getStats();
+    result.setCtr(DxvkStatCounter::DataBufferAllocCount, dataStats.allocCount);
+    result.setCtr(DxvkStatCounter::DataBufferReuseCount, dataStats.reuseCount);
+
     std::lock_guard<sync::Spinlock> lock(m_statLock);
     result.merge(m_statCounters);
     return result;
@@ -188,9 +222,28 @@ namespace dxvk {
   }
 
 
+  Rc<sync::Signal> DxvkDevice::getMemoryPressureSignal() {
+    return m_objects.memoryManager().getMemoryPressureSignal();
+  }
+
+
   uint32_t DxvkDevice::getCurrentFrameId() const {
     return m_statCounters.getCtr(DxvkStatCounter::QueuePresentCount);
   }
+
+
+  void DxvkDevice::trackRenamedBuffer(
+          DxvkBuffer*               buffer) {
+    std::lock_guard<dxvk::mutex> lock(m_renamedBufferLock);
+    m_renamedBuffers.insert(buffer);
+  }
+
+
+  void DxvkDevice::untrackRenamedBuffer(
+          DxvkBuffer*               buffer) {
+    std::lock_guard<dxvk::mutex> lock(m_renamedBufferLock);
+    m_renamedBuffers.erase(buffer);
+  }
   
   
   void DxvkDevice::initResources() {
@@ -211,6 +264,15 @@ namespace dxvk {
     DxvkPresentInfo presentInfo;
     presentInfo.presenter = presenter;
     m_submissionQueue.present(presentInfo, status);
+
+    if (unlikely(m_csTracer != nullptr))
+      m_csTracer->recordFrame();
+
+    // Frame boundaries are a good time to release
+    // memory that the application no longer needs
+    this->shrinkRenamedBuffers();
+
+    m_objects.memoryManager().trim();
     
     std::lock_guard<sync::Spinlock> statLock(m_statLock);
     m_statCounters.addCtr(DxvkStatCounter::QueuePresentCount, 1);
@@ -253,6 +315,18 @@ namespace dxvk {
   }
   
   
+  void DxvkDevice::shrinkRenamedBuffers() {
+    std::lock_guard<dxvk::mutex> lock(m_renamedBufferLock);
+
+    for (auto i = m_renamedBuffers.begin(); i != m_renamedBuffers.end(); ) {
+      if (!(*i)->shrink())
+        i = m_renamedBuffers.erase(i);
+      else
+        i++;
+    }
+  }
+
+
   DxvkDevicePerfHints DxvkDevice::getPerfHints() {
     DxvkDevicePerfHints hints;
     hints.preferFbDepthStencilCopy = m_extensions.extShaderStencilExport
@@ -267,7 +341,10 @@ namespace dxvk {
 
 
   void DxvkDevice::recycleCommandList(const Rc<DxvkCommandList>& cmdList) {
-    m_recycledCommandLists.returnObject(cmdList);
+    if (cmdList->isSecondary())
+      m_recycledSecondaryLists.returnObject(cmdList);
+    else
+      m_recycledCommandLists.returnObject(cmdList);
   }
   
 
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <unordered_set>
+
 #include "dxvk_adapter.h"
 #include "dxvk_buffer.h"
 #include "dxvk_compute.h"
 #include "dxvk_constant_state.h"
 #include "dxvk_context.h"
+#include "dxvk_cs_trace.h"
 #include "dxvk_extensions.h"
 #include "dxvk_framebuffer.h"
 #include "dxvk_image.h"
@@ -74,6 +77,7 @@ namespace dxvk {
    * contexts. Multiple contexts can be created for a device.
    */
   class DxvkDevice : public RcObject {
+    friend class DxvkCommandList;
     friend class DxvkContext;
     friend class DxvkSubmissionQueue;
     friend class DxvkDescriptorPoolTracker;
@@ -223,6 +227,27 @@ namespace dxvk {
      */
     Rc<DxvkCommandList> createCommandList();
     
+    /**
+     * \brief Creates a secondary command list
+     *
+     * Secondary command lists can be recorded by any
+     * context and must be executed by a context that
+     * records a primary command list.
+     * \returns The command list
+     */
+    Rc<DxvkCommandList> createSecondaryCommandList();
+
+    /**
+     * \brief Creates a reusable secondary command list
+     *
+     * The command list can be executed any number of
+     * times once \ref DxvkCommandList::makeReusable
+     * succeeded. Reusable command lists are never
+     * recycled, since they live as long as their owner.
+     * \returns The command list
+     */
+    Rc<DxvkCommandList> createReusableCommandList();
+
     /**
      * \brief Creates a descriptor pool
      * 
@@ -294,6 +319,18 @@ namespace dxvk {
       const Rc<DxvkBuffer>&           buffer,
       const DxvkBufferViewCreateInfo& createInfo);
     
+    /**
+     * \brief Creates a data buffer
+     * 
+     * Data buffers are backed by a pool that is shared
+     * by all contexts of the device, so that storage
+     * can be reused once a buffer is no longer used.
+     * \param [in] size Minimum buffer size, in bytes
+     * \returns The data buffer object
+     */
+    Rc<DxvkDataBuffer> createDataBuffer(
+            size_t                size);
+    
     /**
      * \brief Creates an image object
      * 
@@ -370,11 +407,50 @@ namespace dxvk {
      */
     DxvkMemoryStats getMemoryStats(uint32_t heap);
 
+    /**
+     * \brief Retrieves memory pressure signal
+     *
+     * The signal value increases whenever a device-local
+     * memory heap gets close to the driver-reported budget.
+     * \returns Memory pressure signal
+     */
+    Rc<sync::Signal> getMemoryPressureSignal();
+
     /**
      * \brief Retreves current frame ID
      * \returns Current frame ID
      */
     uint32_t getCurrentFrameId() const;
+
+    /**
+     * \brief Tracks a renamed buffer
+     * 
+     * Buffers that have allocated additional backing buffers
+     * get shrunk at the end of each frame until they have
+     * released all of them, even if they are no longer
+     * being renamed. Buffers must be untracked when they
+     * get destroyed.
+     * \param [in] buffer The buffer
+     */
+    void trackRenamedBuffer(
+            DxvkBuffer*               buffer);
+
+    /**
+     * \brief Stops tracking a renamed buffer
+     * \param [in] buffer The buffer
+     */
+    void untrackRenamedBuffer(
+            DxvkBuffer*               buffer);
+
+    /**
+     * \brief Retrieves command tracer
+     *
+     * Only available if \c DXVK_CS_TRACE is set.
+     * \returns Command tracer, or \c nullptr
+     */
+    DxvkCsTracer* getCsTracer() const {
+      return m_csTracer.get();
+    }
     
     /**
      * \brief Initializes dummy resources
@@ -487,15 +563,25 @@ namespace dxvk {
 
     sync::Spinlock              m_statLock;
     DxvkStatCounters            m_statCounters;
+
+    dxvk::mutex                           m_renamedBufferLock;
+    std::unordered_set<DxvkBuffer*>       m_renamedBuffers;
+
+    Rc<DxvkDataBufferPool>      m_dataBufferPool;
+
+    std::unique_ptr<DxvkCsTracer> m_csTracer;
     
     DxvkDeviceQueueSet          m_queues;
     
     DxvkRecycler<DxvkCommandList,    16> m_recycledCommandLists;
+    DxvkRecycler<DxvkCommandList,    16> m_recycledSecondaryLists;
     DxvkRecycler<DxvkDescriptorPool, 16> m_recycledDescriptorPools;
     
     DxvkSubmissionQueue m_submissionQueue;
 
     DxvkDevicePerfHints getPerfHints();
+
+    void shrinkRenamedBuffers();
     
     void recycleCommandList(
       const Rc<DxvkCommandList>& cmdList);
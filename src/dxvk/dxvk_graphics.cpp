@@ -41,8 +41,10 @@ namespace dxvk {
   
   
   DxvkGraphicsPipeline::~DxvkGraphicsPipeline() {
-    for (const auto& instance : m_pipelines)
+    m_pipelines.forEach([this] (const DxvkGraphicsPipelineInstance& instance) {
       this->destroyPipeline(instance.pipeline());
+      this->destroyPipeline(instance.fastPipeline());
+    });
   }
   
   
@@ -62,67 +64,173 @@ namespace dxvk {
 
   VkPipeline DxvkGraphicsPipeline::getPipelineHandle(
     const DxvkGraphicsPipelineStateInfo& state,
-    const DxvkRenderPass*                renderPass) {
+          size_t                         stateHash,
+    const DxvkRenderPass*                renderPass,
+          bool&                          optimizing) {
     DxvkGraphicsPipelineInstance* instance = nullptr;
+    bool isNewInstance = false;
+
+    optimizing = false;
 
     { std::lock_guard<sync::Spinlock> lock(m_mutex);
     
-      instance = this->findInstance(state, renderPass);
+      instance = this->findInstance(state, stateHash, renderPass);
       
-      if (instance)
+      if (instance && instance->isReady()) {
+        optimizing = instance->isOptimizing();
         return instance->pipeline();
+      }
       
-      instance = this->createInstance(state, renderPass);
+      if (!instance) {
+        instance = this->createInstance(state, stateHash, renderPass);
+        isNewInstance = true;
+      }
     }
     
     if (!instance)
       return VK_NULL_HANDLE;
 
+    // In async mode, skip the draw rather than stalling until
+    // the pipeline is ready, unless skipping it would lose
+    // side effects that later commands may depend on.
+    if (m_pipeMgr->useAsyncCompilation() && !m_flags.any(
+          DxvkGraphicsPipelineFlag::HasTransformFeedback,
+          DxvkGraphicsPipelineFlag::HasStorageDescriptors)) {
+      if (isNewInstance) {
+        m_pipeMgr->compileAsync([this, instance, state, renderPass] {
+          this->compileInstance(instance, state, renderPass, 0);
+          this->writePipelineStateToCache(state, renderPass->format());
+        });
+      }
+
+      return VK_NULL_HANDLE;
+    }
+
+    // If another thread is already compiling this
+    // pipeline, wait for it rather than compiling
+    // the same pipeline twice.
+    if (!isNewInstance)
+      return this->waitForInstance(instance, optimizing);
+
+    // With fast compilation, get an unoptimized pipeline out as
+    // quickly as possible and swap in the optimized one later.
+    bool fastCompile = m_pipeMgr->useFastCompilation();
+
+    VkPipeline pipeline = this->compileInstance(instance, state, renderPass,
+      fastCompile ? VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT : 0);
+
+    if (fastCompile && pipeline) {
+      m_pipeMgr->compileAsync([this, instance, state, renderPass] {
+        this->optimizeInstance(instance, state, renderPass);
+      });
+
+      optimizing = true;
+    }
+
     this->writePipelineStateToCache(state, renderPass->format());
-    return instance->pipeline();
+    return pipeline;
   }
 
 
   void DxvkGraphicsPipeline::compilePipeline(
     const DxvkGraphicsPipelineStateInfo& state,
     const DxvkRenderPass*                renderPass) {
-    std::lock_guard<sync::Spinlock> lock(m_mutex);
+    size_t stateHash = state.hash();
+
+    DxvkGraphicsPipelineInstance* instance = nullptr;
+
+    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+      if (this->findInstance(state, stateHash, renderPass))
+        return;
+
+      instance = this->createInstance(state, stateHash, renderPass);
+    }
 
-    if (!this->findInstance(state, renderPass))
-      this->createInstance(state, renderPass);
+    if (instance)
+      this->compileInstance(instance, state, renderPass, 0);
   }
 
 
   DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::createInstance(
     const DxvkGraphicsPipelineStateInfo& state,
+          size_t                         stateHash,
     const DxvkRenderPass*                renderPass) {
     // If the pipeline state vector is invalid, don't try
     // to create a new pipeline, it won't work anyway.
     if (!this->validatePipelineState(state))
       return nullptr;
 
-    VkPipeline newPipelineHandle = this->createPipeline(state, renderPass);
-
+    // The pipeline itself gets compiled without holding the
+    // lock, so that lookups of other instances don't stall.
     m_pipeMgr->m_numGraphicsPipelines += 1;
-    return &m_pipelines.emplace_back(state, renderPass, newPipelineHandle);
+    return m_pipelines.add(state, stateHash, renderPass);
   }
   
   
   DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
     const DxvkGraphicsPipelineStateInfo& state,
+          size_t                         stateHash,
     const DxvkRenderPass*                renderPass) {
-    for (auto& instance : m_pipelines) {
-      if (instance.isCompatible(state, renderPass))
-        return &instance;
+    return m_pipelines.find(state, stateHash, renderPass);
+  }
+
+
+  VkPipeline DxvkGraphicsPipeline::compileInstance(
+          DxvkGraphicsPipelineInstance*  instance,
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass*                renderPass,
+          VkPipelineCreateFlags          flags) {
+    VkPipeline pipeline = this->createPipeline(state, renderPass, flags);
+
+    // Unoptimized pipelines get replaced by optimizeInstance
+    bool optimizing = pipeline
+      && (flags & VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT);
+
+    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+      instance->setPipeline(pipeline, optimizing);
     }
-    
-    return nullptr;
+
+    // Wake up any threads waiting for this instance. Waiters check
+    // the instance while holding the mutex, so this cannot race.
+    std::lock_guard<dxvk::mutex> lock(m_compileMutex);
+    m_compileCond.notify_all();
+    return pipeline;
+  }
+
+
+  void DxvkGraphicsPipeline::optimizeInstance(
+          DxvkGraphicsPipelineInstance*  instance,
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass*                renderPass) {
+    VkPipeline pipeline = this->createPipeline(state, renderPass, 0);
+
+    // Keep using the unoptimized pipeline if this fails
+    std::lock_guard<sync::Spinlock> lock(m_mutex);
+    instance->setOptimizedPipeline(pipeline);
+  }
+
+
+  VkPipeline DxvkGraphicsPipeline::waitForInstance(
+          DxvkGraphicsPipelineInstance*  instance,
+          bool&                          optimizing) {
+    std::unique_lock<dxvk::mutex> lock(m_compileMutex);
+
+    m_compileCond.wait(lock, [this, instance] {
+      std::lock_guard<sync::Spinlock> spinLock(m_mutex);
+      return instance->isReady();
+    });
+
+    std::lock_guard<sync::Spinlock> spinLock(m_mutex);
+    optimizing = instance->isOptimizing();
+    return instance->pipeline();
   }
   
   
   VkPipeline DxvkGraphicsPipeline::createPipeline(
     const DxvkGraphicsPipelineStateInfo& state,
-    const DxvkRenderPass*                renderPass) const {
+    const DxvkRenderPass*                renderPass,
+          VkPipelineCreateFlags          flags) const {
     if (Logger::logLevel() <= LogLevel::Debug) {
       Logger::debug("Compiling graphics pipeline...");
       this->logPipelineState(LogLevel::Debug, state);
@@ -382,7 +490,7 @@ namespace dxvk {
     VkGraphicsPipelineCreateInfo info;
     info.sType                    = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     info.pNext                    = nullptr;
-    info.flags                    = 0;
+    info.flags                    = flags;
     info.stageCount               = stages.size();
     info.pStages                  = stages.data();
     info.pVertexInputState        = &viInfo;
@@ -423,6 +531,7 @@ namespace dxvk {
       Logger::debug(str::format("DxvkGraphicsPipeline: Finished in ", td.count(), " ms"));
     }
 
+    m_pipeMgr->m_cache->notifyPipelineCompiled();
     return pipeline;
   }
   
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mutex>
+#include <unordered_map>
 
 #include "dxvk_bind_mask.h"
 #include "dxvk_constant_state.h"
@@ -81,7 +82,20 @@ namespace dxvk {
     DxvkGraphicsPipelineInstance()
     : m_stateVector (),
       m_renderPass  (VK_NULL_HANDLE),
-      m_pipeline    (VK_NULL_HANDLE) { }
+      m_pipeline    (VK_NULL_HANDLE),
+      m_fastPipeline(VK_NULL_HANDLE),
+      m_ready       (false),
+      m_optimizing  (false) { }
+
+    DxvkGraphicsPipelineInstance(
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPass*                 rp)
+    : m_stateVector (state),
+      m_renderPass  (rp),
+      m_pipeline    (VK_NULL_HANDLE),
+      m_fastPipeline(VK_NULL_HANDLE),
+      m_ready       (false),
+      m_optimizing  (false) { }
 
     DxvkGraphicsPipelineInstance(
       const DxvkGraphicsPipelineStateInfo&  state,
@@ -89,7 +103,10 @@ namespace dxvk {
             VkPipeline                      pipe)
     : m_stateVector (state),
       m_renderPass  (rp),
-      m_pipeline    (pipe) { }
+      m_pipeline    (pipe),
+      m_fastPipeline(VK_NULL_HANDLE),
+      m_ready       (true),
+      m_optimizing  (false) { }
 
     /**
      * \brief Checks for matching pipeline state
@@ -105,6 +122,17 @@ namespace dxvk {
           && m_stateVector == state;
     }
 
+    /**
+     * \brief Checks whether the pipeline is compiled
+     *
+     * If this returns \c false, the pipeline is
+     * still being compiled by another thread.
+     * \returns \c true if the pipeline is compiled
+     */
+    bool isReady() const {
+      return m_ready;
+    }
+
     /**
      * \brief Retrieves pipeline
      * \returns The pipeline handle
@@ -113,11 +141,149 @@ namespace dxvk {
       return m_pipeline;
     }
 
+    /**
+     * \brief Checks whether the pipeline is being optimized
+     *
+     * If this returns \c true, the current pipeline is an
+     * unoptimized one that will be replaced later.
+     * \returns \c true if the pipeline is being optimized
+     */
+    bool isOptimizing() const {
+      return m_optimizing;
+    }
+
+    /**
+     * \brief Sets compiled pipeline
+     *
+     * Marks the instance as ready. The pipeline
+     * handle may be \c VK_NULL_HANDLE if the
+     * pipeline failed to compile.
+     * \param [in] pipe The pipeline handle
+     * \param [in] optimizing Whether an optimized
+     *    pipeline will be set later
+     */
+    void setPipeline(VkPipeline pipe, bool optimizing) {
+      m_pipeline   = pipe;
+      m_ready      = true;
+      m_optimizing = optimizing;
+    }
+
+    /**
+     * \brief Retrieves unoptimized pipeline
+     *
+     * Only set after the pipeline was replaced by an
+     * optimized one, and kept alive for as long as the
+     * instance since command buffers may still use it.
+     * \returns The unoptimized pipeline handle
+     */
+    VkPipeline fastPipeline() const {
+      return m_fastPipeline;
+    }
+
+    /**
+     * \brief Replaces unoptimized pipeline
+     *
+     * Swaps in a pipeline that was compiled with full
+     * optimizations after the instance became ready.
+     * \param [in] pipe The optimized pipeline handle, or
+     *    \c VK_NULL_HANDLE to keep the current pipeline
+     */
+    void setOptimizedPipeline(VkPipeline pipe) {
+      if (pipe)
+        m_fastPipeline = std::exchange(m_pipeline, pipe);
+
+      m_optimizing = false;
+    }
+
   private:
 
     DxvkGraphicsPipelineStateInfo m_stateVector;
     const DxvkRenderPass*         m_renderPass;
     VkPipeline                    m_pipeline;
+    VkPipeline                    m_fastPipeline;
+    bool                          m_ready;
+    bool                          m_optimizing;
+
+  };
+
+
+  /**
+   * \brief Graphics pipeline instance table
+   *
+   * Indexes pipeline instances by the hash of their state
+   * vector and render pass, so that a lookup only needs to
+   * compare the full state vector against instances that
+   * are likely to match, rather than all of them.
+   */
+  class DxvkGraphicsPipelineInstanceTable {
+
+  public:
+
+    /**
+     * \brief Looks up pipeline instance
+     *
+     * \param [in] state Pipeline state vector
+     * \param [in] stateHash Hash of the state vector
+     * \param [in] rp Render pass
+     * \returns Matching instance, or \c nullptr
+     */
+    DxvkGraphicsPipelineInstance* find(
+      const DxvkGraphicsPipelineStateInfo&  state,
+            size_t                          stateHash,
+      const DxvkRenderPass*                 rp) {
+      auto range = m_instances.equal_range(getKey(stateHash, rp));
+
+      for (auto i = range.first; i != range.second; i++) {
+        if (i->second.isCompatible(state, rp))
+          return &i->second;
+      }
+
+      return nullptr;
+    }
+
+    /**
+     * \brief Adds pipeline instance
+     *
+     * Pointers to existing instances remain
+     * valid when new instances get added.
+     * \param [in] state Pipeline state vector
+     * \param [in] stateHash Hash of the state vector
+     * \param [in] rp Render pass
+     * \param [in] args Pipeline handle, if any
+     * \returns The new instance
+     */
+    template<typename... Args>
+    DxvkGraphicsPipelineInstance* add(
+      const DxvkGraphicsPipelineStateInfo&  state,
+            size_t                          stateHash,
+      const DxvkRenderPass*                 rp,
+            Args&&...                       args) {
+      auto entry = m_instances.emplace(std::piecewise_construct,
+        std::forward_as_tuple(getKey(stateHash, rp)),
+        std::forward_as_tuple(state, rp, std::forward<Args>(args)...));
+      return &entry->second;
+    }
+
+    /**
+     * \brief Iterates over all instances
+     * \param [in] proc Function to call for each instance
+     */
+    template<typename Proc>
+    void forEach(const Proc& proc) const {
+      for (const auto& entry : m_instances)
+        proc(entry.second);
+    }
+
+  private:
+
+    std::unordered_multimap<size_t, DxvkGraphicsPipelineInstance> m_instances;
+
+    static size_t getKey(size_t stateHash, const DxvkRenderPass* rp) {
+      DxvkHashState key;
+      key.add(stateHash);
+      key.add(std::hash<const DxvkRenderPass*>()(rp));
+      return key;
+    }
 
   };
 
@@ -183,13 +349,20 @@ namespace dxvk {
      * 
      * Retrieves a pipeline handle for the given pipeline
      * state. If necessary, a new pipeline will be created.
+     * If asynchronous compilation is enabled, this may
+     * return \c VK_NULL_HANDLE until the pipeline is ready.
      * \param [in] state Pipeline state vector
+     * \param [in] stateHash Hash of the state vector
      * \param [in] renderPass The render pass
+     * \param [out] optimizing Set to \c true if the returned
+     *    pipeline is unoptimized and will be replaced later
      * \returns Pipeline handle
      */
     VkPipeline getPipelineHandle(
       const DxvkGraphicsPipelineStateInfo&    state,
-      const DxvkRenderPass*                   renderPass);
+            size_t                            stateHash,
+      const DxvkRenderPass*                   renderPass,
+            bool&                             optimizing);
     
     /**
      * \brief Compiles a pipeline
@@ -219,21 +392,43 @@ namespace dxvk {
     DxvkGraphicsPipelineFlags           m_flags;
     DxvkGraphicsCommonPipelineStateInfo m_common;
     
-    // List of pipeline instances, shared between threads
-    alignas(CACHE_LINE_SIZE) sync::Spinlock   m_mutex;
-    std::vector<DxvkGraphicsPipelineInstance> m_pipelines;
+    // Table of pipeline instances, shared between threads
+    alignas(CACHE_LINE_SIZE) sync::Spinlock m_mutex;
+    DxvkGraphicsPipelineInstanceTable       m_pipelines;
+
+    // Used to wait for instances compiled by other threads
+    dxvk::mutex                             m_compileMutex;
+    dxvk::condition_variable                m_compileCond;
     
     DxvkGraphicsPipelineInstance* createInstance(
       const DxvkGraphicsPipelineStateInfo& state,
+            size_t                         stateHash,
       const DxvkRenderPass*                renderPass);
     
     DxvkGraphicsPipelineInstance* findInstance(
+      const DxvkGraphicsPipelineStateInfo& state,
+            size_t                         stateHash,
+      const DxvkRenderPass*                renderPass);
+
+    VkPipeline compileInstance(
+            DxvkGraphicsPipelineInstance*  instance,
+      const DxvkGraphicsPipelineStateInfo& state,
+      const DxvkRenderPass*                renderPass,
+            VkPipelineCreateFlags          flags);
+
+    void optimizeInstance(
+            DxvkGraphicsPipelineInstance*  instance,
       const DxvkGraphicsPipelineStateInfo& state,
       const DxvkRenderPass*                renderPass);
+
+    VkPipeline waitForInstance(
+            DxvkGraphicsPipelineInstance*  instance,
+            bool&                          optimizing);
     
     VkPipeline createPipeline(
       const DxvkGraphicsPipelineStateInfo& state,
-      const DxvkRenderPass*                renderPass) const;
+      const DxvkRenderPass*                renderPass,
+            VkPipelineCreateFlags          flags) const;
     
     void destroyPipeline(
             VkPipeline                     pipeline) const;
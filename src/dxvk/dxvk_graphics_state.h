@@ -653,6 +653,10 @@ namespace dxvk {
       return !bit::bcmpeq(this, &other);
     }
 
+    size_t hash() const {
+      return bit::bhash(this);
+    }
+
     bool useDynamicStencilRef() const {
       return ds.enableStencilTest();
     }
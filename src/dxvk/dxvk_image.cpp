@@ -102,6 +102,9 @@ namespace dxvk {
     // Ask driver whether we should be using a dedicated allocation
     m_image.memory = memAlloc.alloc(&memReq.memoryRequirements,
       dedicatedRequirements, dedMemoryAllocInfo, memFlags, priority);
+
+    // Images are never relocated
+    memAlloc.pinMemory(m_image.memory);
     
     // Try to bind the allocated memory slice to the image
     if (m_vkd->vkBindImageMemory(m_vkd->device(), m_image.image,
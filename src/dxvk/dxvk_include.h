@@ -16,6 +16,7 @@
 
 #include "../util/sha1/sha1_util.h"
 
+#include "../util/sync/sync_queue.h"
 #include "../util/sync/sync_signal.h"
 #include "../util/sync/sync_spinlock.h"
 #include "../util/sync/sync_ticketlock.h"
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "dxvk_lifetime.h"
 
 namespace dxvk {
@@ -6,10 +8,72 @@ namespace dxvk {
   DxvkLifetimeTracker::~DxvkLifetimeTracker() { }
   
   
-  void DxvkLifetimeTracker::reset() {
+  void DxvkLifetimeTracker::trackResources(const DxvkLifetimeTracker& tracker) {
+    for (const auto& resource : tracker.m_resources) {
+      resource.first->acquire(resource.second);
+      m_resources.push_back(resource);
+    }
+  }
+
+
+  void DxvkLifetimeTracker::detach() {
     for (const auto& resource : m_resources)
       resource.first->release(resource.second);
+
+    // Resources are usually tracked once per command, so merge
+    // duplicates, keeping the strongest access for each one
+    std::sort(m_resources.begin(), m_resources.end(),
+      [] (const auto& a, const auto& b) {
+        return a.first.ptr() < b.first.ptr();
+      });
+
+    size_t count = 0;
+
+    for (size_t i = 0; i < m_resources.size(); i++) {
+      if (count && m_resources[count - 1].first == m_resources[i].first) {
+        DxvkAccess& access = m_resources[count - 1].second;
+
+        if (m_resources[i].second == DxvkAccess::Write || access == DxvkAccess::None)
+          access = m_resources[i].second;
+      } else {
+        if (count != i)
+          m_resources[count] = std::move(m_resources[i]);
+        count += 1;
+      }
+    }
+
+    m_resources.resize(count);
+
+    m_versions.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+      m_versions[i] = m_resources[i].first->getVersion();
+
+    m_detached = true;
+  }
+
+
+  bool DxvkLifetimeTracker::hasChangedResources() const {
+    for (size_t i = 0; i < m_versions.size(); i++) {
+      if (m_resources[i].first->getVersion() != m_versions[i])
+        return true;
+    }
+
+    return false;
+  }
+
+
+  void DxvkLifetimeTracker::reset() {
+    if (!m_detached) {
+      for (const auto& resource : m_resources)
+        resource.first->release(resource.second);
+    }
+
     m_resources.clear();
+    m_versions.clear();
+
+    m_detached      = false;
+    m_trackVersions = false;
   }
   
 }
\ No newline at end of file
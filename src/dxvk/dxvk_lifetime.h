@@ -28,9 +28,56 @@ namespace dxvk {
     template<DxvkAccess Access>
     void trackResource(Rc<DxvkResource>&& rc) {
       rc->acquire(Access);
+
+      if (unlikely(m_trackVersions))
+        m_versions.push_back(rc->getVersion());
+
       m_resources.emplace_back(std::move(rc), Access);
     }
+
+    /**
+     * \brief Enables version tracking
+     *
+     * Stores the storage version of each resource at the
+     * time it gets tracked, so that \ref hasChangedResources
+     * can be used without detaching. Must be called before
+     * any resources are tracked.
+     */
+    void trackVersions() {
+      m_trackVersions = true;
+    }
     
+    /**
+     * \brief Tracks resources of another tracker
+     *
+     * Acquires all resources of the given tracker
+     * again, so that they stay in use until this
+     * tracker gets reset.
+     * \param [in] tracker The tracker to copy
+     */
+    void trackResources(const DxvkLifetimeTracker& tracker);
+
+    /**
+     * \brief Releases resources but keeps them alive
+     *
+     * Marks all tracked resources as unused, removes
+     * duplicate entries and stores the current storage
+     * version of each resource. Used by command lists
+     * that get executed multiple times, which must not
+     * keep their resources in use while idle.
+     */
+    void detach();
+
+    /**
+     * \brief Checks whether any resource has changed
+     *
+     * Only meaningful after \ref detach was called,
+     * or if version tracking has been enabled.
+     * \returns \c true if the backing storage of any
+     *    tracked resource has changed since then
+     */
+    bool hasChangedResources() const;
+
     /**
      * \brief Resets the command list
      * 
@@ -42,6 +89,10 @@ namespace dxvk {
   private:
     
     std::vector<std::pair<Rc<DxvkResource>, DxvkAccess>> m_resources;
+    std::vector<uint32_t>                                m_versions;
+
+    bool m_detached      = false;
+    bool m_trackVersions = false;
     
   };
   
@@ -11,6 +11,7 @@ namespace dxvk {
           VkDeviceMemory        memory,
           VkDeviceSize          offset,
           VkDeviceSize          length,
+          uint32_t              block,
           void*                 mapPtr)
   : m_alloc   (alloc),
     m_chunk   (chunk),
@@ -18,6 +19,7 @@ namespace dxvk {
     m_memory  (memory),
     m_offset  (offset),
     m_length  (length),
+    m_block   (block),
     m_mapPtr  (mapPtr) { }
   
   
@@ -28,7 +30,10 @@ namespace dxvk {
     m_memory  (std::exchange(other.m_memory, VkDeviceMemory(VK_NULL_HANDLE))),
     m_offset  (std::exchange(other.m_offset, 0)),
     m_length  (std::exchange(other.m_length, 0)),
-    m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)) { }
+    m_block   (std::exchange(other.m_block,  0)),
+    m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)),
+    m_cached  (std::exchange(other.m_cached, false)),
+    m_pinned  (std::exchange(other.m_pinned, false)) { }
   
   
   DxvkMemory& DxvkMemory::operator = (DxvkMemory&& other) {
@@ -39,7 +44,10 @@ namespace dxvk {
     m_memory  = std::exchange(other.m_memory, VkDeviceMemory(VK_NULL_HANDLE));
     m_offset  = std::exchange(other.m_offset, 0);
     m_length  = std::exchange(other.m_length, 0);
+    m_block   = std::exchange(other.m_block,  0);
     m_mapPtr  = std::exchange(other.m_mapPtr, nullptr);
+    m_cached  = std::exchange(other.m_cached, false);
+    m_pinned  = std::exchange(other.m_pinned, false);
     return *this;
   }
   
@@ -55,19 +63,326 @@ namespace dxvk {
   }
   
 
+  DxvkMemoryRangeAllocator::DxvkMemoryRangeAllocator(VkDeviceSize size)
+  : m_size(size) {
+    for (auto& heads : m_freeHeads)
+      heads.fill(Invalid);
+
+    // Mark the entire memory block as free
+    uint32_t block = createBlock();
+    m_blocks[block].offset   = 0;
+    m_blocks[block].length   = size;
+    m_blocks[block].prevPhys = Invalid;
+    m_blocks[block].nextPhys = Invalid;
+
+    insertFreeBlock(block);
+  }
+
+
+  DxvkMemoryRangeAllocator::~DxvkMemoryRangeAllocator() {
+
+  }
+
+
+  bool DxvkMemoryRangeAllocator::alloc(
+          VkDeviceSize          size,
+          VkDeviceSize          align,
+          VkDeviceSize&         offset,
+          VkDeviceSize&         length,
+          uint32_t&             index) {
+    const VkDeviceSize allocSize = dxvk::align(size, align);
+
+    uint32_t block = findFreeBlock(allocSize, align);
+
+    if (block == Invalid)
+      return false;
+
+    removeFreeBlock(block);
+
+    // Split off any padding required to meet the
+    // alignment requirement and keep it as a free
+    // block. This cannot be merged with the previous
+    // block since that is known to be in use.
+    const VkDeviceSize blockStart = m_blocks[block].offset;
+    const VkDeviceSize allocStart = dxvk::align(blockStart, align);
+
+    if (allocStart != blockStart) {
+      uint32_t next = splitBlock(block, allocStart - blockStart);
+      insertFreeBlock(block);
+      block = next;
+    }
+
+    // Return the unused tail of the block to the free list
+    if (m_blocks[block].length != allocSize)
+      insertFreeBlock(splitBlock(block, allocSize));
+
+    m_used += allocSize;
+
+    offset = allocStart;
+    length = allocSize;
+    index  = block;
+    return true;
+  }
+
+
+  void DxvkMemoryRangeAllocator::free(
+          uint32_t              block) {
+    if (block >= m_blocks.size() || m_blocks[block].isFree) {
+      Logger::err(str::format("DxvkMemoryRangeAllocator: Invalid free: block ", block));
+      return;
+    }
+
+    m_used -= m_blocks[block].length;
+
+    // Merge with adjacent free blocks. Since two free
+    // blocks are never adjacent, this needs to look
+    // at the immediate neighbours only.
+    uint32_t prev = m_blocks[block].prevPhys;
+
+    if (prev != Invalid && m_blocks[prev].isFree) {
+      removeFreeBlock(prev);
+      mergeBlocks(prev, block);
+      block = prev;
+    }
+
+    uint32_t next = m_blocks[block].nextPhys;
+
+    if (next != Invalid && m_blocks[next].isFree) {
+      removeFreeBlock(next);
+      mergeBlocks(block, next);
+    }
+
+    insertFreeBlock(block);
+  }
+
+
+  VkDeviceSize DxvkMemoryRangeAllocator::largestFreeRange() const {
+    if (!m_flMask)
+      return 0;
+
+    uint32_t fl = 31 - bit::lzcnt(m_flMask);
+    uint32_t sl = 31 - bit::lzcnt(m_slMasks[fl]);
+
+    VkDeviceSize result = 0;
+
+    for (uint32_t b = m_freeHeads[fl][sl]; b != Invalid; b = m_blocks[b].nextFree)
+      result = std::max(result, m_blocks[b].length);
+
+    return result;
+  }
+
+
+  uint32_t DxvkMemoryRangeAllocator::findFreeBlock(
+          VkDeviceSize          size,
+          VkDeviceSize          align) const {
+    // Any block in the next larger size class is guaranteed to be
+    // large enough. Try that first and only take the alignment into
+    // account if the block we found cannot be used as-is.
+    uint32_t block = searchFreeBlock(size);
+
+    if (block != Invalid && blockFits(block, size, align))
+      return block;
+
+    if (align > 1) {
+      block = searchFreeBlock(size + align - 1);
+
+      if (block != Invalid)
+        return block;
+    }
+
+    // Rounding up the size class may skip blocks that are large
+    // enough, which matters if the chunk is nearly full. Scan the
+    // list for the exact size class as a last resort.
+    uint32_t fl, sl;
+    computeSizeClass(size, fl, sl);
+
+    if (fl >= FlCount)
+      return Invalid;
+
+    for (uint32_t b = m_freeHeads[fl][sl]; b != Invalid; b = m_blocks[b].nextFree) {
+      if (blockFits(b, size, align))
+        return b;
+    }
+
+    return Invalid;
+  }
+
+
+  uint32_t DxvkMemoryRangeAllocator::searchFreeBlock(
+          VkDeviceSize          size) const {
+    if (size >= SlCount)
+      size += (VkDeviceSize(1) << (63 - bit::lzcnt(uint64_t(size)) - SlBits)) - 1;
+
+    uint32_t fl, sl;
+    computeSizeClass(size, fl, sl);
+
+    if (fl >= FlCount)
+      return Invalid;
+
+    uint32_t slMask = m_slMasks[fl] & (~0u << sl);
+
+    if (!slMask) {
+      uint32_t flMask = fl + 1 < FlCount
+        ? m_flMask & (~0u << (fl + 1))
+        : 0u;
+
+      if (!flMask)
+        return Invalid;
+
+      fl = bit::tzcnt(flMask);
+      slMask = m_slMasks[fl];
+    }
+
+    sl = bit::tzcnt(slMask);
+    return m_freeHeads[fl][sl];
+  }
+
+
+  void DxvkMemoryRangeAllocator::insertFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    computeSizeClass(m_blocks[block].length, fl, sl);
+
+    uint32_t head = m_freeHeads[fl][sl];
+
+    m_blocks[block].isFree   = true;
+    m_blocks[block].prevFree = Invalid;
+    m_blocks[block].nextFree = head;
+
+    if (head != Invalid)
+      m_blocks[head].prevFree = block;
+
+    m_freeHeads[fl][sl] = block;
+    m_slMasks[fl] |= 1u << sl;
+    m_flMask |= 1u << fl;
+  }
+
+
+  void DxvkMemoryRangeAllocator::removeFreeBlock(
+          uint32_t              block) {
+    uint32_t prev = m_blocks[block].prevFree;
+    uint32_t next = m_blocks[block].nextFree;
+
+    if (next != Invalid)
+      m_blocks[next].prevFree = prev;
+
+    if (prev != Invalid) {
+      m_blocks[prev].nextFree = next;
+    } else {
+      uint32_t fl, sl;
+      computeSizeClass(m_blocks[block].length, fl, sl);
+
+      m_freeHeads[fl][sl] = next;
+
+      if (next == Invalid) {
+        m_slMasks[fl] &= ~(1u << sl);
+
+        if (!m_slMasks[fl])
+          m_flMask &= ~(1u << fl);
+      }
+    }
+
+    m_blocks[block].isFree = false;
+  }
+
+
+  uint32_t DxvkMemoryRangeAllocator::splitBlock(
+          uint32_t              block,
+          VkDeviceSize          length) {
+    // Creating the block may reallocate the array,
+    // so we can't keep references across the call
+    uint32_t tail = createBlock();
+    uint32_t next = m_blocks[block].nextPhys;
+
+    m_blocks[tail].offset   = m_blocks[block].offset + length;
+    m_blocks[tail].length   = m_blocks[block].length - length;
+    m_blocks[tail].prevPhys = block;
+    m_blocks[tail].nextPhys = next;
+
+    if (next != Invalid)
+      m_blocks[next].prevPhys = tail;
+
+    m_blocks[block].length   = length;
+    m_blocks[block].nextPhys = tail;
+    return tail;
+  }
+
+
+  void DxvkMemoryRangeAllocator::mergeBlocks(
+          uint32_t              block,
+          uint32_t              next) {
+    uint32_t nextNext = m_blocks[next].nextPhys;
+
+    m_blocks[block].length  += m_blocks[next].length;
+    m_blocks[block].nextPhys = nextNext;
+
+    if (nextNext != Invalid)
+      m_blocks[nextNext].prevPhys = block;
+
+    // Flag the recycled block as free so that a stale
+    // free call passing its index gets rejected
+    m_blocks[next].isFree = true;
+    m_unusedBlocks.push_back(next);
+  }
+
+
+  uint32_t DxvkMemoryRangeAllocator::createBlock() {
+    uint32_t block;
+
+    if (!m_unusedBlocks.empty()) {
+      block = m_unusedBlocks.back();
+      m_unusedBlocks.pop_back();
+    } else {
+      block = uint32_t(m_blocks.size());
+      m_blocks.emplace_back();
+    }
+
+    m_blocks[block].prevFree = Invalid;
+    m_blocks[block].nextFree = Invalid;
+    m_blocks[block].isFree   = false;
+    return block;
+  }
+
+
+  bool DxvkMemoryRangeAllocator::blockFits(
+          uint32_t              block,
+          VkDeviceSize          size,
+          VkDeviceSize          align) const {
+    const VkDeviceSize blockStart = m_blocks[block].offset;
+    const VkDeviceSize blockEnd   = m_blocks[block].offset + m_blocks[block].length;
+    return dxvk::align(blockStart, align) + size <= blockEnd;
+  }
+
+
+  void DxvkMemoryRangeAllocator::computeSizeClass(
+          VkDeviceSize          size,
+          uint32_t&             fl,
+          uint32_t&             sl) {
+    if (size < SlCount) {
+      fl = 0;
+      sl = uint32_t(size);
+    } else {
+      uint32_t msb = 63 - bit::lzcnt(uint64_t(size));
+      fl = msb - SlBits + 1;
+      sl = uint32_t(size >> (msb - SlBits)) - SlCount;
+    }
+  }
+
+
   DxvkMemoryChunk::DxvkMemoryChunk(
           DxvkMemoryAllocator*  alloc,
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory)
-  : m_alloc(alloc), m_type(type), m_memory(memory) {
-    // Mark the entire chunk as free
-    m_freeList.push_back(FreeSlice { 0, memory.memSize });
+  : m_alloc(alloc), m_type(type), m_memory(memory),
+    m_allocator(memory.memSize) {
+
   }
   
   
   DxvkMemoryChunk::~DxvkMemoryChunk() {
-    // This call is technically not thread-safe, but it
-    // doesn't need to be since we don't free chunks
+    // Chunks are only destroyed when the allocator gets
+    // destroyed or trims the chunk, in which case the
+    // allocator lock is already held.
     m_alloc->freeDeviceMemory(m_type, m_memory);
   }
   
@@ -79,93 +394,53 @@ namespace dxvk {
           float                 priority) {
     // Property flags must be compatible. This could
     // be refined a bit in the future if necessary.
-    if (m_memory.memFlags != flags
-     || m_memory.priority != priority)
-      return DxvkMemory();
-    
-    // If the chunk is full, return
-    if (m_freeList.size() == 0)
+    if (!isCompatible(flags, priority) || isEvacuating())
       return DxvkMemory();
     
-    // Select the slice to allocate from in a worst-fit
-    // manner. This may help keep fragmentation low.
-    auto bestSlice = m_freeList.begin();
-    
-    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
-      if (slice->length == size) {
-        bestSlice = slice;
-        break;
-      } else if (slice->length > bestSlice->length) {
-        bestSlice = slice;
-      }
-    }
-    
-    // We need to align the allocation to the requested alignment
-    const VkDeviceSize sliceStart = bestSlice->offset;
-    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
-    
-    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
-    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
-    
-    if (allocEnd > sliceEnd)
+    VkDeviceSize offset = 0;
+    VkDeviceSize length = 0;
+    uint32_t     block  = 0;
+
+    if (!m_allocator.alloc(size, align, offset, length, block))
       return DxvkMemory();
     
-    // We can use this slice, but we'll have to add
-    // the unused parts of it back to the free list.
-    m_freeList.erase(bestSlice);
-    
-    if (allocStart != sliceStart)
-      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-    
-    if (allocEnd != sliceEnd)
-      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
-    
+    m_active = true;
+
     // Create the memory object with the aligned slice
     return DxvkMemory(m_alloc, this, m_type,
-      m_memory.memHandle, allocStart, allocEnd - allocStart,
-      reinterpret_cast<char*>(m_memory.memPointer) + allocStart);
+      m_memory.memHandle, offset, length, block,
+      reinterpret_cast<char*>(m_memory.memPointer) + offset);
   }
   
   
   void DxvkMemoryChunk::free(
-          VkDeviceSize  offset,
-          VkDeviceSize  length) {
-    // Remove adjacent entries from the free list and then add
-    // a new slice that covers all those entries. Without doing
-    // so, the slice could not be reused for larger allocations.
-    auto curr = m_freeList.begin();
-    
-    while (curr != m_freeList.end()) {
-      if (curr->offset == offset + length) {
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else if (curr->offset + curr->length == offset) {
-        offset -= curr->length;
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else {
-        curr++;
-      }
-    }
-    
-    m_freeList.push_back({ offset, length });
+          uint32_t      block) {
+    m_allocator.free(block);
   }
   
   
   DxvkMemoryAllocator::DxvkMemoryAllocator(const DxvkDevice* device)
-  : m_vkd             (device->vkd()),
-    m_device          (device),
-    m_devProps        (device->adapter()->deviceProperties()),
-    m_memProps        (device->adapter()->memoryProperties()) {
+  : DxvkMemoryAllocator(device->vkd(), getAllocatorInfo(device)) {
+    m_device = device;
+  }
+
+
+  DxvkMemoryAllocator::DxvkMemoryAllocator(
+    const Rc<vk::DeviceFn>&           vkd,
+    const DxvkMemoryAllocatorInfo&    info)
+  : m_vkd             (vkd),
+    m_info            (info),
+    m_devProps        (info.deviceProperties),
+    m_memProps        (info.memoryProperties),
+    m_pressureSignal  (new sync::Fence()) {
     for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
       m_memHeaps[i].properties = m_memProps.memoryHeaps[i];
-      m_memHeaps[i].stats      = DxvkMemoryStats { 0, 0 };
       m_memHeaps[i].budget     = 0;
 
       /* Target 80% of a heap on systems where we want
        * to avoid oversubscribing memory heaps */
       if ((m_memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
-       && (m_device->isUnifiedMemoryArchitecture()))
+       && (m_info.unifiedMemory))
         m_memHeaps[i].budget = (8 * m_memProps.memoryHeaps[i].size) / 10;
     }
     
@@ -177,23 +452,7 @@ namespace dxvk {
       m_memTypes[i].chunkSize  = pickChunkSize(i);
     }
 
-    /* Work around an issue on Nvidia drivers where using the entire
-     * device_local | host_visible heap can cause crashes, presumably
-     * due to subsequent internal driver allocations failing */
-    bool nvidiaBug3114283Active = false;
-
-    // Fix is available in mainline drivers starting with the 465 driver series.
-    if (device->adapter()->matchesDriver(DxvkGpuVendor::Nvidia,
-                                         VK_DRIVER_ID_NVIDIA_PROPRIETARY_KHR,
-                                         0,
-                                         VK_MAKE_VERSION(465, 0, 0))) {
-      nvidiaBug3114283Active = true;
-    }
-
-    applyTristate(nvidiaBug3114283Active, device->config().halveNvidiaHVVHeap);
-
-    if ((m_device->properties().core.properties.vendorID == uint16_t(DxvkGpuVendor::Nvidia))
-     && (nvidiaBug3114283Active)) {
+    if (m_info.halveHVVHeap) {
       for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
         constexpr VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 
@@ -201,6 +460,14 @@ namespace dxvk {
           m_memTypes[i].heap->budget = m_memTypes[i].heap->properties.size / 2;
       }
     }
+
+    std::filesystem::path traceFile = env::getEnvVar(L"DXVK_MEMORY_TRACE");
+
+    if (!traceFile.empty())
+      m_tracer = std::make_unique<DxvkMemoryTracer>(traceFile, m_devProps, m_memProps);
+
+    if (m_info.globalBufferUsage)
+      queryGlobalBufferProperties();
   }
   
   
@@ -215,11 +482,102 @@ namespace dxvk {
     const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
           VkMemoryPropertyFlags             flags,
           float                             priority) {
+    DxvkMemory result = this->allocMemory(
+      req, dedAllocReq, dedAllocInfo, flags, priority);
+
+    if (unlikely(m_tracer != nullptr)) {
+      m_tracer->recordAlloc(req, dedAllocReq.prefersDedicatedAllocation,
+        flags, priority, result.m_type->memTypeId, result.m_memory, result.m_offset);
+    }
+
+    return result;
+  }
+
+
+  DxvkMemory DxvkMemoryAllocator::allocBufferMemory(
+          VkDeviceSize                      size,
+          VkDeviceSize                      align,
+          VkBufferUsageFlags                usage,
+          VkMemoryPropertyFlags             flags,
+          float                             priority) {
+    if (!m_globalBufferUsage || (usage & ~m_globalBufferUsage) || size > MaxPooledBufferSize)
+      return DxvkMemory();
+
+    // Don't bother if none of the memory types that chunk
+    // buffers can use support the requested properties
+    bool hasMemoryType = false;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount && !hasMemoryType; i++) {
+      hasMemoryType = (m_globalBufferTypes & (1u << i))
+        && (m_memTypes[i].memType.propertyFlags & flags) == flags;
+    }
+
+    if (!hasMemoryType)
+      return DxvkMemory();
+
+    VkMemoryRequirements req;
+    req.size            = size;
+    req.alignment       = std::max(align, m_globalBufferAlignment);
+    req.memoryTypeBits  = m_globalBufferTypes;
+
+    VkMemoryDedicatedRequirements dedAllocReq = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS };
+    VkMemoryDedicatedAllocateInfo dedAllocInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
+
+    DxvkMemory memory = this->alloc(&req,
+      dedAllocReq, dedAllocInfo, flags, priority);
+
+    // The chunk may not have a buffer if creating it failed
+    if (!memory.buffer())
+      return DxvkMemory();
+
+    return memory;
+  }
+
+
+  void DxvkMemoryAllocator::pinMemory(
+          DxvkMemory&                       memory) {
+    if (!memory.m_chunk || memory.m_pinned)
+      return;
+
+    memory.m_pinned = true;
+    memory.m_chunk->m_pinnedCount += 1;
+  }
+
+
+  DxvkMemory DxvkMemoryAllocator::allocMemory(
+    const VkMemoryRequirements*             req,
+    const VkMemoryDedicatedRequirements&    dedAllocReq,
+    const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
+          VkMemoryPropertyFlags             flags,
+          float                             priority) {
+    // If device-local memory is running low, move allocations that
+    // do not strictly need it to system memory before the driver
+    // has to start paging out other resources. Cached slices come
+    // from the memory type we'd move away from, so skip the cache.
+    bool demote = this->shouldDemote(req, flags, priority);
+
+    // Small allocations can usually be served from the
+    // allocation cache without taking the global lock
+    if (!demote && !dedAllocReq.prefersDedicatedAllocation) {
+      DxvkMemory result = this->tryAllocFromCache(req, flags, priority);
+
+      if (result) {
+        result.m_type->heap->stats.memoryUsed += result.m_length;
+        return result;
+      }
+    }
+
     std::lock_guard<dxvk::mutex> lock(m_mutex);
 
-    // Try to allocate from a memory type which supports the given flags exactly
     auto dedAllocPtr = dedAllocReq.prefersDedicatedAllocation ? &dedAllocInfo : nullptr;
-    DxvkMemory result = this->tryAlloc(req, dedAllocPtr, flags, priority);
+    DxvkMemory result;
+
+    if (demote)
+      result = this->tryAllocDemoted(req, dedAllocPtr, flags);
+
+    // Try to allocate from a memory type which supports the given flags exactly
+    if (!result)
+      result = this->tryAlloc(req, dedAllocPtr, flags, priority);
 
     // If the first attempt failed, try ignoring the dedicated allocation
     if (!result && dedAllocPtr && !dedAllocReq.requiresDedicatedAllocation) {
@@ -240,7 +598,11 @@ namespace dxvk {
     }
     
     if (!result) {
-      DxvkAdapterMemoryInfo memHeapInfo = m_device->adapter()->getMemoryHeapInfo();
+      DxvkAdapterMemoryInfo memHeapInfo = { };
+      bool hasHeapInfo = m_device && m_info.memoryBudget;
+
+      if (hasHeapInfo)
+        memHeapInfo = m_device->adapter()->getMemoryHeapInfo();
 
       Logger::err(str::format(
         "DxvkMemoryAllocator: Memory allocation failed",
@@ -253,7 +615,7 @@ namespace dxvk {
         Logger::err(str::format("Heap ", i, ": ",
           (m_memHeaps[i].stats.memoryAllocated >> 20), " MB allocated, ",
           (m_memHeaps[i].stats.memoryUsed      >> 20), " MB used, ",
-          m_device->extensions().extMemoryBudget
+          hasHeapInfo
             ? str::format(
                 (memHeapInfo.heaps[i].memoryAllocated >> 20), " MB allocated (driver), ",
                 (memHeapInfo.heaps[i].memoryBudget    >> 20), " MB budget (driver), ",
@@ -265,6 +627,76 @@ namespace dxvk {
       throw DxvkError("DxvkMemoryAllocator: Memory allocation failed");
     }
     
+    result.m_type->heap->stats.memoryUsed += result.m_length;
+    return result;
+  }
+
+
+  DxvkMemory DxvkMemoryAllocator::tryAllocFromCache(
+    const VkMemoryRequirements*             req,
+          VkMemoryPropertyFlags             flags,
+          float                             priority) {
+    uint32_t sizeClass = getCacheSizeClass(req->size, req->alignment);
+
+    if (sizeClass == ~0u)
+      return DxvkMemory();
+
+    if (!(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+      priority = 0.0f;
+
+    // Only look at the memory type that a regular
+    // allocation would be served from, if possible
+    DxvkMemoryType* type = nullptr;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount && !type; i++) {
+      const bool supported = (req->memoryTypeBits & (1u << i)) != 0;
+      const bool adequate  = (m_memTypes[i].memType.propertyFlags & flags) == flags;
+
+      if (supported && adequate)
+        type = &m_memTypes[i];
+    }
+
+    const VkDeviceSize size = DxvkMemoryCache::MinSize << sizeClass;
+
+    if (!type || size >= type->chunkSize)
+      return DxvkMemory();
+
+    // Rounding up is only worth it for sizes close to the
+    // size class, the regular allocator is tight enough
+    if (sizeClass && size - req->size > (size >> DxvkMemoryCache::WasteShift))
+      return DxvkMemory();
+
+    DxvkMemoryCache& cache = type->caches[sizeClass];
+    DxvkMemoryCacheEntry entry = { };
+
+    for (uint32_t i = 0; i < 2 && !entry.chunk; i++) {
+      if (i)
+        this->refillCache(type, sizeClass, flags, priority);
+
+      std::lock_guard<sync::Spinlock> lock(cache.mutex);
+
+      if (!cache.entries.empty()) {
+        // The cache only holds slices with one set of memory
+        // properties. Don't refill it for other properties,
+        // since none of the new slices could be used.
+        if (cache.flags != flags || cache.priority != priority)
+          return DxvkMemory();
+
+        entry = cache.entries.back();
+        cache.entries.pop_back();
+        cache.active = true;
+      }
+    }
+
+    if (!entry.chunk)
+      return DxvkMemory();
+
+    const DxvkDeviceMemory& devMem = entry.chunk->memory();
+
+    DxvkMemory result(this, entry.chunk, type,
+      devMem.memHandle, entry.offset, size, entry.block,
+      reinterpret_cast<char*>(devMem.memPointer) + entry.offset);
+    result.m_cached = true;
     return result;
   }
   
@@ -290,6 +722,67 @@ namespace dxvk {
   }
   
   
+  DxvkMemory DxvkMemoryAllocator::tryAllocDemoted(
+    const VkMemoryRequirements*             req,
+    const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
+          VkMemoryPropertyFlags             flags) {
+    flags &= ~VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    DxvkMemory result;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount && !result; i++) {
+      const bool supported = (req->memoryTypeBits & (1u << i)) != 0;
+      const bool adequate  = (m_memTypes[i].memType.propertyFlags & flags) == flags;
+      const bool sysmem    = !(m_memTypes[i].memType.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+      if (supported && adequate && sysmem) {
+        result = this->tryAllocFromType(&m_memTypes[i],
+          flags, req->size, req->alignment, 0.0f, dedAllocInfo);
+      }
+    }
+
+    return result;
+  }
+
+
+  bool DxvkMemoryAllocator::shouldDemote(
+    const VkMemoryRequirements*             req,
+          VkMemoryPropertyFlags             flags,
+          float                             priority) const {
+    // Resources that the GPU writes to, such as render
+    // targets, always stay in device-local memory
+    if (!(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) || priority >= 1.0f)
+      return false;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      const bool supported = (req->memoryTypeBits & (1u << i)) != 0;
+      const bool adequate  = (m_memTypes[i].memType.propertyFlags & flags) == flags;
+
+      if (!supported || !adequate)
+        continue;
+
+      const DxvkMemoryHeap* heap = m_memTypes[i].heap;
+      VkDeviceSize budget = heap->driverBudget.load();
+
+      if (!budget)
+        return false;
+
+      VkDeviceSize usage = heap->stats.memoryAllocated.load()
+                         + heap->externalUsage.load()
+                         + req->size;
+
+      // Memory that is written by the CPU works fine from system
+      // memory, so move it as soon as the heap is close to its
+      // budget. Move other resources only when we'd exceed it.
+      return (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        ? usage * 100 > budget * BudgetPressure
+        : usage > budget;
+    }
+
+    return false;
+  }
+
+
   DxvkMemory DxvkMemoryAllocator::tryAllocFromType(
           DxvkMemoryType*                   type,
           VkMemoryPropertyFlags             flags,
@@ -310,7 +803,7 @@ namespace dxvk {
         type, flags, size, priority, dedAllocInfo);
 
       if (devMem.memHandle != VK_NULL_HANDLE)
-        memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, devMem.memPointer);
+        memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, 0, devMem.memPointer);
     } else {
       for (uint32_t i = 0; i < type->chunks.size() && !memory; i++)
         memory = type->chunks[i]->alloc(flags, size, align, priority);
@@ -322,6 +815,9 @@ namespace dxvk {
           devMem = tryAllocDeviceMemory(type, flags, type->chunkSize >> i, priority, nullptr);
 
         if (devMem.memHandle) {
+          if (m_globalBufferTypes & (1u << type->memTypeId))
+            devMem.buffer = this->createGlobalBuffer(type, devMem);
+
           Rc<DxvkMemoryChunk> chunk = new DxvkMemoryChunk(this, type, devMem);
           memory = chunk->alloc(flags, size, align, priority);
 
@@ -330,9 +826,6 @@ namespace dxvk {
       }
     }
 
-    if (memory)
-      type->heap->stats.memoryUsed += memory.m_length;
-
     return memory;
   }
   
@@ -344,7 +837,7 @@ namespace dxvk {
           float                             priority,
     const VkMemoryDedicatedAllocateInfo*    dedAllocInfo) {
     bool useMemoryPriority = (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-                          && (m_device->features().extMemoryPriority.memoryPriority);
+                          && (m_info.memoryPriority);
     
     if (type->heap->budget && type->heap->stats.memoryAllocated + size > type->heap->budget)
       return DxvkDeviceMemory();
@@ -379,22 +872,34 @@ namespace dxvk {
     }
 
     type->heap->stats.memoryAllocated += size;
-    m_device->adapter()->notifyHeapMemoryAlloc(type->heapId, size);
+
+    if (m_device)
+      m_device->adapter()->notifyHeapMemoryAlloc(type->heapId, size);
     return result;
   }
 
 
   void DxvkMemoryAllocator::free(
     const DxvkMemory&           memory) {
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    // Record this before the memory can be reused
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->recordFree(memory.m_memory, memory.m_offset);
+
     memory.m_type->heap->stats.memoryUsed -= memory.m_length;
 
+    if (memory.m_pinned)
+      memory.m_chunk->m_pinnedCount -= 1;
+
+    if (memory.m_chunk != nullptr && this->freeToCache(memory))
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
     if (memory.m_chunk != nullptr) {
       this->freeChunkMemory(
         memory.m_type,
         memory.m_chunk,
-        memory.m_offset,
-        memory.m_length);
+        memory.m_block);
     } else {
       DxvkDeviceMemory devMem;
       devMem.memHandle  = memory.m_memory;
@@ -404,22 +909,340 @@ namespace dxvk {
     }
   }
 
-  
+
+  bool DxvkMemoryAllocator::freeToCache(
+    const DxvkMemory&           memory) {
+    // Only take back slices that the cache handed out, other
+    // slices may match a size class by accident but were not
+    // allocated with the cache's memory properties.
+    if (!memory.m_cached)
+      return false;
+
+    uint32_t sizeClass = getCacheSizeClass(memory.m_length, 1);
+
+    const DxvkDeviceMemory& devMem = memory.m_chunk->memory();
+
+    DxvkMemoryCache& cache = memory.m_type->caches[sizeClass];
+
+    std::array<DxvkMemoryCacheEntry, DxvkMemoryCache::BatchSize> drained;
+    uint32_t drainCount = 0;
+
+    { std::lock_guard<sync::Spinlock> lock(cache.mutex);
+
+      // Memory of chunks being evacuated must not be reused. Check
+      // this under the cache lock, since evacuateChunks marks the
+      // chunk before it removes its entries under the same lock.
+      if (memory.m_chunk->isEvacuating())
+        return false;
+
+      if (cache.entries.empty()) {
+        cache.flags    = devMem.memFlags;
+        cache.priority = devMem.priority;
+      } else if (!memory.m_chunk->isCompatible(cache.flags, cache.priority)) {
+        return false;
+      }
+
+      // If the cache is full, move a batch of entries
+      // back to their chunks outside of the cache lock
+      if (cache.entries.size() >= DxvkMemoryCache::MaxEntries) {
+        for ( ; drainCount < drained.size(); drainCount++) {
+          drained[drainCount] = cache.entries.back();
+          cache.entries.pop_back();
+        }
+      }
+
+      cache.entries.push_back({ memory.m_chunk, memory.m_offset, memory.m_block });
+    }
+
+    if (drainCount) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      this->drainCacheEntries(memory.m_type, drainCount, drained.data());
+    }
+
+    return true;
+  }
+
+
+  void DxvkMemoryAllocator::refillCache(
+          DxvkMemoryType*       type,
+          uint32_t              sizeClass,
+          VkMemoryPropertyFlags flags,
+          float                 priority) {
+    const VkDeviceSize size = DxvkMemoryCache::MinSize << sizeClass;
+
+    std::array<DxvkMemoryCacheEntry, DxvkMemoryCache::BatchSize> entries;
+    uint32_t count = 0;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    for (uint32_t i = 0; i < entries.size(); i++) {
+      DxvkMemory memory = this->tryAllocFromType(
+        type, flags, size, size, priority, nullptr);
+
+      if (!memory)
+        break;
+
+      // The cache takes ownership of the slice
+      entries[count++] = { memory.m_chunk, memory.m_offset, memory.m_block };
+      memory.m_alloc = nullptr;
+    }
+
+    DxvkMemoryCache& cache = type->caches[sizeClass];
+    uint32_t inserted = 0;
+
+    { std::lock_guard<sync::Spinlock> cacheLock(cache.mutex);
+
+      if (cache.entries.empty()) {
+        cache.flags    = flags;
+        cache.priority = priority;
+      }
+
+      if (cache.flags == flags && cache.priority == priority) {
+        for ( ; inserted < count && cache.entries.size() < DxvkMemoryCache::MaxEntries; inserted++)
+          cache.entries.push_back(entries[inserted]);
+      }
+    }
+
+    // Return anything that the cache could not take,
+    // e.g. if another thread has refilled it already
+    this->drainCacheEntries(type, count - inserted, &entries[inserted]);
+  }
+
+
+  void DxvkMemoryAllocator::trim() {
+    int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+      dxvk::high_resolution_clock::now().time_since_epoch()).count();
+    int64_t last = m_lastTrim.load();
+
+    if (now - last < TrimInterval
+     || !m_lastTrim.compare_exchange_strong(last, now))
+      return;
+
+    this->updateBudget();
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      // Return idle cache entries first, since
+      // those would keep chunks from being freed
+      this->trimCaches(&m_memTypes[i]);
+
+      if (m_info.memoryDefrag)
+        this->evacuateChunks(&m_memTypes[i]);
+
+      this->trimChunks(&m_memTypes[i]);
+    }
+  }
+
+
+  void DxvkMemoryAllocator::updateBudget() {
+    if (!m_device || !m_info.memoryBudget)
+      return;
+
+    DxvkAdapterMemoryInfo memHeapInfo = m_device->adapter()->getMemoryHeapInfo();
+    bool pressureChanged = false;
+
+    for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
+      DxvkMemoryHeap& heap = m_memHeaps[i];
+
+      VkDeviceSize allocated = heap.stats.memoryAllocated.load();
+      VkDeviceSize budget    = memHeapInfo.heaps[i].memoryBudget;
+      VkDeviceSize usage     = memHeapInfo.heaps[i].memoryAllocated;
+
+      // The driver reports usage for the entire process, which
+      // may include allocations that did not go through us
+      heap.driverBudget  = budget;
+      heap.externalUsage = usage > allocated ? usage - allocated : 0;
+
+      bool pressure = (heap.properties.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                   && (usage * 100 > budget * BudgetPressure);
+
+      if (pressure && !heap.pressure) {
+        Logger::warn(str::format("Memory: Heap ", i, " close to budget: ",
+          usage >> 20, " MB used, ", budget >> 20, " MB budget"));
+        pressureChanged = true;
+      }
+
+      heap.pressure = pressure;
+    }
+
+    if (pressureChanged)
+      m_pressureSignal->signal(++m_pressureEvents);
+  }
+
+
+  void DxvkMemoryAllocator::trimCaches(
+          DxvkMemoryType*       type) {
+    std::vector<DxvkMemoryCacheEntry> entries;
+
+    for (uint32_t i = 0; i < type->caches.size(); i++) {
+      DxvkMemoryCache& cache = type->caches[i];
+
+      { std::lock_guard<sync::Spinlock> lock(cache.mutex);
+
+        if (!std::exchange(cache.active, false))
+          entries.swap(cache.entries);
+      }
+
+      this->drainCacheEntries(type, entries.size(), entries.data());
+
+      entries.clear();
+    }
+  }
+
+
+  void DxvkMemoryAllocator::trimChunks(
+          DxvkMemoryType*       type) {
+    uint32_t reserveCount = 0;
+
+    for (size_t i = 0; i < type->chunks.size(); ) {
+      DxvkMemoryChunk* chunk = type->chunks[i].ptr();
+
+      // Only free chunks that have not been allocated
+      // from during the entire trim interval, and keep
+      // a small reserve of empty chunks around. Chunks
+      // that have been evacuated are freed right away.
+      bool isActive = chunk->checkActivity();
+      bool isEvacuated = chunk->isEvacuating() && chunk->isEmpty();
+
+      if (!isEvacuated && (!chunk->isEmpty() || isActive || reserveCount++ < TrimReserveChunks)) {
+        i += 1;
+        continue;
+      }
+
+      type->heap->stats.memoryReclaimed += chunk->memory().memSize;
+      type->chunks.erase(type->chunks.begin() + i);
+    }
+  }
+
+
+  void DxvkMemoryAllocator::evacuateChunks(
+          DxvkMemoryType*       type) {
+    // Only device-local buffers that cannot be mapped
+    // can be relocated, so ignore all other memory
+    constexpr VkMemoryPropertyFlags typeMask
+      = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+      | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+    if ((type->memType.propertyFlags & typeMask) != VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+      return;
+
+    // Only evacuate one chunk at a time. If resources do not get
+    // moved in time, e.g. because they are no longer used by the
+    // app at all, give up on that chunk so it can be used again.
+    for (const auto& chunk : type->chunks) {
+      if (chunk->isEvacuating() && !chunk->isEmpty()) {
+        if (++chunk->m_evacuationAge >= EvacuationTimeout)
+          chunk->m_evacuating.store(false);
+        return;
+      }
+    }
+
+    if (type->chunks.size() < 2)
+      return;
+
+    // Pick the least used chunk that is at most a quarter
+    // full, as long as the remaining chunks have enough
+    // free space to take its resources.
+    DxvkMemoryChunk* candidate = nullptr;
+    VkDeviceSize freeSize = 0;
+
+    for (const auto& chunk : type->chunks) {
+      if (chunk->isEvacuating())
+        continue;
+
+      VkDeviceSize chunkSize = chunk->m_allocator.size();
+      VkDeviceSize chunkUsed = chunk->m_allocator.used();
+
+      freeSize += chunkSize - chunkUsed;
+
+      if (chunk->isEmpty() || chunkUsed > chunkSize / 4)
+        continue;
+
+      // Chunks with pinned memory would never become empty,
+      // so evacuating them would move buffers for no gain
+      if (!chunk->isRelocatable())
+        continue;
+
+      if (!candidate || chunkUsed < candidate->m_allocator.used())
+        candidate = chunk.ptr();
+    }
+
+    if (!candidate)
+      return;
+
+    VkDeviceSize candidateUsed = candidate->m_allocator.used();
+    VkDeviceSize candidateFree = candidate->m_allocator.size() - candidateUsed;
+
+    if (freeSize - candidateFree < 2 * candidateUsed)
+      return;
+
+    candidate->m_evacuating.store(true);
+    candidate->m_evacuationAge = 0;
+
+    this->evacuateCacheEntries(type, candidate);
+
+    Logger::debug(str::format("Memory: Evacuating chunk on memory type ", type->memTypeId,
+      " (", candidateUsed >> 10, " kB used of ", candidate->m_allocator.size() >> 10, " kB)"));
+  }
+
+
+  void DxvkMemoryAllocator::evacuateCacheEntries(
+          DxvkMemoryType*       type,
+          DxvkMemoryChunk*      chunk) {
+    std::vector<DxvkMemoryCacheEntry> entries;
+
+    for (uint32_t i = 0; i < type->caches.size(); i++) {
+      DxvkMemoryCache& cache = type->caches[i];
+
+      { std::lock_guard<sync::Spinlock> lock(cache.mutex);
+
+        for (size_t j = 0; j < cache.entries.size(); ) {
+          if (cache.entries[j].chunk == chunk) {
+            entries.push_back(cache.entries[j]);
+            cache.entries[j] = cache.entries.back();
+            cache.entries.pop_back();
+          } else {
+            j += 1;
+          }
+        }
+      }
+
+      this->drainCacheEntries(type, entries.size(), entries.data());
+
+      entries.clear();
+    }
+  }
+
+
+  void DxvkMemoryAllocator::drainCacheEntries(
+          DxvkMemoryType*       type,
+          uint32_t              count,
+    const DxvkMemoryCacheEntry* entries) {
+    for (uint32_t i = 0; i < count; i++)
+      this->freeChunkMemory(type, entries[i].chunk, entries[i].block);
+  }
+
+
   void DxvkMemoryAllocator::freeChunkMemory(
           DxvkMemoryType*       type,
           DxvkMemoryChunk*      chunk,
-          VkDeviceSize          offset,
-          VkDeviceSize          length) {
-    chunk->free(offset, length);
+          uint32_t              block) {
+    chunk->free(block);
   }
   
 
   void DxvkMemoryAllocator::freeDeviceMemory(
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory) {
+    if (memory.buffer)
+      m_vkd->vkDestroyBuffer(m_vkd->device(), memory.buffer, nullptr);
+
     m_vkd->vkFreeMemory(m_vkd->device(), memory.memHandle, nullptr);
     type->heap->stats.memoryAllocated -= memory.memSize;
-    m_device->adapter()->notifyHeapMemoryFree(type->heapId, memory.memSize);
+
+    if (m_device)
+      m_device->adapter()->notifyHeapMemoryFree(type->heapId, memory.memSize);
   }
 
 
@@ -444,5 +1267,132 @@ namespace dxvk {
 
     return chunkSize;
   }
+
+
+  void DxvkMemoryAllocator::queryGlobalBufferProperties() {
+    // Memory types and alignment only depend on the usage and
+    // create flags of a buffer, so a small dummy buffer tells
+    // us which chunks can have a global buffer bound to them.
+    VkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    info.size         = DxvkMemoryCache::MaxSize;
+    info.usage        = m_info.globalBufferUsage;
+    info.sharingMode  = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+
+    if (m_vkd->vkCreateBuffer(m_vkd->device(), &info, nullptr, &buffer) != VK_SUCCESS) {
+      Logger::warn("DxvkMemoryAllocator: Failed to create buffer, disabling buffer pooling");
+      return;
+    }
+
+    VkMemoryRequirements memReq = { };
+    m_vkd->vkGetBufferMemoryRequirements(m_vkd->device(), buffer, &memReq);
+    m_vkd->vkDestroyBuffer(m_vkd->device(), buffer, nullptr);
+
+    m_globalBufferUsage     = info.usage;
+    m_globalBufferAlignment = memReq.alignment;
+    m_globalBufferTypes     = memReq.memoryTypeBits;
+  }
+
+
+  VkBuffer DxvkMemoryAllocator::createGlobalBuffer(
+          DxvkMemoryType*       type,
+    const DxvkDeviceMemory&     memory) {
+    VkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    info.size         = memory.memSize;
+    info.usage        = m_globalBufferUsage;
+    info.sharingMode  = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+
+    if (m_vkd->vkCreateBuffer(m_vkd->device(), &info, nullptr, &buffer) != VK_SUCCESS)
+      return VK_NULL_HANDLE;
+
+    VkMemoryRequirements memReq = { };
+    m_vkd->vkGetBufferMemoryRequirements(m_vkd->device(), buffer, &memReq);
+
+    // Buffers that can be sub-allocated from the chunk
+    // are allocated without checking this, so keep the
+    // chunk without a buffer if anything is off.
+    bool compatible = memReq.size <= memory.memSize
+      && (memReq.memoryTypeBits & (1u << type->memTypeId));
+
+    if (!compatible || m_vkd->vkBindBufferMemory(m_vkd->device(),
+        buffer, memory.memHandle, 0) != VK_SUCCESS) {
+      m_vkd->vkDestroyBuffer(m_vkd->device(), buffer, nullptr);
+      return VK_NULL_HANDLE;
+    }
+
+    return buffer;
+  }
+
+
+  uint32_t DxvkMemoryAllocator::getCacheSizeClass(
+          VkDeviceSize          size,
+          VkDeviceSize          align) {
+    VkDeviceSize maxSize = std::max(size, align);
+
+    if (maxSize > DxvkMemoryCache::MaxSize)
+      return ~0u;
+
+    constexpr uint32_t MinBits = 8;
+    static_assert(DxvkMemoryCache::MinSize == (1u << MinBits));
+
+    uint32_t bits = 32 - bit::lzcnt(uint32_t(maxSize - 1));
+    return std::max(bits, MinBits) - MinBits;
+  }
+
+
+  DxvkMemoryAllocatorInfo DxvkMemoryAllocator::getAllocatorInfo(
+    const DxvkDevice*           device) {
+    DxvkMemoryAllocatorInfo info;
+    info.deviceProperties = device->adapter()->deviceProperties();
+    info.memoryProperties = device->adapter()->memoryProperties();
+    info.unifiedMemory    = device->isUnifiedMemoryArchitecture();
+    info.memoryPriority   = device->features().extMemoryPriority.memoryPriority;
+    info.memoryBudget     = device->extensions().extMemoryBudget;
+    info.memoryDefrag     = device->config().enableMemoryDefrag;
+
+    // Buffers with any of these usage flags can be sub-allocated
+    // from buffers that span entire memory chunks. Index buffers
+    // are bound without a size, so robust buffer access would let
+    // out-of-bounds reads return data of neighbouring resources
+    // rather than zero. The same applies to vertex buffers unless
+    // they can be bound with a size.
+    info.globalBufferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                           | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                           | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT
+                           | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT
+                           | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+                           | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                           | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+    if (device->features().extExtendedDynamicState.extendedDynamicState)
+      info.globalBufferUsage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+
+    if (device->features().extTransformFeedback.transformFeedback) {
+      info.globalBufferUsage |= VK_BUFFER_USAGE_TRANSFORM_FEEDBACK_BUFFER_BIT_EXT
+                             |  VK_BUFFER_USAGE_TRANSFORM_FEEDBACK_COUNTER_BUFFER_BIT_EXT;
+    }
+
+    /* Work around an issue on Nvidia drivers where using the entire
+     * device_local | host_visible heap can cause crashes, presumably
+     * due to subsequent internal driver allocations failing */
+    bool nvidiaBug3114283Active = false;
+
+    // Fix is available in mainline drivers starting with the 465 driver series.
+    if (device->adapter()->matchesDriver(DxvkGpuVendor::Nvidia,
+                                         VK_DRIVER_ID_NVIDIA_PROPRIETARY_KHR,
+                                         0,
+                                         VK_MAKE_VERSION(465, 0, 0))) {
+      nvidiaBug3114283Active = true;
+    }
+
+    applyTristate(nvidiaBug3114283Active, device->config().halveNvidiaHVVHeap);
+
+    info.halveHVVHeap = nvidiaBug3114283Active
+      && device->properties().core.properties.vendorID == uint16_t(DxvkGpuVendor::Nvidia);
+    return info;
+  }
   
 }
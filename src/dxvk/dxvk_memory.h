@@ -1,6 +1,9 @@
 #pragma once
 
+#include "../util/util_time.h"
+
 #include "dxvk_adapter.h"
+#include "dxvk_memory_trace.h"
 
 namespace dxvk {
   
@@ -11,11 +14,36 @@ namespace dxvk {
    * \brief Memory stats
    * 
    * Reports the amount of device memory
-   * allocated and used by the application.
+   * allocated and used by the application,
+   * as well as the total amount of memory
+   * released back to the driver by trimming.
    */
   struct DxvkMemoryStats {
     VkDeviceSize memoryAllocated = 0;
     VkDeviceSize memoryUsed      = 0;
+    VkDeviceSize memoryReclaimed = 0;
+  };
+
+
+  /**
+   * \brief Atomic memory stats
+   * 
+   * Per-heap memory stats. These are updated atomically
+   * since allocations served from the allocation cache
+   * do not take the allocator lock.
+   */
+  struct DxvkMemoryAtomicStats {
+    std::atomic<VkDeviceSize> memoryAllocated = { 0ull };
+    std::atomic<VkDeviceSize> memoryUsed      = { 0ull };
+    std::atomic<VkDeviceSize> memoryReclaimed = { 0ull };
+
+    DxvkMemoryStats load() const {
+      DxvkMemoryStats result;
+      result.memoryAllocated = memoryAllocated.load();
+      result.memoryUsed      = memoryUsed.load();
+      result.memoryReclaimed = memoryReclaimed.load();
+      return result;
+    }
   };
   
   
@@ -24,9 +52,12 @@ namespace dxvk {
    * 
    * Stores a Vulkan memory object. If the object
    * was allocated on host-visible memory, it will
-   * be persistently mapped.
+   * be persistently mapped. Memory chunks may also
+   * have a buffer bound to the entire allocation,
+   * which small buffers can be sub-allocated from.
    */
   struct DxvkDeviceMemory {
+    VkBuffer              buffer     = VK_NULL_HANDLE;
     VkDeviceMemory        memHandle  = VK_NULL_HANDLE;
     void*                 memPointer = nullptr;
     VkDeviceSize          memSize    = 0;
@@ -40,11 +71,58 @@ namespace dxvk {
    * 
    * Corresponds to a Vulkan memory heap and stores
    * its properties as well as allocation statistics.
+   * The driver budget and the amount of memory used
+   * by other allocations in the process are queried
+   * periodically if the device supports it, and are
+   * zero otherwise.
    */
   struct DxvkMemoryHeap {
-    VkMemoryHeap      properties;
-    DxvkMemoryStats   stats;
-    VkDeviceSize      budget;
+    VkMemoryHeap              properties;
+    DxvkMemoryAtomicStats     stats;
+    VkDeviceSize              budget;
+    std::atomic<VkDeviceSize> driverBudget  = { 0ull };
+    std::atomic<VkDeviceSize> externalUsage = { 0ull };
+    bool                      pressure      = false;
+  };
+
+
+  /**
+   * \brief Cached memory slice
+   * 
+   * A slice of chunk memory that is owned by
+   * an allocation cache and not in use.
+   */
+  struct DxvkMemoryCacheEntry {
+    DxvkMemoryChunk*  chunk;
+    VkDeviceSize      offset;
+    uint32_t          block;
+  };
+
+
+  /**
+   * \brief Memory allocation cache
+   * 
+   * Stores free, equally sized slices of chunk memory
+   * for one memory type and size class, so that small
+   * allocations can be served and returned without
+   * taking the global allocator lock. The allocator
+   * refills and drains the cache in batches. Sizes
+   * that would waste more than a quarter of their
+   * size class are not served from the cache.
+   */
+  struct DxvkMemoryCache {
+    constexpr static VkDeviceSize MinSize    = 256;
+    constexpr static VkDeviceSize MaxSize    = 65536;
+    constexpr static uint32_t     ClassCount = 9;
+    constexpr static uint32_t     BatchSize  = 16;
+    constexpr static uint32_t     MaxEntries = 2 * BatchSize;
+    constexpr static uint32_t     WasteShift = 2;
+
+    sync::Spinlock                    mutex;
+    VkMemoryPropertyFlags             flags    = 0;
+    float                             priority = 0.0f;
+    bool                              active   = false;
+    std::vector<DxvkMemoryCacheEntry> entries;
   };
 
 
@@ -65,6 +143,8 @@ namespace dxvk {
     VkDeviceSize      chunkSize;
 
     std::vector<Rc<DxvkMemoryChunk>> chunks;
+
+    std::array<DxvkMemoryCache, DxvkMemoryCache::ClassCount> caches;
   };
   
   
@@ -86,6 +166,7 @@ namespace dxvk {
       VkDeviceMemory        memory,
       VkDeviceSize          offset,
       VkDeviceSize          length,
+      uint32_t              block,
       void*                 mapPtr);
     DxvkMemory             (DxvkMemory&& other);
     DxvkMemory& operator = (DxvkMemory&& other);
@@ -141,6 +222,24 @@ namespace dxvk {
     operator bool () const {
       return m_memory != VK_NULL_HANDLE;
     }
+
+    /**
+     * \brief Checks whether the slice should be moved
+     * 
+     * \returns \c true if the slice was allocated from a
+     *          chunk that the allocator is trying to free
+     */
+    bool needsRelocation() const;
+
+    /**
+     * \brief Global buffer of the memory chunk
+     * 
+     * If the slice was allocated from a chunk that has a
+     * buffer bound to it, this returns that buffer. The
+     * slice is located at \ref offset in the buffer.
+     * \returns Chunk buffer, or \c VK_NULL_HANDLE
+     */
+    VkBuffer buffer() const;
     
   private:
     
@@ -150,13 +249,150 @@ namespace dxvk {
     VkDeviceMemory        m_memory = VK_NULL_HANDLE;
     VkDeviceSize          m_offset = 0;
     VkDeviceSize          m_length = 0;
+    uint32_t              m_block  = 0;
     void*                 m_mapPtr = nullptr;
+    bool                  m_cached = false;
+    bool                  m_pinned = false;
     
     void free();
     
   };
   
   
+  /**
+   * \brief Memory range allocator
+   * 
+   * Two-level segregated fit allocator that manages
+   * ranges within a single block of memory. Free ranges
+   * are binned by size class, so that allocating a range
+   * and freeing it again, including merging it with any
+   * adjacent free ranges, runs in constant time.
+   * This is not thread-safe.
+   */
+  class DxvkMemoryRangeAllocator {
+    constexpr static uint32_t SlBits  = 4;
+    constexpr static uint32_t SlCount = 1u << SlBits;
+    constexpr static uint32_t FlCount = 32;
+    constexpr static uint32_t Invalid = ~0u;
+  public:
+
+    DxvkMemoryRangeAllocator(VkDeviceSize size);
+
+    ~DxvkMemoryRangeAllocator();
+
+    /**
+     * \brief Total size of the managed memory block
+     * \returns Size, in bytes
+     */
+    VkDeviceSize size() const {
+      return m_size;
+    }
+
+    /**
+     * \brief Number of bytes currently allocated
+     * \returns Allocated size, in bytes
+     */
+    VkDeviceSize used() const {
+      return m_used;
+    }
+
+    /**
+     * \brief Allocates a range
+     * 
+     * Both the offset and the length of the
+     * returned range are aligned to the
+     * requested alignment.
+     * \param [in] size Number of bytes to allocate
+     * \param [in] align Required alignment
+     * \param [out] offset Offset of the allocated range
+     * \param [out] length Length of the allocated range
+     * \param [out] index Block index, used to free the range
+     * \returns \c true on success, \c false if
+     *          no suitable free range exists
+     */
+    bool alloc(
+            VkDeviceSize          size,
+            VkDeviceSize          align,
+            VkDeviceSize&         offset,
+            VkDeviceSize&         length,
+            uint32_t&             index);
+
+    /**
+     * \brief Frees a range
+     * 
+     * \param [in] block Block index returned by \ref alloc
+     */
+    void free(
+            uint32_t              block);
+
+    /**
+     * \brief Queries size of the largest free range
+     * 
+     * Only scans the highest non-empty size class,
+     * which is sufficient to find the largest range.
+     * \returns Size of the largest free range
+     */
+    VkDeviceSize largestFreeRange() const;
+
+  private:
+
+    struct Block {
+      VkDeviceSize offset;
+      VkDeviceSize length;
+      uint32_t     prevPhys;
+      uint32_t     nextPhys;
+      uint32_t     prevFree;
+      uint32_t     nextFree;
+      bool         isFree;
+    };
+
+    VkDeviceSize  m_size;
+    VkDeviceSize  m_used = 0;
+
+    uint32_t                              m_flMask = 0;
+    std::array<uint32_t, FlCount>         m_slMasks = { };
+    std::array<std::array<uint32_t, SlCount>, FlCount> m_freeHeads;
+
+    std::vector<Block>    m_blocks;
+    std::vector<uint32_t> m_unusedBlocks;
+
+
+    uint32_t findFreeBlock(
+            VkDeviceSize          size,
+            VkDeviceSize          align) const;
+
+    uint32_t searchFreeBlock(
+            VkDeviceSize          size) const;
+
+    void insertFreeBlock(
+            uint32_t              block);
+
+    void removeFreeBlock(
+            uint32_t              block);
+
+    uint32_t splitBlock(
+            uint32_t              block,
+            VkDeviceSize          length);
+
+    void mergeBlocks(
+            uint32_t              block,
+            uint32_t              next);
+
+    uint32_t createBlock();
+
+    bool blockFits(
+            uint32_t              block,
+            VkDeviceSize          size,
+            VkDeviceSize          align) const;
+
+    static void computeSizeClass(
+            VkDeviceSize          size,
+            uint32_t&             fl,
+            uint32_t&             sl);
+
+  };
+
+
   /**
    * \brief Memory chunk
    * 
@@ -164,7 +400,7 @@ namespace dxvk {
    * sub-allocator. This is not thread-safe.
    */
   class DxvkMemoryChunk : public RcObject {
-    
+    friend class DxvkMemoryAllocator;
   public:
     
     DxvkMemoryChunk(
@@ -174,6 +410,71 @@ namespace dxvk {
     
     ~DxvkMemoryChunk();
 
+    /**
+     * \brief Device memory object
+     * \returns Device memory backing the chunk
+     */
+    const DxvkDeviceMemory& memory() const {
+      return m_memory;
+    }
+
+    /**
+     * \brief Checks whether the chunk is compatible
+     * 
+     * \param [in] flags Requested memory flags
+     * \param [in] priority Requested priority
+     * \returns \c true if allocations with the given
+     *          properties can be served by the chunk
+     */
+    bool isCompatible(
+            VkMemoryPropertyFlags flags,
+            float                 priority) const {
+      return m_memory.memFlags == flags
+          && m_memory.priority == priority;
+    }
+
+    /**
+     * \brief Checks whether the chunk is unused
+     * \returns \c true if no memory is allocated
+     */
+    bool isEmpty() const {
+      return m_allocator.used() == 0;
+    }
+
+    /**
+     * \brief Checks and resets activity flag
+     * 
+     * \returns \c true if memory was allocated from
+     *          the chunk since the last call
+     */
+    bool checkActivity() {
+      return std::exchange(m_active, false);
+    }
+
+    /**
+     * \brief Checks whether the chunk can be evacuated
+     * 
+     * Chunks that contain memory which cannot be moved
+     * to another chunk, such as image memory, can never
+     * become empty by relocating resources.
+     * \returns \c true if no pinned memory is allocated
+     */
+    bool isRelocatable() const {
+      return m_pinnedCount.load(std::memory_order_relaxed) == 0;
+    }
+
+    /**
+     * \brief Checks whether the chunk is being evacuated
+     * 
+     * No memory is allocated from chunks that are being
+     * evacuated, and resources that use them should be
+     * moved elsewhere so that the chunk can be freed.
+     * \returns \c true if the chunk is being evacuated
+     */
+    bool isEvacuating() const {
+      return m_evacuating.load(std::memory_order_relaxed);
+    }
+
     /**
      * \brief Allocates memory from the chunk
      * 
@@ -197,29 +498,59 @@ namespace dxvk {
      * Returns a slice back to the chunk.
      * Called automatically when a memory
      * slice runs out of scope.
-     * \param [in] offset Slice offset
-     * \param [in] length Slice length
+     * \param [in] block Block index of the slice
      */
     void free(
-            VkDeviceSize  offset,
-            VkDeviceSize  length);
+            uint32_t      block);
     
   private:
     
-    struct FreeSlice {
-      VkDeviceSize offset;
-      VkDeviceSize length;
-    };
-    
     DxvkMemoryAllocator*  m_alloc;
     DxvkMemoryType*       m_type;
     DxvkDeviceMemory      m_memory;
     
-    std::vector<FreeSlice> m_freeList;
+    DxvkMemoryRangeAllocator m_allocator;
+
+    bool                  m_active = true;
+
+    std::atomic<bool>     m_evacuating    = { false };
+    uint32_t              m_evacuationAge = 0;
+
+    std::atomic<uint32_t> m_pinnedCount   = { 0u };
     
   };
+
+
+  inline bool DxvkMemory::needsRelocation() const {
+    return m_chunk != nullptr && m_chunk->isEvacuating();
+  }
+
+
+  inline VkBuffer DxvkMemory::buffer() const {
+    return m_chunk != nullptr ? m_chunk->memory().buffer : VK_NULL_HANDLE;
+  }
   
   
+  /**
+   * \brief Memory allocator properties
+   * 
+   * Device properties and features that affect memory
+   * allocation. Usually derived from the device, but can
+   * be provided explicitly in order to use the allocator
+   * without a device, e.g. when replaying memory traces.
+   */
+  struct DxvkMemoryAllocatorInfo {
+    VkPhysicalDeviceProperties        deviceProperties  = { };
+    VkPhysicalDeviceMemoryProperties  memoryProperties  = { };
+    bool                              unifiedMemory     = false;
+    bool                              halveHVVHeap      = false;
+    bool                              memoryPriority    = false;
+    bool                              memoryBudget      = false;
+    bool                              memoryDefrag      = false;
+    VkBufferUsageFlags                globalBufferUsage = 0;
+  };
+
+
   /**
    * \brief Memory allocator
    * 
@@ -229,9 +560,21 @@ namespace dxvk {
   class DxvkMemoryAllocator {
     friend class DxvkMemory;
     friend class DxvkMemoryChunk;
+
+    constexpr static int64_t  TrimInterval      = 1'000'000;
+    constexpr static uint32_t TrimReserveChunks = 1;
+    constexpr static uint32_t EvacuationTimeout = 10;
+    constexpr static uint32_t BudgetPressure    = 90;
+
+    constexpr static VkDeviceSize MaxPooledBufferSize = 256 << 10;
   public:
     
     DxvkMemoryAllocator(const DxvkDevice* device);
+
+    DxvkMemoryAllocator(
+      const Rc<vk::DeviceFn>&           vkd,
+      const DxvkMemoryAllocatorInfo&    info);
+
     ~DxvkMemoryAllocator();
     
     /**
@@ -262,6 +605,40 @@ namespace dxvk {
       const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
             VkMemoryPropertyFlags             flags,
             float                             priority);
+
+    /**
+     * \brief Allocates memory for a pooled buffer
+     * 
+     * Sub-allocates memory from a chunk that has a buffer
+     * bound to it, so that small buffers can share one
+     * Vulkan buffer object instead of creating their own.
+     * Returns a null slice if the buffer is too large or
+     * its usage is not supported by chunk buffers, in
+     * which case the caller must create its own buffer.
+     * \param [in] size Buffer size
+     * \param [in] align Required offset alignment
+     * \param [in] usage Buffer usage flags
+     * \param [in] flags Memory type flags
+     * \param [in] priority Device-local memory priority
+     * \returns Allocated memory slice
+     */
+    DxvkMemory allocBufferMemory(
+            VkDeviceSize                      size,
+            VkDeviceSize                      align,
+            VkBufferUsageFlags                usage,
+            VkMemoryPropertyFlags             flags,
+            float                             priority);
+
+    /**
+     * \brief Marks memory as not relocatable
+     * 
+     * Must be called for memory of resources that cannot be
+     * relocated, e.g. images, so that the chunk it has been
+     * allocated from is not picked for evacuation.
+     * \param [in] memory The memory slice
+     */
+    void pinMemory(
+            DxvkMemory&                       memory);
     
     /**
      * \brief Queries memory stats
@@ -272,13 +649,45 @@ namespace dxvk {
      * \returns Memory stats for this heap
      */
     DxvkMemoryStats getMemoryStats(uint32_t heap) const {
-      return m_memHeaps[heap].stats;
+      return m_memHeaps[heap].stats.load();
     }
+
+    /**
+     * \brief Memory pressure signal
+     * 
+     * Signaled with an increasing value whenever a
+     * device-local heap gets close to the budget
+     * reported by the driver. Front ends can poll
+     * the value and evict resources that they can
+     * restore later when it changes.
+     * \returns Memory pressure signal
+     */
+    Rc<sync::Signal> getMemoryPressureSignal() const {
+      return m_pressureSignal;
+    }
+
+    /**
+     * \brief Releases unused memory
+     * 
+     * Frees chunks that have been empty for at least one
+     * trim interval back to the driver, keeping a small
+     * number of empty chunks per memory type around so
+     * that apps which allocate and free memory in bursts
+     * do not continuously reallocate device memory.
+     * Should be called at frame boundaries. Does
+     * nothing if the last trim was too recent.
+     * 
+     * If memory defragmentation is enabled, this will
+     * also pick sparsely used chunks to evacuate. Also
+     * updates the memory budget reported by the driver.
+     */
+    void trim();
     
   private:
 
     const Rc<vk::DeviceFn>                 m_vkd;
-    const DxvkDevice*                      m_device;
+    const DxvkDevice*                      m_device = nullptr;
+    const DxvkMemoryAllocatorInfo          m_info;
     const VkPhysicalDeviceProperties       m_devProps;
     const VkPhysicalDeviceMemoryProperties m_memProps;
     
@@ -286,11 +695,44 @@ namespace dxvk {
     std::array<DxvkMemoryHeap, VK_MAX_MEMORY_HEAPS> m_memHeaps;
     std::array<DxvkMemoryType, VK_MAX_MEMORY_TYPES> m_memTypes;
 
+    std::atomic<int64_t>                            m_lastTrim = { 0ll };
+
+    Rc<sync::Fence>                                 m_pressureSignal;
+    uint64_t                                        m_pressureEvents = 0;
+
+    std::unique_ptr<DxvkMemoryTracer>               m_tracer;
+
+    VkBufferUsageFlags                              m_globalBufferUsage     = 0;
+    VkDeviceSize                                    m_globalBufferAlignment = 0;
+    uint32_t                                        m_globalBufferTypes     = 0;
+
+    DxvkMemory allocMemory(
+      const VkMemoryRequirements*             req,
+      const VkMemoryDedicatedRequirements&    dedAllocReq,
+      const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
+            VkMemoryPropertyFlags             flags,
+            float                             priority);
+
+    DxvkMemory tryAllocFromCache(
+      const VkMemoryRequirements*             req,
+            VkMemoryPropertyFlags             flags,
+            float                             priority);
+
     DxvkMemory tryAlloc(
       const VkMemoryRequirements*             req,
       const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
             VkMemoryPropertyFlags             flags,
             float                             priority);
+
+    DxvkMemory tryAllocDemoted(
+      const VkMemoryRequirements*             req,
+      const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
+            VkMemoryPropertyFlags             flags);
+
+    bool shouldDemote(
+      const VkMemoryRequirements*             req,
+            VkMemoryPropertyFlags             flags,
+            float                             priority) const;
     
     DxvkMemory tryAllocFromType(
             DxvkMemoryType*                   type,
@@ -310,11 +752,39 @@ namespace dxvk {
     void free(
       const DxvkMemory&           memory);
     
+    bool freeToCache(
+      const DxvkMemory&           memory);
+
+    void refillCache(
+            DxvkMemoryType*       type,
+            uint32_t              sizeClass,
+            VkMemoryPropertyFlags flags,
+            float                 priority);
+
+    void updateBudget();
+
+    void trimCaches(
+            DxvkMemoryType*       type);
+
+    void trimChunks(
+            DxvkMemoryType*       type);
+
+    void evacuateChunks(
+            DxvkMemoryType*       type);
+
+    void evacuateCacheEntries(
+            DxvkMemoryType*       type,
+            DxvkMemoryChunk*      chunk);
+
+    void drainCacheEntries(
+            DxvkMemoryType*       type,
+            uint32_t              count,
+      const DxvkMemoryCacheEntry* entries);
+    
     void freeChunkMemory(
             DxvkMemoryType*       type,
             DxvkMemoryChunk*      chunk,
-            VkDeviceSize          offset,
-            VkDeviceSize          length);
+            uint32_t              block);
     
     void freeDeviceMemory(
             DxvkMemoryType*       type,
@@ -323,6 +793,19 @@ namespace dxvk {
     VkDeviceSize pickChunkSize(
             uint32_t              memTypeId) const;
 
+    void queryGlobalBufferProperties();
+
+    VkBuffer createGlobalBuffer(
+            DxvkMemoryType*       type,
+      const DxvkDeviceMemory&     memory);
+
+    static uint32_t getCacheSizeClass(
+            VkDeviceSize          size,
+            VkDeviceSize          align);
+
+    static DxvkMemoryAllocatorInfo getAllocatorInfo(
+      const DxvkDevice*           device);
+
   };
   
 }
\ No newline at end of file
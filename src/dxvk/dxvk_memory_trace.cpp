@@ -0,0 +1,108 @@
+#include "dxvk_memory_trace.h"
+
+namespace dxvk {
+
+  DxvkMemoryTracer::DxvkMemoryTracer(
+    const std::filesystem::path&            fileName,
+    const VkPhysicalDeviceProperties&       devProps,
+    const VkPhysicalDeviceMemoryProperties& memProps)
+  : m_stream(fileName, std::ios_base::binary | std::ios_base::trunc) {
+    if (!m_stream) {
+      Logger::err(str::format("Memory: Failed to create trace file ", fileName.c_str()));
+      return;
+    }
+
+    DxvkMemoryTraceHeader header;
+    header.magic                  = Magic;
+    header.version                = Version;
+    header.bufferImageGranularity = devProps.limits.bufferImageGranularity;
+    header.memoryProperties       = memProps;
+
+    m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    Logger::info(str::format("Memory: Recording allocation trace to ", fileName.c_str()));
+  }
+
+
+  DxvkMemoryTracer::~DxvkMemoryTracer() {
+    m_stream.flush();
+  }
+
+
+  void DxvkMemoryTracer::recordAlloc(
+    const VkMemoryRequirements*             req,
+          bool                              dedicated,
+          VkMemoryPropertyFlags             flags,
+          float                             priority,
+          uint32_t                          memoryType,
+          VkDeviceMemory                    memory,
+          VkDeviceSize                      offset) {
+    DxvkMemoryTraceAlloc alloc;
+    alloc.size            = req->size;
+    alloc.alignment       = req->alignment;
+    alloc.memoryTypeBits  = req->memoryTypeBits;
+    alloc.flags           = flags;
+    alloc.priority        = priority;
+    alloc.memoryType      = uint16_t(memoryType);
+    alloc.dedicated       = uint16_t(dedicated);
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    uint32_t id = m_nextId++;
+    m_ids.insert({ Key { memory, offset }, id });
+
+    uint32_t word = (id << 1) | uint32_t(DxvkMemoryTraceOp::Alloc);
+
+    m_stream.write(reinterpret_cast<const char*>(&word), sizeof(word));
+    m_stream.write(reinterpret_cast<const char*>(&alloc), sizeof(alloc));
+  }
+
+
+  void DxvkMemoryTracer::recordFree(
+          VkDeviceMemory                    memory,
+          VkDeviceSize                      offset) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_ids.find(Key { memory, offset });
+
+    if (entry == m_ids.end())
+      return;
+
+    uint32_t word = (entry->second << 1) | uint32_t(DxvkMemoryTraceOp::Free);
+    m_ids.erase(entry);
+
+    m_stream.write(reinterpret_cast<const char*>(&word), sizeof(word));
+  }
+
+
+  bool DxvkMemoryTracer::readHeader(
+          std::istream&                     stream,
+          DxvkMemoryTraceHeader&            header) {
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
+
+    return header.magic   == Magic
+        && header.version == Version;
+  }
+
+
+  bool DxvkMemoryTracer::readRecord(
+          std::istream&                     stream,
+          DxvkMemoryTraceRecord&            record) {
+    uint32_t word = 0;
+
+    if (!stream.read(reinterpret_cast<char*>(&word), sizeof(word)))
+      return false;
+
+    record.op = DxvkMemoryTraceOp(word & 1);
+    record.id = word >> 1;
+
+    if (record.op == DxvkMemoryTraceOp::Alloc) {
+      if (!stream.read(reinterpret_cast<char*>(&record.alloc), sizeof(record.alloc)))
+        return false;
+    }
+
+    return true;
+  }
+
+}
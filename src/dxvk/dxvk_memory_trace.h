@@ -0,0 +1,171 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#include "dxvk_hash.h"
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Memory trace header
+   * 
+   * Stores the memory properties of the device that
+   * the trace was recorded on, so that the trace can
+   * be replayed with the same memory layout.
+   */
+  struct DxvkMemoryTraceHeader {
+    uint32_t                          magic;
+    uint32_t                          version;
+    VkDeviceSize                      bufferImageGranularity;
+    VkPhysicalDeviceMemoryProperties  memoryProperties;
+  };
+
+
+  /**
+   * \brief Memory trace operation
+   */
+  enum class DxvkMemoryTraceOp : uint32_t {
+    Alloc = 0,
+    Free  = 1,
+  };
+
+
+  /**
+   * \brief Memory trace allocation
+   * 
+   * Parameters of an allocation, as well as the
+   * memory type that it was served from.
+   */
+  struct DxvkMemoryTraceAlloc {
+    VkDeviceSize          size;
+    VkDeviceSize          alignment;
+    uint32_t              memoryTypeBits;
+    VkMemoryPropertyFlags flags;
+    float                 priority;
+    uint16_t              memoryType;
+    uint16_t              dedicated;
+  };
+
+
+  /**
+   * \brief Memory trace record
+   * 
+   * Each record starts with a 32-bit word that stores the
+   * operation in the lowest bit and the allocation ID in
+   * the remaining bits. Allocations are followed by a
+   * \ref DxvkMemoryTraceAlloc structure.
+   */
+  struct DxvkMemoryTraceRecord {
+    DxvkMemoryTraceOp     op;
+    uint32_t              id;
+    DxvkMemoryTraceAlloc  alloc;
+  };
+
+
+  /**
+   * \brief Memory tracer
+   * 
+   * Writes all allocations and frees that go through
+   * the memory allocator to a compact binary trace,
+   * which can be replayed without a Vulkan device.
+   */
+  class DxvkMemoryTracer {
+    constexpr static uint32_t Magic   = 0x544d5844; // "DXMT"
+    constexpr static uint32_t Version = 1;
+  public:
+
+    DxvkMemoryTracer(
+      const std::filesystem::path&            fileName,
+      const VkPhysicalDeviceProperties&       devProps,
+      const VkPhysicalDeviceMemoryProperties& memProps);
+
+    ~DxvkMemoryTracer();
+
+    /**
+     * \brief Records an allocation
+     * 
+     * \param [in] req Memory requirements
+     * \param [in] dedicated Whether a dedicated allocation was preferred
+     * \param [in] flags Requested memory flags
+     * \param [in] priority Requested priority
+     * \param [in] memoryType Memory type the allocation was served from
+     * \param [in] memory Memory object of the allocation
+     * \param [in] offset Offset of the allocation
+     */
+    void recordAlloc(
+      const VkMemoryRequirements*             req,
+            bool                              dedicated,
+            VkMemoryPropertyFlags             flags,
+            float                             priority,
+            uint32_t                          memoryType,
+            VkDeviceMemory                    memory,
+            VkDeviceSize                      offset);
+
+    /**
+     * \brief Records a free
+     * 
+     * Must be called before the memory is returned
+     * to the allocator, so that records of any
+     * subsequent allocation reusing the same
+     * memory come after this.
+     * \param [in] memory Memory object of the allocation
+     * \param [in] offset Offset of the allocation
+     */
+    void recordFree(
+            VkDeviceMemory                    memory,
+            VkDeviceSize                      offset);
+
+    /**
+     * \brief Reads trace header
+     * 
+     * \param [in] stream Input stream
+     * \param [out] header Trace header
+     * \returns \c true if the header is valid
+     */
+    static bool readHeader(
+            std::istream&                     stream,
+            DxvkMemoryTraceHeader&            header);
+
+    /**
+     * \brief Reads next trace record
+     * 
+     * \param [in] stream Input stream
+     * \param [out] record Trace record
+     * \returns \c true on success, \c false at
+     *          the end of the trace
+     */
+    static bool readRecord(
+            std::istream&                     stream,
+            DxvkMemoryTraceRecord&            record);
+
+  private:
+
+    struct Key {
+      VkDeviceMemory  memory;
+      VkDeviceSize    offset;
+
+      bool eq(const Key& other) const {
+        return memory == other.memory
+            && offset == other.offset;
+      }
+
+      size_t hash() const {
+        DxvkHashState result;
+        result.add(std::hash<VkDeviceMemory>()(memory));
+        result.add(std::hash<VkDeviceSize>()(offset));
+        return result;
+      }
+    };
+
+    dxvk::mutex     m_mutex;
+    std::ofstream   m_stream;
+    uint32_t        m_nextId = 0;
+
+    std::unordered_map<Key, uint32_t, DxvkHash, DxvkEq> m_ids;
+
+  };
+
+}
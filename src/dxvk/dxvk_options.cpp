@@ -4,11 +4,15 @@ namespace dxvk {
 
   DxvkOptions::DxvkOptions(const Config& config) {
     enableStateCache      = config.getOption<bool>    ("dxvk.enableStateCache",       true);
+    persistPipelineCache  = config.getOption<bool>    ("dxvk.persistPipelineCache",   true);
+    enableAsync           = config.getOption<bool>    ("dxvk.enableAsync",            false);
+    fastPipelineCompile   = config.getOption<bool>    ("dxvk.fastPipelineCompile",    false);
     enableOpenVR          = config.getOption<bool>    ("dxvk.enableOpenVR",           true);
     enableOpenXR          = config.getOption<bool>    ("dxvk.enableOpenXR",           true);
     numCompilerThreads    = config.getOption<int32_t> ("dxvk.numCompilerThreads",     0);
     useRawSsbo            = config.getOption<Tristate>("dxvk.useRawSsbo",             Tristate::Auto);
     halveNvidiaHVVHeap    = config.getOption<Tristate>("dxvk.halveNvidiaHVVHeap",     Tristate::Auto);
+    enableMemoryDefrag    = config.getOption<bool>    ("dxvk.enableMemoryDefrag",     false);
     hud                   = config.getOption<std::string>("dxvk.hud", "");
   }
 
@@ -11,6 +11,19 @@ namespace dxvk {
     /// Enable state cache
     bool enableStateCache;
 
+    /// Persist Vulkan pipeline cache
+    /// alongside the state cache
+    bool persistPipelineCache;
+
+    /// Compile graphics pipelines in the
+    /// background and skip draws until
+    /// they are ready
+    bool enableAsync;
+
+    /// Compile unoptimized graphics pipelines
+    /// first and optimize them in the background
+    bool fastPipelineCompile;
+
     /// Enables OpenVR loading
     bool enableOpenVR;
 
@@ -30,6 +43,11 @@ namespace dxvk {
     /// in half to avoid crash
     Tristate halveNvidiaHVVHeap;
 
+    /// Relocates buffers out of sparsely
+    /// used memory chunks so that those
+    /// can be freed
+    bool enableMemoryDefrag;
+
     /// HUD elements
     std::string hud;
   };
@@ -1,26 +1,220 @@
+#include <iomanip>
+#include <sstream>
+
+#include "dxvk_device.h"
 #include "dxvk_pipecache.h"
 
 namespace dxvk {
-  
+
   DxvkPipelineCache::DxvkPipelineCache(
-    const Rc<vk::DeviceFn>& vkd)
-  : m_vkd(vkd) {
+    const DxvkDevice*           device,
+          bool                  persistent)
+  : m_vkd(device->vkd()) {
+    const auto& properties = device->properties();
+
+    std::memcpy(m_header.deviceUUID, properties.coreDeviceId.deviceUUID, VK_UUID_SIZE);
+    std::memcpy(m_header.cacheUUID, properties.core.properties.pipelineCacheUUID, VK_UUID_SIZE);
+    m_header.vendorId       = properties.core.properties.vendorID;
+    m_header.deviceId       = properties.core.properties.deviceID;
+    m_header.driverVersion  = properties.core.properties.driverVersion;
+
+    std::vector<char> data;
+
+    if (persistent) {
+      m_fileName = getCacheFileName();
+
+      if (readCacheFile(data))
+        Logger::info(str::format("DXVK: Read ", data.size(), " bytes of pipeline cache data"));
+    }
+
     VkPipelineCacheCreateInfo info;
     info.sType            = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
     info.pNext            = nullptr;
     info.flags            = 0;
-    info.initialDataSize  = 0;
-    info.pInitialData     = nullptr;
-    
-    if (m_vkd->vkCreatePipelineCache(m_vkd->device(),
-        &info, nullptr, &m_handle) != VK_SUCCESS)
+    info.initialDataSize  = data.size();
+    info.pInitialData     = data.data();
+
+    VkResult vr = m_vkd->vkCreatePipelineCache(m_vkd->device(), &info, nullptr, &m_handle);
+
+    // Drivers may reject data that passed our own header checks,
+    // in which case we start over with an empty cache
+    if (vr != VK_SUCCESS && !data.empty()) {
+      Logger::warn("DXVK: Pipeline cache data rejected by driver");
+
+      info.initialDataSize  = 0;
+      info.pInitialData     = nullptr;
+
+      vr = m_vkd->vkCreatePipelineCache(m_vkd->device(), &info, nullptr, &m_handle);
+    }
+
+    if (vr != VK_SUCCESS)
       throw DxvkError("DxvkPipelineCache: Failed to create cache");
+
+    if (persistent)
+      m_writer = dxvk::thread([this] () { runWriter(); });
   }
-  
-  
+
+
   DxvkPipelineCache::~DxvkPipelineCache() {
+    if (m_writer.joinable()) {
+      { std::lock_guard<dxvk::mutex> lock(m_mutex);
+        m_stopped = true;
+      }
+
+      m_cond.notify_one();
+      m_writer.join();
+
+      // Write out any pipelines compiled since the last save
+      if (m_dirty)
+        writeCacheFile();
+    }
+
     m_vkd->vkDestroyPipelineCache(
       m_vkd->device(), m_handle, nullptr);
   }
-  
+
+
+  void DxvkPipelineCache::notifyPipelineCompiled() {
+    if (!m_writer.joinable())
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (!m_dirty) {
+      m_dirty = true;
+      m_cond.notify_one();
+    }
+  }
+
+
+  void DxvkPipelineCache::runWriter() {
+    env::setThreadName("dxvk-pcache");
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    while (true) {
+      m_cond.wait(lock, [this] {
+        return m_dirty || m_stopped;
+      });
+
+      // Pipelines tend to get compiled in bursts, so give
+      // the driver some time before writing the whole
+      // cache to disk again. Saving on shutdown is done
+      // by the destructor.
+      if (m_cond.wait_for(lock, SaveInterval, [this] { return m_stopped; }))
+        break;
+
+      m_dirty = false;
+
+      lock.unlock();
+      writeCacheFile();
+      lock.lock();
+    }
+  }
+
+
+  bool DxvkPipelineCache::readCacheFile(
+          std::vector<char>&    data) const {
+    std::ifstream file(m_fileName, std::ios_base::binary);
+
+    if (!file)
+      return false;
+
+    DxvkPipelineCacheHeader header;
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
+
+    bool compatible = !std::memcmp(header.magic, m_header.magic, sizeof(header.magic))
+      && header.version       == m_header.version
+      && header.vendorId      == m_header.vendorId
+      && header.deviceId      == m_header.deviceId
+      && header.driverVersion == m_header.driverVersion
+      && !std::memcmp(header.deviceUUID, m_header.deviceUUID, VK_UUID_SIZE)
+      && !std::memcmp(header.cacheUUID,  m_header.cacheUUID,  VK_UUID_SIZE);
+
+    if (!compatible) {
+      Logger::warn("DXVK: Pipeline cache file out of date, discarding");
+      return false;
+    }
+
+    // Reject absurd sizes before allocating anything
+    if (header.dataSize > MaxDataSize)
+      return false;
+
+    data.resize(header.dataSize);
+
+    if (!file.read(data.data(), data.size())
+     || Sha1Hash::compute(data.data(), data.size()) != header.dataHash) {
+      Logger::warn("DXVK: Pipeline cache file corrupted, discarding");
+      data.clear();
+      return false;
+    }
+
+    return true;
+  }
+
+
+  void DxvkPipelineCache::writeCacheFile() const {
+    size_t dataSize = 0;
+
+    if (m_vkd->vkGetPipelineCacheData(m_vkd->device(), m_handle, &dataSize, nullptr) != VK_SUCCESS)
+      return;
+
+    std::vector<char> data(dataSize);
+
+    // The cache may grow in between the two calls, in
+    // which case the driver writes what fits and returns
+    // VK_INCOMPLETE. That data is still valid.
+    VkResult vr = m_vkd->vkGetPipelineCacheData(m_vkd->device(), m_handle, &dataSize, data.data());
+
+    if (vr != VK_SUCCESS && vr != VK_INCOMPLETE)
+      return;
+
+    DxvkPipelineCacheHeader header = m_header;
+    header.dataSize = dataSize;
+    header.dataHash = Sha1Hash::compute(data.data(), dataSize);
+
+    // Write to a temporary file first so that the
+    // cache is never left in a half-written state
+    std::filesystem::path tmpName = m_fileName;
+    tmpName += L".tmp";
+
+    std::ofstream file(tmpName, std::ios_base::binary | std::ios_base::trunc);
+
+    if (!file && env::createDirectory(getCacheDir()))
+      file = std::ofstream(tmpName, std::ios_base::binary | std::ios_base::trunc);
+
+    if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+     || !file.write(data.data(), dataSize))
+      return;
+
+    file.close();
+
+    std::error_code ec;
+    std::filesystem::rename(tmpName, m_fileName, ec);
+
+    if (ec)
+      Logger::warn(str::format("DXVK: Failed to write pipeline cache: ", ec.message()));
+  }
+
+
+  std::filesystem::path DxvkPipelineCache::getCacheFileName() const {
+    // Key the file by device so that systems with multiple
+    // GPUs do not keep overwriting each other's cache data
+    std::stringstream uuid;
+
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+      uuid << std::hex << std::setw(2) << std::setfill('0') << uint32_t(m_header.deviceUUID[i]);
+
+    std::filesystem::path name = env::getExeName();
+    name.replace_extension(str::format(".", uuid.str(), ".dxvk-pipeline-cache"));
+    return getCacheDir() / name;
+  }
+
+
+  std::filesystem::path DxvkPipelineCache::getCacheDir() const {
+    return env::getEnvVar(L"DXVK_STATE_CACHE_PATH");
+  }
+
 }
@@ -11,20 +11,51 @@
 #include "../util/util_time.h"
 
 namespace dxvk {
-  
+
+  class DxvkDevice;
+
+  /**
+   * \brief Pipeline cache file header
+   *
+   * Identifies the device and driver that the cache
+   * data was created with, since drivers will reject
+   * or may even misbehave with foreign cache data.
+   */
+  struct DxvkPipelineCacheHeader {
+    char     magic[4]   = { 'D', 'X', 'V', 'P' };
+    uint32_t version    = 1;
+    uint8_t  deviceUUID[VK_UUID_SIZE] = { };
+    uint8_t  cacheUUID[VK_UUID_SIZE]  = { };
+    uint32_t vendorId       = 0;
+    uint32_t deviceId       = 0;
+    uint32_t driverVersion  = 0;
+    uint32_t reserved       = 0;
+    uint64_t dataSize       = 0;
+    Sha1Hash dataHash;
+  };
+
   /**
    * \brief Pipeline cache
-   * 
+   *
    * Allows the Vulkan implementation to
    * re-use previously compiled pipelines.
+   * If persistent, the cache data is loaded
+   * from disk on creation and written back
+   * in the background as pipelines get
+   * compiled, so that drivers without a
+   * disk cache of their own benefit too.
    */
   class DxvkPipelineCache : public RcObject {
-    
+    constexpr static auto SaveInterval = std::chrono::seconds(10);
+    constexpr static uint64_t MaxDataSize = 1ull << 30;
   public:
-    
-    DxvkPipelineCache(const Rc<vk::DeviceFn>& vkd);
+
+    DxvkPipelineCache(
+      const DxvkDevice*           device,
+            bool                  persistent);
+
     ~DxvkPipelineCache();
-    
+
     /**
      * \brief Pipeline cache handle
      * \returns Pipeline cache handle
@@ -32,12 +63,41 @@ namespace dxvk {
     VkPipelineCache handle() const {
       return m_handle;
     }
-    
+
+    /**
+     * \brief Notifies the cache of a new pipeline
+     *
+     * Must be called after successfully compiling a
+     * pipeline with this cache, so that the cache
+     * data gets written to disk eventually.
+     */
+    void notifyPipelineCompiled();
+
   private:
-    
+
     Rc<vk::DeviceFn>        m_vkd;
-    VkPipelineCache         m_handle;
-    
+    VkPipelineCache         m_handle = VK_NULL_HANDLE;
+
+    DxvkPipelineCacheHeader m_header;
+    std::filesystem::path   m_fileName;
+
+    dxvk::mutex             m_mutex;
+    dxvk::condition_variable m_cond;
+    bool                    m_dirty   = false;
+    bool                    m_stopped = false;
+    dxvk::thread            m_writer;
+
+    void runWriter();
+
+    bool readCacheFile(
+            std::vector<char>&    data) const;
+
+    void writeCacheFile() const;
+
+    std::filesystem::path getCacheFileName() const;
+
+    std::filesystem::path getCacheDir() const;
+
   };
-  
+
 }
@@ -7,17 +7,45 @@ namespace dxvk {
   DxvkPipelineManager::DxvkPipelineManager(
     const DxvkDevice*         device,
           DxvkRenderPassPool* passManager)
-  : m_device    (device),
-    m_cache     (new DxvkPipelineCache(device->vkd())) {
+  : m_device    (device) {
     std::string useStateCache = env::getEnvVar("DXVK_STATE_CACHE");
     
-    if (useStateCache != "0" && device->config().enableStateCache)
+    bool enableStateCache = useStateCache != "0" && device->config().enableStateCache;
+
+    // The pipeline cache file is stored alongside the
+    // state cache, so only persist it if that is enabled
+    m_cache = new DxvkPipelineCache(device,
+      enableStateCache && device->config().persistPipelineCache);
+
+    if (enableStateCache)
       m_stateCache = new DxvkStateCache(device, this, passManager);
+
+    // Background compile jobs run on the state cache's
+    // compiler threads, so both of these depend on it
+    if (device->config().enableAsync) {
+      if (m_stateCache != nullptr) {
+        Logger::info("DXVK: Using asynchronous pipeline compilation");
+        m_asyncCompile = true;
+      } else {
+        Logger::warn("DXVK: Asynchronous pipeline compilation requires the state cache");
+      }
+    }
+
+    if (device->config().fastPipelineCompile) {
+      if (m_stateCache != nullptr) {
+        Logger::info("DXVK: Using unoptimized pipelines until optimized ones are ready");
+        m_fastCompile = true;
+      } else {
+        Logger::warn("DXVK: Fast pipeline compilation requires the state cache");
+      }
+    }
   }
   
   
   DxvkPipelineManager::~DxvkPipelineManager() {
-    
+    // Stop the compiler threads before destroying
+    // the pipelines that they may be working on
+    m_stateCache = nullptr;
   }
   
   
@@ -64,5 +92,11 @@ namespace dxvk {
     return m_stateCache != nullptr
         && m_stateCache->isCompilingShaders();
   }
+
+
+  void DxvkPipelineManager::compileAsync(
+          std::function<void()>&&   job) {
+    m_stateCache->enqueueCompileJob(std::move(job));
+  }
   
 }
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <functional>
 #include <mutex>
 #include <unordered_map>
 
@@ -89,12 +90,43 @@ namespace dxvk {
      * \returns \c true if shaders are being compiled
      */
     bool isCompilingShaders() const;
+
+    /**
+     * \brief Compiles a pipeline in the background
+     * 
+     * Queues the job on the state cache compiler threads.
+     * Only valid if asynchronous compilation is enabled.
+     * \param [in] job Compile job
+     */
+    void compileAsync(
+            std::function<void()>&&   job);
+
+    /**
+     * \brief Checks whether to compile pipelines asynchronously
+     * \returns \c true if pipelines that are not ready yet
+     *    should be compiled in the background
+     */
+    bool useAsyncCompilation() const {
+      return m_asyncCompile;
+    }
+
+    /**
+     * \brief Checks whether to compile unoptimized pipelines first
+     * \returns \c true if pipelines that need to be compiled
+     *    immediately should be compiled without optimizations,
+     *    and be replaced by optimized ones in the background
+     */
+    bool useFastCompilation() const {
+      return m_fastCompile;
+    }
     
   private:
     
     const DxvkDevice*         m_device;
     Rc<DxvkPipelineCache>     m_cache;
     Rc<DxvkStateCache>        m_stateCache;
+    bool                      m_asyncCompile = false;
+    bool                      m_fastCompile  = false;
 
     std::atomic<uint32_t>     m_numComputePipelines  = { 0 };
     std::atomic<uint32_t>     m_numGraphicsPipelines = { 0 };
@@ -82,11 +82,30 @@ namespace dxvk {
         return !isInUse(access);
       });
     }
+
+    /**
+     * \brief Queries storage version
+     *
+     * Incremented whenever the backing storage of the
+     * resource changes. Commands that were recorded for
+     * a previous version must not be executed again.
+     * \returns Current storage version
+     */
+    uint32_t getVersion() const {
+      return m_version.load(std::memory_order_relaxed);
+    }
     
+  protected:
+
+    void incrementVersion() {
+      m_version.fetch_add(1, std::memory_order_relaxed);
+    }
+
   private:
     
     std::atomic<uint32_t> m_useCountR = { 0u };
     std::atomic<uint32_t> m_useCountW = { 0u };
+    std::atomic<uint32_t> m_version   = { 0u };
 
   };
   
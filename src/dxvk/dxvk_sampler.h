@@ -64,10 +64,19 @@ namespace dxvk {
     VkSampler handle() const {
       return m_sampler;
     }
+
+    /**
+     * \brief Sampler properties
+     * \returns Sampler create info
+     */
+    const DxvkSamplerCreateInfo& info() const {
+      return m_info;
+    }
     
   private:
     
     Rc<vk::DeviceFn>      m_vkd;
+    DxvkSamplerCreateInfo m_info;
     VkSampler             m_sampler = VK_NULL_HANDLE;
 
     static VkBorderColor getBorderColor(
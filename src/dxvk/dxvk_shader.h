@@ -200,6 +200,17 @@ namespace dxvk {
       return m_interface;
     }
 
+    /**
+     * \brief Resource slots
+     * 
+     * Retrieves the resource slots that were
+     * passed in when creating the shader.
+     * \returns Resource slots
+     */
+    const std::vector<DxvkResourceSlot>& resourceSlots() const {
+      return m_slots;
+    }
+
     /**
      * \brief Shader options
      * \returns Shader options
@@ -22,6 +22,14 @@ namespace dxvk {
      */
     void add(const Rc<sync::Signal>& signal, uint64_t value);
     
+    /**
+     * \brief Checks whether any signals are tracked
+     * \returns \c true if no signals are tracked
+     */
+    bool empty() const {
+      return m_signals.empty();
+    }
+
     /**
      * \brief Notifies tracked signals
      */
@@ -4,7 +4,7 @@
 namespace dxvk {
   
   DxvkStagingDataAlloc::DxvkStagingDataAlloc(const Rc<DxvkDevice>& device)
-  : m_device(device) {
+  : m_device(device), m_signal(new sync::Fence()) {
 
   }
 
@@ -15,43 +15,177 @@ namespace dxvk {
 
 
   DxvkBufferSlice DxvkStagingDataAlloc::alloc(VkDeviceSize align, VkDeviceSize size) {
+    m_cmdBytes += size;
+
     if (size > MaxBufferSize)
       return DxvkBufferSlice(createBuffer(size));
-    
-    if (m_buffer == nullptr)
-      m_buffer = createBuffer(MaxBufferSize);
-    
-    if (!m_buffer->isInUse())
-      m_offset = 0;
-    
-    m_offset = dxvk::align(m_offset, align);
-
-    if (m_offset + size > MaxBufferSize) {
-      m_offset = 0;
-
-      if (m_buffers.size() < MaxBufferCount)
-        m_buffers.push(std::move(m_buffer));
-
-      if (!m_buffers.front()->isInUse()) {
-        m_buffer = std::move(m_buffers.front());
-        m_buffers.pop();
-      } else {
-        m_buffer = createBuffer(MaxBufferSize);
-      }
+
+    m_frameBytes += size;
+
+    VkDeviceSize offset = 0;
+
+    if (allocRange(align, size, offset))
+      return DxvkBufferSlice(m_buffer, offset, size);
+
+    if (m_size < MaxRingSize) {
+      // In-flight uploads do not fit into the ring, replace it with
+      // a larger one. Command lists that still use the old buffer
+      // keep it alive until they have completed.
+      VkDeviceSize newSize = 2 * m_size;
+
+      while (newSize < size)
+        newSize *= 2;
+
+      this->resetRing(newSize);
+      this->allocRange(align, size, offset);
+      return DxvkBufferSlice(m_buffer, offset, size);
     }
 
-    DxvkBufferSlice slice(m_buffer, m_offset, size);
-    m_offset = dxvk::align(m_offset + size, align);
-    return slice;
+    // The ring is already as large as it gets, so wait for
+    // submitted command lists to release memory rather than
+    // replacing the ring with another buffer of the same size.
+    while (!m_ranges.empty()) {
+      m_signal->wait(m_ranges.front().sequence);
+
+      if (allocRange(align, size, offset))
+        return DxvkBufferSlice(m_buffer, offset, size);
+    }
+
+    // The current command list alone uses up the entire
+    // ring, use a dedicated buffer for this allocation.
+    return DxvkBufferSlice(createBuffer(size));
+  }
+
+
+  DxvkBufferSlice DxvkStagingDataAlloc::allocStream(VkDeviceSize align, VkDeviceSize size) {
+    // The ring must be able to hold the entire streaming
+    // window, which needs to be flushed in two halves so
+    // that the GPU can copy one while we fill the other.
+    if (m_size < StreamWindowSize)
+      this->resetRing(StreamWindowSize);
+
+    if (m_head != m_cmdStart && m_head - m_cmdStart + size > StreamWindowSize / 2)
+      return DxvkBufferSlice();
+
+    VkDeviceSize offset = 0;
+
+    while (!allocRange(align, size, offset)) {
+      if (m_ranges.empty())
+        return DxvkBufferSlice();
+
+      m_signal->wait(m_ranges.front().sequence);
+    }
+
+    m_cmdBytes   += size;
+    m_frameBytes += size;
+    return DxvkBufferSlice(m_buffer, offset, size);
+  }
+
+
+  void DxvkStagingDataAlloc::endCommandList(const Rc<DxvkCommandList>& cmd) {
+    if (m_cmdBytes) {
+      cmd->addStatCtr(DxvkStatCounter::StagingDataBytes, m_cmdBytes);
+      m_cmdBytes = 0;
+    }
+
+    if (m_head != m_cmdStart) {
+      m_ranges.push({ ++m_sequence, m_head });
+      m_cmdStart = m_head;
+
+      cmd->queueSignal(m_signal, m_sequence);
+    }
+
+    this->shrinkRing();
   }
 
 
   void DxvkStagingDataAlloc::trim() {
-    m_buffer = nullptr;
-    m_offset = 0;
+    this->resetRing(MinBufferSize);
+
+    m_peakFrameBytes = 0;
+    m_shrinkFrameId = m_frameId;
+  }
+
+
+  bool DxvkStagingDataAlloc::allocRange(
+          VkDeviceSize          align,
+          VkDeviceSize          size,
+          VkDeviceSize&         offset) {
+    if (m_buffer == nullptr) {
+      if (size > m_size)
+        return false;
+
+      m_buffer = createBuffer(m_size);
+    }
+
+    VkDeviceSize head = dxvk::align(m_head, align);
+
+    // Don't wrap allocations around the end of the buffer
+    if ((head & (m_size - 1)) + size > m_size)
+      head = dxvk::align(head, m_size);
+
+    if (head + size - m_tail > m_size) {
+      this->retireRanges();
+
+      if (head + size - m_tail > m_size)
+        return false;
+    }
+
+    m_head = head + size;
+    offset = head & (m_size - 1);
+    return true;
+  }
+
+
+  void DxvkStagingDataAlloc::retireRanges() {
+    uint64_t completed = m_signal->value();
+
+    while (!m_ranges.empty() && m_ranges.front().sequence <= completed) {
+      m_tail = m_ranges.front().end;
+      m_ranges.pop();
+    }
+  }
+
+
+  void DxvkStagingDataAlloc::resetRing(VkDeviceSize size) {
+    if (size != m_size)
+      Logger::debug(str::format("Staging: Resizing ring to ", size >> 20, " MB"));
+
+    m_buffer    = nullptr;
+    m_size      = size;
+    m_head      = 0;
+    m_tail      = 0;
+    m_cmdStart  = 0;
+
+    while (!m_ranges.empty())
+      m_ranges.pop();
+  }
+
+
+  void DxvkStagingDataAlloc::shrinkRing() {
+    uint32_t frameId = m_device->getCurrentFrameId();
+
+    if (frameId == m_frameId)
+      return;
+
+    m_frameId = frameId;
+    m_peakFrameBytes = std::max(m_peakFrameBytes, m_frameBytes);
+    m_frameBytes = 0;
+
+    if (frameId - m_shrinkFrameId < ShrinkFrameCount)
+      return;
+
+    // Keep enough space for a few frames in flight
+    VkDeviceSize size = MinBufferSize;
+
+    while (size < 4 * m_peakFrameBytes && size < m_size)
+      size *= 2;
+
+    if (size < m_size)
+      this->resetRing(size);
 
-    while (!m_buffers.empty())
-      m_buffers.pop();
+    m_peakFrameBytes = 0;
+    m_shrinkFrameId = frameId;
   }
 
 
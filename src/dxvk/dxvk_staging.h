@@ -6,20 +6,33 @@
 
 namespace dxvk {
   
+  class DxvkCommandList;
   class DxvkDevice;
 
   /**
    * \brief Staging data allocator
    *
-   * Allocates buffer slices for resource uploads,
-   * while trying to keep the number of allocations
-   * but also the amount of allocated memory low.
+   * Allocates buffer slices for resource uploads from
+   * a ring buffer. Memory is handed out linearly, and
+   * the range used by a command list is reused once
+   * the GPU has finished executing that command list.
+   *
+   * The ring grows whenever in-flight uploads do not
+   * fit, up to a fixed maximum size, and shrinks again
+   * if the per-frame upload volume stays low for a while.
+   * Once the ring has reached its maximum size, allocations
+   * wait for the GPU to release memory instead.
    */
   class DxvkStagingDataAlloc {
-    constexpr static VkDeviceSize MaxBufferSize  = 1 << 25; // 32 MiB
-    constexpr static uint32_t     MaxBufferCount = 2;
+    constexpr static VkDeviceSize MinBufferSize    = 1 << 22; // 4 MiB
+    constexpr static VkDeviceSize MaxBufferSize    = 1 << 25; // 32 MiB
+    constexpr static VkDeviceSize MaxRingSize      = 1 << 27; // 128 MiB
+    constexpr static uint32_t     ShrinkFrameCount = 120;
   public:
 
+    constexpr static VkDeviceSize StreamChunkSize  = 1 << 23; // 8 MiB
+    constexpr static VkDeviceSize StreamWindowSize = MaxBufferSize;
+
     DxvkStagingDataAlloc(const Rc<DxvkDevice>& device);
 
     ~DxvkStagingDataAlloc();
@@ -27,12 +40,50 @@ namespace dxvk {
     /**
      * \brief Alloctaes a staging buffer slice
      * 
+     * The slice remains valid until the command list
+     * that is currently being recorded has completed.
      * \param [in] align Alignment of the allocation
      * \param [in] size Size of the allocation
      * \returns Staging buffer slice
      */
     DxvkBufferSlice alloc(VkDeviceSize align, VkDeviceSize size);
 
+    /**
+     * \brief Allocates a staging buffer slice for streaming
+     *
+     * Used to upload large amounts of data in pieces of at
+     * most \c StreamChunkSize bytes. Rather than growing the
+     * ring, this waits for previously submitted command lists
+     * to complete so that memory usage stays bounded.
+     * \param [in] align Alignment of the allocation
+     * \param [in] size Size of the allocation
+     * \returns Staging buffer slice, or an undefined slice
+     *    if the current command list must be submitted first
+     */
+    DxvkBufferSlice allocStream(VkDeviceSize align, VkDeviceSize size);
+
+    /**
+     * \brief Checks whether an upload should be streamed
+     *
+     * \param [in] size Total size of the upload
+     * \returns \c true if the upload is too large to
+     *    be served by a single staging allocation
+     */
+    static bool needsStreaming(VkDeviceSize size) {
+      return size > MaxBufferSize;
+    }
+
+    /**
+     * \brief Ends the current command list
+     *
+     * Assigns all memory allocated since the previous
+     * call to the given command list, so that it can
+     * be reused once the command list has completed.
+     * Also records the number of bytes uploaded.
+     * \param [in] cmd The command list
+     */
+    void endCommandList(const Rc<DxvkCommandList>& cmd);
+
     /**
      * \brief Deletes all staging buffers
      * 
@@ -43,11 +94,43 @@ namespace dxvk {
 
   private:
 
-    Rc<DxvkDevice>  m_device;
-    Rc<DxvkBuffer>  m_buffer;
-    VkDeviceSize    m_offset = 0;
+    struct Range {
+      uint64_t      sequence;
+      VkDeviceSize  end;
+    };
+
+    Rc<DxvkDevice>    m_device;
+    Rc<DxvkBuffer>    m_buffer;
+    Rc<sync::Fence>   m_signal;
+
+    VkDeviceSize      m_size = MinBufferSize;
+
+    // Ring positions increase monotonically and
+    // are mapped to buffer offsets modulo size
+    VkDeviceSize      m_head = 0;
+    VkDeviceSize      m_tail = 0;
+    VkDeviceSize      m_cmdStart = 0;
+
+    uint64_t          m_sequence = 0;
+    std::queue<Range> m_ranges;
+
+    VkDeviceSize      m_cmdBytes = 0;
+    VkDeviceSize      m_frameBytes = 0;
+    VkDeviceSize      m_peakFrameBytes = 0;
+
+    uint32_t          m_frameId = 0;
+    uint32_t          m_shrinkFrameId = 0;
+
+    bool allocRange(
+            VkDeviceSize          align,
+            VkDeviceSize          size,
+            VkDeviceSize&         offset);
+
+    void retireRanges();
+
+    void resetRing(VkDeviceSize size);
 
-    std::queue<Rc<DxvkBuffer>> m_buffers;
+    void shrinkRing();
 
     Rc<DxvkBuffer> createBuffer(VkDeviceSize size);
 
@@ -80,6 +80,18 @@ namespace dxvk {
       return m_workerPool.running() > 0;
     }
 
+    /**
+     * \brief Queues a pipeline compile job
+     * 
+     * Runs the job on the same compiler threads
+     * that compile pipelines from the cache.
+     * \param [in] job The job
+     */
+    template<typename Fn>
+    void enqueueCompileJob(Fn&& job) {
+      m_workerPool.enqueue(std::forward<Fn>(job));
+    }
+
   private:
 
     using WriterItem = DxvkStateCacheEntry;
@@ -109,10 +121,12 @@ namespace dxvk {
       DxvkShaderKey, Rc<DxvkShader>,
       DxvkHash, DxvkEq> m_shaderMap;
 
-    DxvkThreadPool m_workerPool;
-
     DxvkThreadPool m_writerPool{ThreadPriority::Normal, 1};
 
+    // Must be destroyed first since compile
+    // jobs may queue writes to the cache file
+    DxvkThreadPool m_workerPool;
+
     DxvkShaderKey getShaderKey(
       const Rc<DxvkShader>&           shader) const;
 
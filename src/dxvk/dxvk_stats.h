@@ -20,6 +20,11 @@ namespace dxvk {
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
     GpuIdleTicks,             ///< GPU idle time in microseconds
+    StagingDataBytes,         ///< Bytes uploaded through staging buffers
+    DataBufferAllocCount,     ///< Number of data buffer allocations
+    DataBufferReuseCount,     ///< Number of data buffers reusing pooled memory
+    CsCmdsSkipped,            ///< Number of redundant CS commands skipped
+    CmdDrawsSkipped,          ///< Number of draws skipped due to missing pipelines
     NumCounters,              ///< Number of counters available
   };
   
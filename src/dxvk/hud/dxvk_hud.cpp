@@ -41,8 +41,12 @@ namespace dxvk::hud {
     addItem<HudFrameTimeItem>("frametimes", -1);
     addItem<HudSubmissionStatsItem>("submissions", -1, device);
     addItem<HudDrawCallStatsItem>("drawcalls", -1, device);
+#ifdef DXVK_CS_PROFILING
+    addItem<HudCsProfileItem>("csprofile", -1);
+#endif
     addItem<HudPipelineStatsItem>("pipelines", -1, device);
     addItem<HudMemoryStatsItem>("memory", -1, device);
+    addItem<HudStagingStatsItem>("staging", -1, device);
     addItem<HudGpuLoadItem>("gpuload", -1, device);
     addItem<HudCompilerActivityItem>("compiler", -1, device);
   }
@@ -356,6 +356,8 @@ namespace dxvk::hud {
       m_gpCount = diffCounters.getCtr(DxvkStatCounter::CmdDrawCalls);
       m_cpCount = diffCounters.getCtr(DxvkStatCounter::CmdDispatchCalls);
       m_rpCount = diffCounters.getCtr(DxvkStatCounter::CmdRenderPassCount);
+      m_skCount = diffCounters.getCtr(DxvkStatCounter::CsCmdsSkipped);
+      m_sdCount = diffCounters.getCtr(DxvkStatCounter::CmdDrawsSkipped);
 
       m_lastUpdate = time;
     }
@@ -400,11 +402,113 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       str::format(m_rpCount));
     
+    if (m_skCount) {
+      position.y += 20.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 0.25f, 0.5f, 1.0f, 1.0f },
+        "Skipped state:");
+      
+      renderer.drawText(16.0f,
+        { position.x + 192.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        str::format(m_skCount));
+    }
+    
+    if (m_sdCount) {
+      position.y += 20.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 0.25f, 0.5f, 1.0f, 1.0f },
+        "Skipped draws:");
+      
+      renderer.drawText(16.0f,
+        { position.x + 192.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        str::format(m_sdCount));
+    }
+    
     position.y += 8.0f;
     return position;
   }
 
 
+#ifdef DXVK_CS_PROFILING
+  HudCsProfileItem::HudCsProfileItem() {
+
+  }
+
+
+  HudCsProfileItem::~HudCsProfileItem() {
+
+  }
+
+
+  void HudCsProfileItem::update(dxvk::high_resolution_clock::time_point time) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    if (elapsed.count() < UpdateInterval)
+      return;
+
+    m_entries = DxvkCsProfiler::instance().getEntries();
+
+    for (auto& entry : m_entries) {
+      auto& prev = m_prevEntries[entry.name];
+
+      DxvkCsProfileEntry total = entry;
+      entry.count  -= prev.count;
+      entry.timeNs -= prev.timeNs;
+      prev = std::move(total);
+    }
+
+    std::sort(m_entries.begin(), m_entries.end(),
+      [] (const DxvkCsProfileEntry& a, const DxvkCsProfileEntry& b) {
+        return a.timeNs > b.timeNs;
+      });
+
+    if (m_entries.size() > MaxEntryCount)
+      m_entries.resize(MaxEntryCount);
+
+    m_lastUpdate = time;
+  }
+
+
+  HudPos HudCsProfileItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.5f, 0.25f, 1.0f },
+      "CS commands:");
+
+    for (const auto& entry : m_entries) {
+      if (!entry.count)
+        break;
+
+      position.y += 20.0f;
+      renderer.drawText(14.0f,
+        { position.x, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        entry.name);
+
+      renderer.drawText(14.0f,
+        { position.x + 288.0f, position.y },
+        { 1.0f, 1.0f, 0.25f, 1.0f },
+        str::format(std::setfill(' '), std::setw(7), entry.count));
+
+      renderer.drawText(14.0f,
+        { position.x + 376.0f, position.y },
+        { 0.25f, 1.0f, 0.25f, 1.0f },
+        str::format(std::setfill(' '), std::setw(7), entry.timeNs / 1000, " us"));
+    }
+
+    position.y += 8.0f;
+    return position;
+  }
+#endif
+
+
   HudPipelineStatsItem::HudPipelineStatsItem(const Rc<DxvkDevice>& device)
   : m_device(device) {
 
@@ -501,6 +605,76 @@ namespace dxvk::hud {
   }
 
 
+  HudStagingStatsItem::HudStagingStatsItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudStagingStatsItem::~HudStagingStatsItem() {
+
+  }
+
+
+  void HudStagingStatsItem::update(dxvk::high_resolution_clock::time_point time) {
+    DxvkStatCounters counters = m_device->getStatCounters();
+
+    uint64_t currBytes = counters.getCtr(DxvkStatCounter::StagingDataBytes);
+    m_diffBytes += currBytes - m_prevBytes;
+    m_prevBytes  = currBytes;
+    m_frameCount += 1;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    if (elapsed.count() >= UpdateInterval) {
+      m_showBytes  = m_diffBytes / m_frameCount;
+      m_diffBytes  = 0;
+      m_frameCount = 0;
+
+      auto diffCounters = counters.diff(m_prevCounters);
+      uint64_t allocCount = diffCounters.getCtr(DxvkStatCounter::DataBufferAllocCount);
+      uint64_t reuseCount = diffCounters.getCtr(DxvkStatCounter::DataBufferReuseCount);
+
+      if (allocCount)
+        m_reuseRate = (100 * reuseCount) / allocCount;
+
+      m_prevCounters = counters;
+      m_lastUpdate = time;
+    }
+  }
+
+
+  HudPos HudStagingStatsItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 0.25f, 1.0f },
+      "Staging data:");
+
+    renderer.drawText(16.0f,
+      { position.x + 168.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(std::setfill(' '), std::setw(5), m_showBytes >> 10, " kB / frame"));
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 0.25f, 1.0f },
+      "Data reuse:");
+
+    renderer.drawText(16.0f,
+      { position.x + 168.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(std::setfill(' '), std::setw(5), m_reuseRate, "%"));
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
   HudGpuLoadItem::HudGpuLoadItem(const Rc<DxvkDevice>& device)
   : m_device(device) {
 
@@ -9,6 +9,10 @@
 
 #include "dxvk_hud_renderer.h"
 
+#ifdef DXVK_CS_PROFILING
+#include "../dxvk_cs_profiler.h"
+#endif
+
 namespace dxvk::hud {
 
   /**
@@ -294,6 +298,8 @@ namespace dxvk::hud {
     uint64_t          m_gpCount = 0;
     uint64_t          m_cpCount = 0;
     uint64_t          m_rpCount = 0;
+    uint64_t          m_skCount = 0;
+    uint64_t          m_sdCount = 0;
 
     dxvk::high_resolution_clock::time_point m_lastUpdate
       = dxvk::high_resolution_clock::now();
@@ -301,6 +307,40 @@ namespace dxvk::hud {
   };
 
 
+#ifdef DXVK_CS_PROFILING
+  /**
+   * \brief HUD item to display CS command profile
+   *
+   * Shows the functions whose CS commands took the
+   * most time to execute during the last interval.
+   */
+  class HudCsProfileItem : public HudItem {
+    constexpr static int64_t  UpdateInterval = 500'000;
+    constexpr static uint32_t MaxEntryCount  = 8;
+  public:
+
+    HudCsProfileItem();
+
+    ~HudCsProfileItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    std::unordered_map<std::string, DxvkCsProfileEntry> m_prevEntries;
+    std::vector<DxvkCsProfileEntry>                     m_entries;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+#endif
+
+
   /**
    * \brief HUD item to display pipeline counts
    */
@@ -354,6 +394,41 @@ namespace dxvk::hud {
   };
 
 
+  /**
+   * \brief HUD item to display staging data uploads
+   */
+  class HudStagingStatsItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudStagingStatsItem(const Rc<DxvkDevice>& device);
+
+    ~HudStagingStatsItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>    m_device;
+
+    uint64_t          m_prevBytes = 0;
+    uint64_t          m_diffBytes = 0;
+    uint64_t          m_frameCount = 0;
+    uint64_t          m_showBytes = 0;
+
+    DxvkStatCounters  m_prevCounters;
+    uint64_t          m_reuseRate = 0;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
   /**
    * \brief HUD item to display GPU load
    */
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "../util_bit.h"
+#include "../util_likely.h"
+#include "../util_math.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Rounds queue capacity to a power of two
+   *
+   * \param [in] capacity Requested capacity
+   * \returns Actual queue capacity
+   */
+  inline uint32_t roundQueueCapacity(uint32_t capacity) {
+    return capacity > 1 ? 1u << (32 - bit::lzcnt(capacity - 1)) : 1u;
+  }
+
+
+  /**
+   * \brief Bounded multi-producer, single-consumer queue
+   *
+   * Lock-free ring buffer with a fixed capacity. Any
+   * number of threads can push items concurrently,
+   * while only one thread at a time may pop items.
+   * Each slot stores a sequence number which tells
+   * producers and the consumer whether the slot is
+   * free or holds an item for the current lap.
+   * \tparam T Item type, must be copyable
+   */
+  template<typename T>
+  class BoundedMpscQueue {
+
+  public:
+
+    explicit BoundedMpscQueue(uint32_t capacity)
+    : m_capacity(roundQueueCapacity(capacity)),
+      m_slots   (new Slot[m_capacity]) {
+      for (uint32_t i = 0; i < m_capacity; i++)
+        m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedMpscQueue             (const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator = (const BoundedMpscQueue&) = delete;
+
+    /**
+     * \brief Queue capacity
+     * \returns Maximum number of items
+     */
+    uint32_t capacity() const {
+      return m_capacity;
+    }
+
+    /**
+     * \brief Adds an item to the queue
+     *
+     * Thread-safe and lock-free.
+     * \param [in] item The item
+     * \returns \c false if the queue is full
+     */
+    bool push(const T& item) {
+      uint64_t pos = m_head.load(std::memory_order_relaxed);
+      Slot* slot;
+
+      while (true) {
+        slot = &m_slots[pos & (m_capacity - 1)];
+
+        uint64_t seq = slot->seq.load(std::memory_order_acquire);
+        int64_t diff = int64_t(seq - pos);
+
+        if (likely(!diff)) {
+          if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        } else if (diff < 0) {
+          return false;
+        } else {
+          pos = m_head.load(std::memory_order_relaxed);
+        }
+      }
+
+      slot->item = item;
+      slot->seq.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * \brief Removes an item from the queue
+     *
+     * Must not be called from multiple threads
+     * concurrently. Never blocks, but may fail
+     * to return an item that is still being
+     * written by a producer.
+     * \param [out] item The item
+     * \returns \c false if no item was available
+     */
+    bool pop(T& item) {
+      Slot* slot = &m_slots[m_tail & (m_capacity - 1)];
+
+      if (slot->seq.load(std::memory_order_acquire) != m_tail + 1)
+        return false;
+
+      item = slot->item;
+      slot->seq.store(m_tail + m_capacity, std::memory_order_release);
+
+      m_tail += 1;
+      return true;
+    }
+
+  private:
+
+    struct Slot {
+      std::atomic<uint64_t> seq;
+      T                     item;
+    };
+
+    const uint32_t          m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint64_t>   m_head = { 0ull };
+
+    alignas(CACHE_LINE_SIZE)
+    uint64_t                m_tail = 0ull;
+
+  };
+
+
+  /**
+   * \brief Bounded single-producer, single-consumer queue
+   *
+   * Lock-free ring buffer with a fixed capacity. One
+   * thread at a time may push items while another
+   * thread pops them. Each side caches the position
+   * of the other side in order to avoid touching the
+   * other side's cache line on every operation.
+   * \tparam T Item type, must be movable
+   */
+  template<typename T>
+  class BoundedSpscQueue {
+
+  public:
+
+    explicit BoundedSpscQueue(uint32_t capacity)
+    : m_capacity(roundQueueCapacity(capacity)),
+      m_items   (new T[m_capacity]) { }
+
+    BoundedSpscQueue             (const BoundedSpscQueue&) = delete;
+    BoundedSpscQueue& operator = (const BoundedSpscQueue&) = delete;
+
+    /**
+     * \brief Queue capacity
+     * \returns Maximum number of items
+     */
+    uint32_t capacity() const {
+      return m_capacity;
+    }
+
+    /**
+     * \brief Adds an item to the queue
+     *
+     * Must only be called by the producer thread. The
+     * item is only moved from if the push succeeds.
+     * \param [in] item The item
+     * \returns \c false if the queue is full
+     */
+    bool push(T&& item) {
+      uint64_t head = m_head.load(std::memory_order_relaxed);
+
+      if (head - m_cachedTail == m_capacity) {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+        if (head - m_cachedTail == m_capacity)
+          return false;
+      }
+
+      m_items[head & (m_capacity - 1)] = std::move(item);
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * \brief Removes an item from the queue
+     *
+     * Must only be called by the consumer thread.
+     * \param [out] item The item
+     * \returns \c false if the queue is empty
+     */
+    bool pop(T& item) {
+      uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+      if (tail == m_cachedHead) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+
+        if (tail == m_cachedHead)
+          return false;
+      }
+
+      item = std::move(m_items[tail & (m_capacity - 1)]);
+      m_tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+  private:
+
+    const uint32_t          m_capacity;
+    std::unique_ptr<T[]>    m_items;
+
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint64_t>   m_head = { 0ull };
+    uint64_t                m_cachedTail = 0ull;
+
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint64_t>   m_tail = { 0ull };
+    uint64_t                m_cachedHead = 0ull;
+
+  };
+
+}
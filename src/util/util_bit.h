@@ -92,6 +92,12 @@ namespace dxvk::bit {
     #endif
   }
 
+  inline uint32_t lzcnt(uint64_t n) {
+    uint32_t hi = uint32_t(n >> 32);
+    uint32_t lo = uint32_t(n);
+    return hi != 0 ? lzcnt(hi) : 32 + lzcnt(lo);
+  }
+
   template<typename T>
   uint32_t pack(T& dst, uint32_t& shift, T src, uint32_t count) {
     constexpr uint32_t Bits = 8 * sizeof(T);
@@ -162,6 +168,29 @@ namespace dxvk::bit {
     #endif
   }
 
+  /**
+   * \brief Hashes an aligned struct bit by bit
+   *
+   * Consistent with \ref bcmpeq, i.e. structs that
+   * compare equal will always produce the same hash.
+   * \param [in] a The struct
+   * \returns Hash of the raw struct data
+   */
+  template<typename T>
+  size_t bhash(const T* a) {
+    static_assert(alignof(T) >= 8 && !(sizeof(T) % 8));
+    auto data = reinterpret_cast<const uint64_t*>(a);
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (size_t i = 0; i < sizeof(T) / 8; i++) {
+      hash = (hash ^ data[i]) * 0x9e3779b97f4a7c15ull;
+      hash ^= hash >> 29;
+    }
+
+    return size_t(hash ^ (hash >> 32));
+  }
+
   template <size_t Bits>
   class bitset {
     static constexpr size_t Dwords = align(Bits, 32) / 32;
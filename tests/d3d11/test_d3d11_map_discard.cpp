@@ -0,0 +1,180 @@
+#include <array>
+#include <cstring>
+#include <fstream>
+
+#include <d3dcompiler.h>
+#include <d3d11.h>
+
+#include <windows.h>
+#include <windowsx.h>
+
+#include "../test_utils.h"
+
+using namespace dxvk;
+
+const std::string g_computeShaderCode =
+  "cbuffer cb_in : register(b0) {\n"
+  "  uint4 value;\n"
+  "};\n"
+  "RWByteAddressBuffer buf_out : register(u0);\n"
+  "[numthreads(1,1,1)]\n"
+  "void main() {\n"
+  "  buf_out.Store4(0, value);\n"
+  "}\n";
+
+Com<ID3D11Device>               g_device;
+Com<ID3D11DeviceContext>        g_context;
+Com<ID3D11Buffer>               g_dstBuffer;
+Com<ID3D11Buffer>               g_readBuffer;
+
+bool checkResult(const std::array<uint32_t, 4>& expected) {
+  g_context->Dispatch(1, 1, 1);
+  g_context->CopyResource(g_readBuffer.ptr(), g_dstBuffer.ptr());
+
+  // Waits for the GPU, which retires and frees buffer slices
+  D3D11_MAPPED_SUBRESOURCE mappedResource;
+  if (FAILED(g_context->Map(g_readBuffer.ptr(), 0, D3D11_MAP_READ, 0, &mappedResource))) {
+    std::cerr << "Failed to map readback buffer" << std::endl;
+    return false;
+  }
+
+  std::array<uint32_t, 4> result;
+  std::memcpy(result.data(), mappedResource.pData, sizeof(result));
+  g_context->Unmap(g_readBuffer.ptr(), 0);
+
+  if (result != expected) {
+    std::cerr << "Expected " << expected[0] << ", got " << result[0] << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  Com<ID3D11ComputeShader>        computeShader;
+  Com<ID3D11Buffer>               constantBuffer;
+  Com<ID3D11UnorderedAccessView>  dstView;
+
+  // Small dynamic constant buffers are served
+  // from the upload ring if it is enabled
+  std::ofstream("d3d11-map-discard.conf") << "d3d11.dynamicBufferRing = True" << std::endl;
+  SetEnvironmentVariableW(L"DXVK_CONFIG_FILE", L"d3d11-map-discard.conf");
+
+  if (FAILED(D3D11CreateDevice(
+        nullptr, D3D_DRIVER_TYPE_HARDWARE,
+        nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+        &g_device, nullptr, &g_context))) {
+    std::cerr << "Failed to create D3D11 device" << std::endl;
+    return 1;
+  }
+
+  Com<ID3DBlob> computeShaderBlob;
+
+  if (FAILED(D3DCompile(
+        g_computeShaderCode.data(),
+        g_computeShaderCode.size(),
+        "Compute shader",
+        nullptr, nullptr,
+        "main", "cs_5_0", 0, 0,
+        &computeShaderBlob,
+        nullptr))) {
+    std::cerr << "Failed to compile compute shader" << std::endl;
+    return 1;
+  }
+
+  if (FAILED(g_device->CreateComputeShader(
+        computeShaderBlob->GetBufferPointer(),
+        computeShaderBlob->GetBufferSize(),
+        nullptr, &computeShader))) {
+    std::cerr << "Failed to create compute shader" << std::endl;
+    return 1;
+  }
+
+  D3D11_BUFFER_DESC cbDesc;
+  cbDesc.ByteWidth            = sizeof(uint32_t) * 4;
+  cbDesc.Usage                = D3D11_USAGE_DYNAMIC;
+  cbDesc.BindFlags            = D3D11_BIND_CONSTANT_BUFFER;
+  cbDesc.CPUAccessFlags       = D3D11_CPU_ACCESS_WRITE;
+  cbDesc.MiscFlags            = 0;
+  cbDesc.StructureByteStride  = 0;
+
+  if (FAILED(g_device->CreateBuffer(&cbDesc, nullptr, &constantBuffer))) {
+    std::cerr << "Failed to create constant buffer" << std::endl;
+    return 1;
+  }
+
+  D3D11_BUFFER_DESC dstBufferDesc;
+  dstBufferDesc.ByteWidth             = sizeof(uint32_t) * 4;
+  dstBufferDesc.Usage                 = D3D11_USAGE_DEFAULT;
+  dstBufferDesc.BindFlags             = D3D11_BIND_UNORDERED_ACCESS;
+  dstBufferDesc.CPUAccessFlags        = 0;
+  dstBufferDesc.MiscFlags             = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+  dstBufferDesc.StructureByteStride   = 0;
+
+  if (FAILED(g_device->CreateBuffer(&dstBufferDesc, nullptr, &g_dstBuffer))) {
+    std::cerr << "Failed to create destination buffer" << std::endl;
+    return 1;
+  }
+
+  D3D11_BUFFER_DESC readBufferDesc;
+  readBufferDesc.ByteWidth            = sizeof(uint32_t) * 4;
+  readBufferDesc.Usage                = D3D11_USAGE_STAGING;
+  readBufferDesc.BindFlags            = 0;
+  readBufferDesc.CPUAccessFlags       = D3D11_CPU_ACCESS_READ;
+  readBufferDesc.MiscFlags            = 0;
+  readBufferDesc.StructureByteStride  = 0;
+
+  if (FAILED(g_device->CreateBuffer(&readBufferDesc, nullptr, &g_readBuffer))) {
+    std::cerr << "Failed to create readback buffer" << std::endl;
+    return 1;
+  }
+
+  D3D11_UNORDERED_ACCESS_VIEW_DESC dstViewDesc;
+  dstViewDesc.Format                = DXGI_FORMAT_R32_TYPELESS;
+  dstViewDesc.ViewDimension         = D3D11_UAV_DIMENSION_BUFFER;
+  dstViewDesc.Buffer.FirstElement   = 0;
+  dstViewDesc.Buffer.NumElements    = 4;
+  dstViewDesc.Buffer.Flags          = D3D11_BUFFER_UAV_FLAG_RAW;
+
+  if (FAILED(g_device->CreateUnorderedAccessView(g_dstBuffer.ptr(), &dstViewDesc, &dstView))) {
+    std::cerr << "Failed to create unordered access view" << std::endl;
+    return 1;
+  }
+
+  g_context->CSSetShader(computeShader.ptr(), nullptr, 0);
+  g_context->CSSetConstantBuffers(0, 1, &constantBuffer);
+  g_context->CSSetUnorderedAccessViews(0, 1, &dstView, nullptr);
+
+  for (uint32_t i = 0; i < 16; i++) {
+    std::array<uint32_t, 4> data = {{ i, i + 1, i + 2, i + 3 }};
+
+    // The very first discard happens before the buffer has
+    // ever been renamed the regular way, which returns the
+    // buffer's initial slice once the GPU is done with it
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if (FAILED(g_context->Map(constantBuffer.ptr(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) {
+      std::cerr << "Failed to map constant buffer" << std::endl;
+      return 1;
+    }
+
+    std::memcpy(mappedResource.pData, data.data(), sizeof(data));
+    g_context->Unmap(constantBuffer.ptr(), 0);
+
+    if (!checkResult(data))
+      return 1;
+
+    // Ends the frame without discarding the buffer again,
+    // so it must keep its contents after leaving the ring
+    g_context->Flush();
+
+    if (!checkResult(data))
+      return 1;
+  }
+
+  std::cout << "Passed" << std::endl;
+  g_context->ClearState();
+  return 0;
+}
@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_cs_trace.h"
+#include "../../src/dxvk/dxvk_device.h"
+#include "../../src/dxvk/dxvk_instance.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance(L"dxvk-cs-replay.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Command trace player
+ *
+ * Re-creates the objects defined in a command trace
+ * and executes the recorded commands on one context
+ * per context that was recorded.
+ */
+class CsTracePlayer {
+
+public:
+
+  CsTracePlayer(const Rc<DxvkDevice>& device)
+  : m_device(device) { }
+
+  ~CsTracePlayer() {
+    for (auto& ctx : m_contexts) {
+      m_device->submitCommandList(ctx.second->endRecording(),
+        VK_NULL_HANDLE, VK_NULL_HANDLE);
+    }
+
+    m_device->waitForIdle();
+  }
+
+  uint32_t drawCount() const {
+    return m_drawCount;
+  }
+
+  uint32_t submitCount() const {
+    return m_submitCount;
+  }
+
+  void execute(const DxvkCsTraceRecord& record) {
+    switch (record.op) {
+      case DxvkCsTraceOp::CreateBuffer: {
+        auto args = record.args<DxvkCsTraceCreateBuffer>();
+        m_buffers[args.id] = m_device->createBuffer(args.info, args.memFlags);
+      } break;
+
+      case DxvkCsTraceOp::CreateBufferView: {
+        auto args = record.args<DxvkCsTraceCreateBufferView>();
+        m_bufferViews[args.id] = m_device->createBufferView(m_buffers[args.buffer], args.info);
+      } break;
+
+      case DxvkCsTraceOp::CreateImage: {
+        auto args = record.args<DxvkCsTraceCreateImage>();
+        auto viewFormats = getArray<VkFormat>(record.data<DxvkCsTraceCreateImage>(), args.info.viewFormatCount);
+        args.info.viewFormats = viewFormats.data();
+
+        // Swap chain images and imported images
+        // do not have any memory properties set
+        if (!args.memFlags)
+          args.memFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        m_images[args.id] = m_device->createImage(args.info, args.memFlags);
+      } break;
+
+      case DxvkCsTraceOp::CreateImageView: {
+        auto args = record.args<DxvkCsTraceCreateImageView>();
+        m_imageViews[args.id] = m_device->createImageView(m_images[args.image], args.info);
+      } break;
+
+      case DxvkCsTraceOp::CreateSampler: {
+        auto args = record.args<DxvkCsTraceCreateSampler>();
+        m_samplers[args.id] = m_device->createSampler(args.info);
+      } break;
+
+      case DxvkCsTraceOp::CreateShader: {
+        auto args = record.args<DxvkCsTraceCreateShader>();
+        auto data = record.data<DxvkCsTraceCreateShader>();
+
+        auto slots = getArray<DxvkResourceSlot>(data, args.slotCount);
+        data += args.slotCount * sizeof(DxvkResourceSlot);
+
+        auto constData = getArray<uint32_t>(data, args.constDwords);
+        data += args.constDwords * sizeof(uint32_t);
+
+        auto codeData = getArray<uint32_t>(data, args.codeDwords);
+
+        Rc<DxvkShader> shader = new DxvkShader(args.stage,
+          args.slotCount, slots.data(), args.iface,
+          SpirvCodeBuffer(args.codeDwords, codeData.data()), args.options,
+          DxvkShaderConstData(args.constDwords, constData.data()));
+        shader->setShaderKey(DxvkShaderKey(args.stage, args.hash));
+
+        m_shaders[args.id] = shader;
+      } break;
+
+      case DxvkCsTraceOp::DestroyObject: {
+        auto args = record.args<DxvkCsTraceDestroyObject>();
+        m_buffers.erase(args.id);
+        m_bufferViews.erase(args.id);
+        m_images.erase(args.id);
+        m_imageViews.erase(args.id);
+        m_samplers.erase(args.id);
+        m_shaders.erase(args.id);
+      } break;
+
+      case DxvkCsTraceOp::EndFrame:
+        break;
+
+      case DxvkCsTraceOp::Submit: {
+        auto ctx = getContext(record.context);
+        m_device->submitCommandList(ctx->endRecording(),
+          VK_NULL_HANDLE, VK_NULL_HANDLE);
+        ctx->beginRecording(m_device->createCommandList());
+        m_submitCount += 1;
+      } break;
+
+      case DxvkCsTraceOp::BindRenderTargets: {
+        auto args = record.args<DxvkCsTraceBindRenderTargets>();
+
+        DxvkRenderTargets targets;
+        targets.depth.view   = getObject(m_imageViews, args.depthView);
+        targets.depth.layout = args.depthLayout;
+
+        for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+          targets.color[i].view   = getObject(m_imageViews, args.colorViews[i]);
+          targets.color[i].layout = args.colorLayouts[i];
+        }
+
+        getContext(record.context)->bindRenderTargets(targets);
+      } break;
+
+      case DxvkCsTraceOp::BindDrawBuffers: {
+        auto args = record.args<DxvkCsTraceBindDrawBuffers>();
+        getContext(record.context)->bindDrawBuffers(
+          getSlice(args.argBuffer), getSlice(args.cntBuffer));
+      } break;
+
+      case DxvkCsTraceOp::BindIndexBuffer: {
+        auto args = record.args<DxvkCsTraceBindIndexBuffer>();
+        getContext(record.context)->bindIndexBuffer(
+          getSlice(args.buffer), args.indexType);
+      } break;
+
+      case DxvkCsTraceOp::BindResourceBuffer: {
+        auto args = record.args<DxvkCsTraceBindResourceBuffer>();
+        getContext(record.context)->bindResourceBuffer(
+          args.slot, getSlice(args.buffer));
+      } break;
+
+      case DxvkCsTraceOp::BindResourceView: {
+        auto args = record.args<DxvkCsTraceBindResourceView>();
+        getContext(record.context)->bindResourceView(args.slot,
+          getObject(m_imageViews, args.imageView),
+          getObject(m_bufferViews, args.bufferView));
+      } break;
+
+      case DxvkCsTraceOp::BindResourceSampler: {
+        auto args = record.args<DxvkCsTraceBindResourceSampler>();
+        getContext(record.context)->bindResourceSampler(args.slot,
+          getObject(m_samplers, args.sampler));
+      } break;
+
+      case DxvkCsTraceOp::BindShader: {
+        auto args = record.args<DxvkCsTraceBindShader>();
+        getContext(record.context)->bindShader(args.stage,
+          getObject(m_shaders, args.shader));
+      } break;
+
+      case DxvkCsTraceOp::BindVertexBuffer: {
+        auto args = record.args<DxvkCsTraceBindVertexBuffer>();
+        getContext(record.context)->bindVertexBuffer(args.binding,
+          getSlice(args.buffer), args.stride);
+      } break;
+
+      case DxvkCsTraceOp::ClearBuffer: {
+        auto args = record.args<DxvkCsTraceClearBuffer>();
+        getContext(record.context)->clearBuffer(
+          getObject(m_buffers, args.buffer),
+          args.offset, args.length, args.value);
+      } break;
+
+      case DxvkCsTraceOp::ClearRenderTarget: {
+        auto args = record.args<DxvkCsTraceClearRenderTarget>();
+        getContext(record.context)->clearRenderTarget(
+          getObject(m_imageViews, args.imageView),
+          args.aspects, args.value);
+      } break;
+
+      case DxvkCsTraceOp::ClearImageView: {
+        auto args = record.args<DxvkCsTraceClearImageView>();
+        getContext(record.context)->clearImageView(
+          getObject(m_imageViews, args.imageView),
+          args.offset, args.extent, args.aspects, args.value);
+      } break;
+
+      case DxvkCsTraceOp::CopyBuffer: {
+        auto args = record.args<DxvkCsTraceCopyBuffer>();
+        getContext(record.context)->copyBuffer(
+          getObject(m_buffers, args.dstBuffer), args.dstOffset,
+          getObject(m_buffers, args.srcBuffer), args.srcOffset,
+          args.numBytes);
+      } break;
+
+      case DxvkCsTraceOp::CopyImage: {
+        auto args = record.args<DxvkCsTraceCopyImage>();
+        getContext(record.context)->copyImage(
+          getObject(m_images, args.dstImage), args.dstSubresource, args.dstOffset,
+          getObject(m_images, args.srcImage), args.srcSubresource, args.srcOffset,
+          args.extent);
+      } break;
+
+      case DxvkCsTraceOp::DiscardBuffer: {
+        auto args = record.args<DxvkCsTraceBuffer>();
+        getContext(record.context)->discardBuffer(
+          getObject(m_buffers, args.buffer));
+      } break;
+
+      case DxvkCsTraceOp::Dispatch: {
+        auto args = record.args<DxvkCsTraceDispatch>();
+        getContext(record.context)->dispatch(args.x, args.y, args.z);
+      } break;
+
+      case DxvkCsTraceOp::DispatchIndirect: {
+        auto args = record.args<DxvkCsTraceDispatchIndirect>();
+        getContext(record.context)->dispatchIndirect(args.offset);
+      } break;
+
+      case DxvkCsTraceOp::Draw: {
+        auto args = record.args<DxvkCsTraceDraw>();
+        getContext(record.context)->draw(args.vertexCount,
+          args.instanceCount, args.firstVertex, args.firstInstance);
+        m_drawCount += 1;
+      } break;
+
+      case DxvkCsTraceOp::DrawIndirect: {
+        auto args = record.args<DxvkCsTraceDrawIndirect>();
+        getContext(record.context)->drawIndirect(args.offset, args.count, args.stride);
+        m_drawCount += 1;
+      } break;
+
+      case DxvkCsTraceOp::DrawIndexed: {
+        auto args = record.args<DxvkCsTraceDrawIndexed>();
+        getContext(record.context)->drawIndexed(args.indexCount,
+          args.instanceCount, args.firstIndex, args.vertexOffset, args.firstInstance);
+        m_drawCount += 1;
+      } break;
+
+      case DxvkCsTraceOp::DrawIndexedIndirect: {
+        auto args = record.args<DxvkCsTraceDrawIndirect>();
+        getContext(record.context)->drawIndexedIndirect(args.offset, args.count, args.stride);
+        m_drawCount += 1;
+      } break;
+
+      case DxvkCsTraceOp::GenerateMipmaps: {
+        auto args = record.args<DxvkCsTraceGenerateMipmaps>();
+        getContext(record.context)->generateMipmaps(
+          getObject(m_imageViews, args.imageView), args.filter);
+      } break;
+
+      case DxvkCsTraceOp::InvalidateBuffer: {
+        auto args = record.args<DxvkCsTraceBuffer>();
+        auto buffer = getObject(m_buffers, args.buffer);
+        getContext(record.context)->invalidateBuffer(buffer, buffer->allocSlice());
+      } break;
+
+      case DxvkCsTraceOp::PushConstants: {
+        auto args = record.args<DxvkCsTracePushConstants>();
+        getContext(record.context)->pushConstants(args.offset, args.size,
+          record.data<DxvkCsTracePushConstants>());
+      } break;
+
+      case DxvkCsTraceOp::UpdateBuffer: {
+        auto args = record.args<DxvkCsTraceUpdateBuffer>();
+        getContext(record.context)->updateBuffer(
+          getObject(m_buffers, args.buffer), args.offset, args.size,
+          record.data<DxvkCsTraceUpdateBuffer>());
+      } break;
+
+      case DxvkCsTraceOp::UpdateImage: {
+        auto args = record.args<DxvkCsTraceUpdateImage>();
+        getContext(record.context)->updateImage(
+          getObject(m_images, args.image), args.subresources,
+          args.offset, args.extent, record.data<DxvkCsTraceUpdateImage>(),
+          args.pitchPerRow, args.pitchPerLayer);
+      } break;
+
+      case DxvkCsTraceOp::UploadBuffer: {
+        auto args = record.args<DxvkCsTraceBuffer>();
+        getContext(record.context)->uploadBuffer(
+          getObject(m_buffers, args.buffer),
+          record.data<DxvkCsTraceBuffer>());
+      } break;
+
+      case DxvkCsTraceOp::UploadImage: {
+        auto args = record.args<DxvkCsTraceUpdateImage>();
+        getContext(record.context)->uploadImage(
+          getObject(m_images, args.image), args.subresources,
+          record.data<DxvkCsTraceUpdateImage>(),
+          args.pitchPerRow, args.pitchPerLayer);
+      } break;
+
+      case DxvkCsTraceOp::SetViewports: {
+        auto args = record.args<DxvkCsTraceSetViewports>();
+        auto data = record.data<DxvkCsTraceSetViewports>();
+
+        auto viewports = getArray<VkViewport>(data, args.viewportCount);
+        auto scissors  = getArray<VkRect2D>(data + args.viewportCount * sizeof(VkViewport), args.viewportCount);
+
+        getContext(record.context)->setViewports(args.viewportCount,
+          viewports.data(), scissors.data());
+      } break;
+
+      case DxvkCsTraceOp::SetBlendConstants:
+        getContext(record.context)->setBlendConstants(
+          record.args<DxvkBlendConstants>());
+        break;
+
+      case DxvkCsTraceOp::SetDepthBias:
+        getContext(record.context)->setDepthBias(
+          record.args<DxvkDepthBias>());
+        break;
+
+      case DxvkCsTraceOp::SetStencilReference:
+        getContext(record.context)->setStencilReference(
+          record.args<DxvkCsTraceSetStencilReference>().reference);
+        break;
+
+      case DxvkCsTraceOp::SetInputAssemblyState:
+        getContext(record.context)->setInputAssemblyState(
+          record.args<DxvkInputAssemblyState>());
+        break;
+
+      case DxvkCsTraceOp::SetInputLayout: {
+        auto args = record.args<DxvkCsTraceSetInputLayout>();
+        auto data = record.data<DxvkCsTraceSetInputLayout>();
+
+        auto attributes = getArray<DxvkVertexAttribute>(data, args.attributeCount);
+        auto bindings   = getArray<DxvkVertexBinding>(data + args.attributeCount * sizeof(DxvkVertexAttribute), args.bindingCount);
+
+        getContext(record.context)->setInputLayout(
+          args.attributeCount, attributes.data(),
+          args.bindingCount,   bindings.data());
+      } break;
+
+      case DxvkCsTraceOp::SetRasterizerState:
+        getContext(record.context)->setRasterizerState(
+          record.args<DxvkRasterizerState>());
+        break;
+
+      case DxvkCsTraceOp::SetMultisampleState:
+        getContext(record.context)->setMultisampleState(
+          record.args<DxvkMultisampleState>());
+        break;
+
+      case DxvkCsTraceOp::SetDepthStencilState:
+        getContext(record.context)->setDepthStencilState(
+          record.args<DxvkDepthStencilState>());
+        break;
+
+      case DxvkCsTraceOp::SetLogicOpState:
+        getContext(record.context)->setLogicOpState(
+          record.args<DxvkLogicOpState>());
+        break;
+
+      case DxvkCsTraceOp::SetBlendMode: {
+        auto args = record.args<DxvkCsTraceSetBlendMode>();
+        getContext(record.context)->setBlendMode(args.attachment, args.blendMode);
+      } break;
+
+      case DxvkCsTraceOp::SetSpecConstant: {
+        auto args = record.args<DxvkCsTraceSetSpecConstant>();
+        getContext(record.context)->setSpecConstant(args.pipeline, args.index, args.value);
+      } break;
+
+      default:
+        Logger::warn(str::format("Unknown trace op ", uint32_t(record.op)));
+    }
+  }
+
+private:
+
+  Rc<DxvkDevice> m_device;
+
+  std::unordered_map<uint32_t, Rc<DxvkContext>>     m_contexts;
+
+  std::unordered_map<uint32_t, Rc<DxvkBuffer>>      m_buffers;
+  std::unordered_map<uint32_t, Rc<DxvkBufferView>>  m_bufferViews;
+  std::unordered_map<uint32_t, Rc<DxvkImage>>       m_images;
+  std::unordered_map<uint32_t, Rc<DxvkImageView>>   m_imageViews;
+  std::unordered_map<uint32_t, Rc<DxvkSampler>>     m_samplers;
+  std::unordered_map<uint32_t, Rc<DxvkShader>>      m_shaders;
+
+  uint32_t m_drawCount   = 0;
+  uint32_t m_submitCount = 0;
+
+  DxvkContext* getContext(uint32_t id) {
+    auto& ctx = m_contexts[id];
+
+    if (ctx == nullptr) {
+      ctx = m_device->createContext();
+      ctx->beginRecording(m_device->createCommandList());
+    }
+
+    return ctx.ptr();
+  }
+
+  template<typename T>
+  static Rc<T> getObject(const std::unordered_map<uint32_t, Rc<T>>& map, uint32_t id) {
+    auto entry = map.find(id);
+
+    return entry != map.end()
+      ? entry->second
+      : nullptr;
+  }
+
+  template<typename T>
+  static std::vector<T> getArray(const char* data, size_t count) {
+    // Record data is not guaranteed to be aligned
+    std::vector<T> result(count);
+
+    if (count)
+      std::memcpy(result.data(), data, count * sizeof(T));
+
+    return result;
+  }
+
+  DxvkBufferSlice getSlice(const DxvkCsTraceSlice& slice) {
+    Rc<DxvkBuffer> buffer = getObject(m_buffers, slice.buffer);
+
+    if (buffer == nullptr)
+      return DxvkBufferSlice();
+
+    return DxvkBufferSlice(buffer, slice.offset, slice.length);
+  }
+
+};
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  if (argc < 2) {
+    Logger::err("Usage: dxvk-cs-replay <trace file> [adapter index]");
+    return 1;
+  }
+
+  std::ifstream stream(std::filesystem::path(argv[1]), std::ios_base::binary);
+  DxvkCsTraceHeader header;
+
+  if (!DxvkCsTracer::readHeader(stream, header)) {
+    Logger::err("Invalid command trace");
+    return 1;
+  }
+
+  uint32_t adapterIndex = argc > 2 ? uint32_t(std::wcstoul(argv[2], nullptr, 10)) : 0;
+
+  try {
+    Rc<DxvkInstance> instance = new DxvkInstance();
+    Rc<DxvkAdapter>  adapter  = instance->enumAdapters(adapterIndex);
+
+    if (adapter == nullptr) {
+      Logger::err(str::format("Adapter ", adapterIndex, " not found"));
+      return 1;
+    }
+
+    Logger::info(str::format("Replaying on ", adapter->deviceProperties().deviceName));
+
+    // The trace does not know which features the application
+    // used, so enable everything that the device supports
+    Rc<DxvkDevice> device = adapter->createDevice(instance, adapter->features());
+
+    std::vector<uint64_t> frameTimes;
+
+    uint32_t recordCount = 0;
+    uint32_t drawCount   = 0;
+    uint32_t submitCount = 0;
+
+    { CsTracePlayer player(device);
+
+      std::vector<DxvkCsTraceRecord> frame;
+      DxvkCsTraceRecord record;
+
+      bool eof = false;
+
+      while (!eof) {
+        // Read an entire frame up front so that file
+        // I/O does not count towards the frame time
+        frame.clear();
+
+        while (true) {
+          if (!DxvkCsTracer::readRecord(stream, record)) {
+            eof = true;
+            break;
+          }
+
+          bool endFrame = record.op == DxvkCsTraceOp::EndFrame;
+          frame.push_back(std::move(record));
+
+          if (endFrame)
+            break;
+        }
+
+        auto t0 = dxvk::high_resolution_clock::now();
+
+        for (const auto& r : frame)
+          player.execute(r);
+
+        auto t1 = dxvk::high_resolution_clock::now();
+
+        if (!eof)
+          frameTimes.push_back(std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+
+        recordCount += uint32_t(frame.size());
+      }
+
+      drawCount   = player.drawCount();
+      submitCount = player.submitCount();
+    }
+
+    if (frameTimes.empty()) {
+      Logger::err("Trace does not contain any frames");
+      return 1;
+    }
+
+    std::vector<uint64_t> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+
+    uint64_t total = 0;
+
+    for (auto t : frameTimes)
+      total += t;
+
+    Logger::info(str::format("Replay:",
+      "\n  Records:          ", recordCount,
+      "\n  Frames:           ", frameTimes.size(),
+      "\n  Draws:            ", drawCount,
+      "\n  Submissions:      ", submitCount,
+      "\n  Frame time (avg): ", total / frameTimes.size(), " us",
+      "\n  Frame time (min): ", sorted.front(), " us",
+      "\n  Frame time (p50): ", sorted[sorted.size() / 2], " us",
+      "\n  Frame time (p99): ", sorted[(sorted.size() * 99) / 100], " us",
+      "\n  Frame time (max): ", sorted.back(), " us"));
+
+    std::ofstream csv("dxvk-cs-replay.csv");
+    csv << "frame,cpu_time_us" << std::endl;
+
+    for (size_t i = 0; i < frameTimes.size(); i++)
+      csv << i << "," << frameTimes[i] << "\n";
+  } catch (const DxvkError& e) {
+    Logger::err(e.message());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,343 @@
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_memory.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance(L"dxvk-memory-chunk.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Recorded allocation or free
+ */
+struct AllocOp {
+  bool          isAlloc;
+  uint32_t      id;
+  VkDeviceSize  size;
+  VkDeviceSize  align;
+};
+
+/**
+ * \brief Worst-fit reference allocator
+ *
+ * The sub-allocation policy that memory chunks
+ * used previously, kept here for comparison.
+ */
+class WorstFitAllocator {
+
+public:
+
+  WorstFitAllocator(VkDeviceSize size)
+  : m_size(size) {
+    m_freeList.push_back({ 0, size });
+  }
+
+  VkDeviceSize size() const {
+    return m_size;
+  }
+
+  VkDeviceSize used() const {
+    return m_used;
+  }
+
+  bool alloc(VkDeviceSize size, VkDeviceSize align, VkDeviceSize& offset, VkDeviceSize& length) {
+    if (m_freeList.empty())
+      return false;
+
+    auto bestSlice = m_freeList.begin();
+
+    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
+      if (slice->length == size) {
+        bestSlice = slice;
+        break;
+      } else if (slice->length > bestSlice->length) {
+        bestSlice = slice;
+      }
+    }
+
+    const VkDeviceSize sliceStart = bestSlice->offset;
+    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
+
+    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
+    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
+
+    if (allocEnd > sliceEnd)
+      return false;
+
+    m_freeList.erase(bestSlice);
+
+    if (allocStart != sliceStart)
+      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
+
+    if (allocEnd != sliceEnd)
+      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
+
+    offset  = allocStart;
+    length  = allocEnd - allocStart;
+    m_used += length;
+    return true;
+  }
+
+  void free(VkDeviceSize offset, VkDeviceSize length) {
+    m_used -= length;
+
+    auto curr = m_freeList.begin();
+
+    while (curr != m_freeList.end()) {
+      if (curr->offset == offset + length) {
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else if (curr->offset + curr->length == offset) {
+        offset -= curr->length;
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else {
+        curr++;
+      }
+    }
+
+    m_freeList.push_back({ offset, length });
+  }
+
+  VkDeviceSize largestFreeRange() const {
+    VkDeviceSize result = 0;
+
+    for (const auto& slice : m_freeList)
+      result = std::max(result, slice.length);
+
+    return result;
+  }
+
+private:
+
+  struct FreeSlice {
+    VkDeviceSize offset;
+    VkDeviceSize length;
+  };
+
+  VkDeviceSize m_size;
+  VkDeviceSize m_used = 0;
+
+  std::vector<FreeSlice> m_freeList;
+
+};
+
+
+/**
+ * \brief Loads a recorded allocation pattern
+ *
+ * Each line is either \c "a <id> <size> <align>"
+ * for an allocation or \c "f <id>" for a free.
+ */
+std::vector<AllocOp> loadPattern(const std::string& fileName) {
+  std::vector<AllocOp> result;
+  std::ifstream file(fileName);
+  std::string line;
+
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    std::string type;
+    AllocOp op = { };
+
+    if (!(stream >> type >> op.id))
+      continue;
+
+    op.isAlloc = type == "a";
+
+    if (op.isAlloc && !(stream >> op.size >> op.align))
+      continue;
+
+    result.push_back(op);
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Generates a synthetic allocation pattern
+ *
+ * Mimics a game streaming in small buffers and the
+ * occasional texture while keeping a working set of
+ * long-lived resources around.
+ */
+std::vector<AllocOp> generatePattern(uint32_t opCount) {
+  std::vector<AllocOp> result;
+  std::vector<uint32_t> live;
+
+  std::mt19937 rng(0x5eed);
+
+  uint32_t nextId = 0;
+
+  for (uint32_t i = 0; i < opCount; i++) {
+    bool doAlloc = live.size() < 64 || (rng() % 100) < 52;
+
+    if (doAlloc) {
+      AllocOp op;
+      op.isAlloc = true;
+      op.id      = nextId++;
+
+      uint32_t kind = rng() % 100;
+
+      if (kind < 70) {
+        op.size  = 64 + rng() % 16384;
+        op.align = 256;
+      } else if (kind < 95) {
+        op.size  = 65536 + rng() % (1u << 20);
+        op.align = 4096;
+      } else {
+        op.size  = (1u << 20) + rng() % (8u << 20);
+        op.align = 65536;
+      }
+
+      live.push_back(op.id);
+      result.push_back(op);
+    } else {
+      size_t index = rng() % live.size();
+
+      AllocOp op = { };
+      op.isAlloc = false;
+      op.id      = live[index];
+
+      live[index] = live.back();
+      live.pop_back();
+
+      result.push_back(op);
+    }
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Allocated range
+ *
+ * The worst-fit allocator frees ranges by offset and
+ * length, the TLSF allocator by the returned block index.
+ */
+struct Range {
+  VkDeviceSize  offset;
+  VkDeviceSize  length;
+  uint32_t      block;
+};
+
+bool allocRange(WorstFitAllocator& allocator, const AllocOp& op, Range& range) {
+  return allocator.alloc(op.size, op.align, range.offset, range.length);
+}
+
+bool allocRange(DxvkMemoryRangeAllocator& allocator, const AllocOp& op, Range& range) {
+  return allocator.alloc(op.size, op.align, range.offset, range.length, range.block);
+}
+
+void freeRange(WorstFitAllocator& allocator, const Range& range) {
+  allocator.free(range.offset, range.length);
+}
+
+void freeRange(DxvkMemoryRangeAllocator& allocator, const Range& range) {
+  allocator.free(range.block);
+}
+
+template<typename Alloc>
+void runPattern(const char* name, const std::vector<AllocOp>& ops, VkDeviceSize chunkSize) {
+  Alloc allocator(chunkSize);
+
+  std::unordered_map<uint32_t, Range> ranges;
+
+  uint32_t allocCount = 0;
+  uint32_t failCount  = 0;
+  uint32_t freeCount  = 0;
+
+  double fragSum  = 0.0;
+  double fragPeak = 0.0;
+
+  std::chrono::nanoseconds elapsed(0);
+
+  // Only time the allocator calls themselves, not
+  // the bookkeeping needed to replay the pattern
+  for (const auto& op : ops) {
+    if (op.isAlloc) {
+      Range range = { };
+
+      auto t0 = std::chrono::high_resolution_clock::now();
+      bool success = allocRange(allocator, op, range);
+      auto t1 = std::chrono::high_resolution_clock::now();
+      elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0);
+
+      if (success)
+        ranges.insert({ op.id, range });
+      else
+        failCount += 1;
+
+      allocCount += 1;
+    } else {
+      auto entry = ranges.find(op.id);
+
+      if (entry != ranges.end()) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        freeRange(allocator, entry->second);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0);
+
+        ranges.erase(entry);
+      }
+
+      freeCount += 1;
+    }
+
+    // Fragmentation is the fraction of free memory
+    // that cannot be used for the largest allocation
+    VkDeviceSize freeSize = allocator.size() - allocator.used();
+
+    if (freeSize) {
+      double frag = 1.0 - double(allocator.largestFreeRange()) / double(freeSize);
+      fragSum += frag;
+      fragPeak = std::max(fragPeak, frag);
+    }
+  }
+
+  uint32_t opCount = allocCount + freeCount;
+
+  Logger::info(str::format(name, ":",
+    "\n  Operations:     ", opCount, " (", allocCount, " allocs, ", freeCount, " frees)",
+    "\n  Failed allocs:  ", failCount,
+    "\n  Total time:     ", elapsed.count() / 1000, " us",
+    "\n  Time per op:    ", opCount ? elapsed.count() / opCount : 0, " ns",
+    "\n  Fragmentation:  ", uint32_t(100.0 * fragSum / std::max(opCount, 1u)), "% avg, ",
+                            uint32_t(100.0 * fragPeak), "% peak"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  std::vector<AllocOp> ops = argc > 1
+    ? loadPattern(str::fromws(argv[1]))
+    : generatePattern(1000000);
+
+  if (ops.empty()) {
+    Logger::err("Usage: dxvk-memory-chunk [pattern.txt]");
+    return 1;
+  }
+
+  constexpr VkDeviceSize ChunkSize = 128 << 20;
+
+  runPattern<WorstFitAllocator>       ("Worst-fit", ops, ChunkSize);
+  runPattern<DxvkMemoryRangeAllocator>("TLSF",      ops, ChunkSize);
+  return 0;
+}
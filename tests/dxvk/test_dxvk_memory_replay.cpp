@@ -0,0 +1,201 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include "../../src/dxvk/dxvk_memory.h"
+
+#include "../../src/util/util_bit.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance(L"dxvk-memory-replay.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Mocked device memory
+ *
+ * Hands out fake memory handles and keeps
+ * track of the amount of memory that would
+ * have been allocated from the driver.
+ */
+namespace mock {
+
+  uint64_t     nextHandle      = 1;
+  uint32_t     allocCount      = 0;
+  VkDeviceSize committed       = 0;
+  VkDeviceSize peakCommitted   = 0;
+
+  std::unordered_map<uint64_t, VkDeviceSize> allocations;
+
+  VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(
+          VkDevice                device,
+    const VkMemoryAllocateInfo*   pAllocateInfo,
+    const VkAllocationCallbacks*  pAllocator,
+          VkDeviceMemory*         pMemory) {
+    uint64_t handle = nextHandle++;
+    allocations.insert({ handle, pAllocateInfo->allocationSize });
+
+    committed    += pAllocateInfo->allocationSize;
+    peakCommitted = std::max(peakCommitted, committed);
+    allocCount   += 1;
+
+    *pMemory = bit::cast<VkDeviceMemory>(handle);
+    return VK_SUCCESS;
+  }
+
+  VKAPI_ATTR void VKAPI_CALL vkFreeMemory(
+          VkDevice                device,
+          VkDeviceMemory          memory,
+    const VkAllocationCallbacks*  pAllocator) {
+    auto entry = allocations.find(bit::cast<uint64_t>(memory));
+
+    if (entry != allocations.end()) {
+      committed -= entry->second;
+      allocations.erase(entry);
+    }
+  }
+
+  VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(
+          VkDevice                device,
+          VkDeviceMemory          memory,
+          VkDeviceSize            offset,
+          VkDeviceSize            size,
+          VkMemoryMapFlags        flags,
+          void**                  ppData) {
+    // Mapped memory is never accessed during replay
+    *ppData = reinterpret_cast<void*>(uintptr_t(0x10000000));
+    return VK_SUCCESS;
+  }
+
+  VKAPI_ATTR void VKAPI_CALL vkUnmapMemory(
+          VkDevice                device,
+          VkDeviceMemory          memory) {
+
+  }
+
+  VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(
+          VkDevice                device,
+    const char*                   pName) {
+    if (!std::strcmp(pName, "vkAllocateMemory"))
+      return reinterpret_cast<PFN_vkVoidFunction>(&vkAllocateMemory);
+    if (!std::strcmp(pName, "vkFreeMemory"))
+      return reinterpret_cast<PFN_vkVoidFunction>(&vkFreeMemory);
+    if (!std::strcmp(pName, "vkMapMemory"))
+      return reinterpret_cast<PFN_vkVoidFunction>(&vkMapMemory);
+    if (!std::strcmp(pName, "vkUnmapMemory"))
+      return reinterpret_cast<PFN_vkVoidFunction>(&vkUnmapMemory);
+    return nullptr;
+  }
+
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  if (argc < 2) {
+    Logger::err("Usage: dxvk-memory-replay <trace file>");
+    return 1;
+  }
+
+  std::ifstream stream(std::filesystem::path(argv[1]), std::ios_base::binary);
+  DxvkMemoryTraceHeader header;
+
+  if (!DxvkMemoryTracer::readHeader(stream, header)) {
+    Logger::err("Invalid memory trace");
+    return 1;
+  }
+
+  DxvkMemoryAllocatorInfo info;
+  info.deviceProperties.limits.bufferImageGranularity = header.bufferImageGranularity;
+  info.memoryProperties = header.memoryProperties;
+
+  Rc<vk::DeviceFn> vkd = new vk::DeviceFn(false, VK_NULL_HANDLE, &mock::vkGetDeviceProcAddr);
+
+  uint32_t allocCount = 0;
+  uint32_t failCount  = 0;
+  uint32_t freeCount  = 0;
+
+  double fragSum  = 0.0;
+  double fragPeak = 0.0;
+  uint32_t fragSamples = 0;
+
+  std::chrono::nanoseconds elapsed(0);
+
+  { DxvkMemoryAllocator allocator(vkd, info);
+    std::unordered_map<uint32_t, DxvkMemory> allocations;
+
+    DxvkMemoryTraceRecord record;
+
+    while (DxvkMemoryTracer::readRecord(stream, record)) {
+      auto t0 = std::chrono::high_resolution_clock::now();
+
+      if (record.op == DxvkMemoryTraceOp::Alloc) {
+        VkMemoryRequirements req;
+        req.size            = record.alloc.size;
+        req.alignment       = record.alloc.alignment;
+        req.memoryTypeBits  = record.alloc.memoryTypeBits;
+
+        VkMemoryDedicatedRequirements dedAllocReq = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS };
+        dedAllocReq.prefersDedicatedAllocation = record.alloc.dedicated;
+
+        VkMemoryDedicatedAllocateInfo dedAllocInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
+
+        try {
+          allocations[record.id] = allocator.alloc(&req, dedAllocReq,
+            dedAllocInfo, record.alloc.flags, record.alloc.priority);
+        } catch (const DxvkError&) {
+          failCount += 1;
+        }
+
+        allocCount += 1;
+      } else {
+        allocations.erase(record.id);
+        freeCount += 1;
+      }
+
+      auto t1 = std::chrono::high_resolution_clock::now();
+      elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0);
+
+      // Fragmentation is the fraction of committed
+      // memory that is not used by any allocation.
+      // Sample periodically to keep overhead low.
+      if (!((allocCount + freeCount) % 1000) && mock::committed) {
+        VkDeviceSize used = 0;
+
+        for (uint32_t i = 0; i < header.memoryProperties.memoryHeapCount; i++)
+          used += allocator.getMemoryStats(i).memoryUsed;
+
+        double frag = 1.0 - double(used) / double(mock::committed);
+        fragSum += frag;
+        fragPeak = std::max(fragPeak, frag);
+        fragSamples += 1;
+      }
+    }
+  }
+
+  uint32_t opCount = allocCount + freeCount;
+
+  Logger::info(str::format("Replay:",
+    "\n  Operations:       ", opCount, " (", allocCount, " allocs, ", freeCount, " frees)",
+    "\n  Failed allocs:    ", failCount,
+    "\n  Total time:       ", elapsed.count() / 1000, " us",
+    "\n  Time per op:      ", opCount ? elapsed.count() / opCount : 0, " ns",
+    "\n  Throughput:       ", elapsed.count() ? uint64_t(1.0e9 * double(opCount) / double(elapsed.count())) : 0, " ops/s",
+    "\n  Device allocs:    ", mock::allocCount,
+    "\n  Peak committed:   ", mock::peakCommitted >> 20, " MB",
+    "\n  Fragmentation:    ", uint32_t(100.0 * fragSum / std::max(fragSamples, 1u)), "% avg, ",
+                              uint32_t(100.0 * fragPeak), "% peak"));
+  return 0;
+}
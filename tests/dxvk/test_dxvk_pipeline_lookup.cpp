@@ -0,0 +1,211 @@
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_graphics.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance(L"dxvk-pipeline-lookup.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Linear reference lookup
+ *
+ * The lookup that graphics pipelines used previously,
+ * which compares the state vector against every single
+ * instance. Kept here for comparison.
+ */
+class LinearInstanceList {
+
+public:
+
+  DxvkGraphicsPipelineInstance* find(
+    const DxvkGraphicsPipelineStateInfo&  state,
+          size_t                          stateHash,
+    const DxvkRenderPass*                 rp) {
+    for (auto& instance : m_instances) {
+      if (instance.isCompatible(state, rp))
+        return &instance;
+    }
+
+    return nullptr;
+  }
+
+  DxvkGraphicsPipelineInstance* add(
+    const DxvkGraphicsPipelineStateInfo&  state,
+          size_t                          stateHash,
+    const DxvkRenderPass*                 rp,
+          VkPipeline                      pipe) {
+    return &m_instances.emplace_back(state, rp, pipe);
+  }
+
+private:
+
+  std::vector<DxvkGraphicsPipelineInstance> m_instances;
+
+};
+
+
+/**
+ * \brief Pipeline instance lookup
+ *
+ * Indices into the generated state
+ * vectors and render passes.
+ */
+struct LookupOp {
+  uint32_t stateIndex;
+  uint32_t passIndex;
+};
+
+
+/**
+ * \brief Generates pipeline state variants
+ *
+ * Mimics a shader that gets used with a number of
+ * blend modes and vertex layouts. Vertex layouts are
+ * stored at the end of the state vector, so that they
+ * are the worst case for a linear scan.
+ */
+std::vector<DxvkGraphicsPipelineStateInfo> generateStates(uint32_t stateCount) {
+  std::vector<DxvkGraphicsPipelineStateInfo> result(stateCount);
+
+  for (uint32_t i = 0; i < stateCount; i++) {
+    auto& state = result[i];
+
+    state.il = DxvkIlInfo(2, 1);
+    state.ilAttributes[0] = DxvkIlAttribute(0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0);
+    state.ilAttributes[1] = DxvkIlAttribute(1, 0, VK_FORMAT_R8G8B8A8_UNORM, 12 + 4 * (i / 4));
+    state.ilBindings[0] = DxvkIlBinding(0, 16 + 4 * (i / 4), VK_VERTEX_INPUT_RATE_VERTEX, 0);
+
+    state.omBlend[0] = DxvkOmAttachmentBlend((i & 3) != 0,
+      (i & 1) ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE,
+      (i & 2) ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE,
+      VK_BLEND_OP_ADD, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD,
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Generates a synthetic lookup pattern
+ *
+ * Draws tend to reuse the previous pipeline state,
+ * so most lookups hit one of a few recent states.
+ */
+std::vector<LookupOp> generatePattern(uint32_t opCount, uint32_t stateCount, uint32_t passCount) {
+  std::vector<LookupOp> result;
+  result.reserve(opCount);
+
+  std::mt19937 rng(0x5eed);
+
+  LookupOp op = { 0, 0 };
+
+  for (uint32_t i = 0; i < opCount; i++) {
+    if (rng() % 100 < 70)
+      op.stateIndex = rng() % stateCount;
+
+    if (rng() % 100 < 5)
+      op.passIndex = rng() % passCount;
+
+    result.push_back(op);
+  }
+
+  return result;
+}
+
+
+template<typename Table, bool Rehash>
+void runPattern(
+  const char*                                       name,
+  const std::vector<DxvkGraphicsPipelineStateInfo>& states,
+  const std::vector<LookupOp>&                      ops,
+        uint32_t                                    passCount) {
+  Table table;
+
+  std::vector<size_t> hashes(states.size());
+
+  for (size_t i = 0; i < states.size(); i++)
+    hashes[i] = states[i].hash();
+
+  // Render passes are only compared by address
+  // and never dereferenced, so fake them
+  std::vector<const DxvkRenderPass*> passes(passCount);
+
+  for (uint32_t i = 0; i < passCount; i++)
+    passes[i] = reinterpret_cast<const DxvkRenderPass*>(uintptr_t(i + 1) << 12);
+
+  for (uint32_t i = 0; i < states.size(); i++) {
+    for (uint32_t j = 0; j < passCount; j++) {
+      VkPipeline pipe = VkPipeline(uint64_t(i * passCount + j + 1));
+      table.add(states[i], hashes[i], passes[j], pipe);
+    }
+  }
+
+  uint32_t missCount = 0;
+
+  auto t0 = std::chrono::high_resolution_clock::now();
+
+  for (const auto& op : ops) {
+    const auto& state = states[op.stateIndex];
+
+    size_t hash = Rehash
+      ? state.hash()
+      : hashes[op.stateIndex];
+
+    if (!table.find(state, hash, passes[op.passIndex]))
+      missCount += 1;
+  }
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0);
+
+  uint32_t opCount = uint32_t(ops.size());
+
+  Logger::info(str::format(name, ":",
+    "\n  Instances:      ", states.size() * passCount,
+    "\n  Lookups:        ", opCount, " (", missCount, " misses)",
+    "\n  Total time:     ", elapsed.count() / 1000, " us",
+    "\n  Time per op:    ", opCount ? elapsed.count() / opCount : 0, " ns"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  // Vertex layouts run out of unique
+  // offsets beyond this number of states
+  constexpr uint32_t MaxStateCount = 1024;
+
+  uint32_t stateCount = argc > 1
+    ? std::min(uint32_t(std::wcstoul(argv[1], nullptr, 10)), MaxStateCount)
+    : 64;
+
+  if (!stateCount) {
+    Logger::err("Usage: dxvk-pipeline-lookup [state count]");
+    return 1;
+  }
+
+  constexpr uint32_t PassCount = 4;
+
+  auto states = generateStates(stateCount);
+  auto ops    = generatePattern(1000000, stateCount, PassCount);
+
+  runPattern<LinearInstanceList,                false>("Linear scan",           states, ops, PassCount);
+  runPattern<DxvkGraphicsPipelineInstanceTable, false>("Hashed",                states, ops, PassCount);
+  runPattern<DxvkGraphicsPipelineInstanceTable, true> ("Hashed, rehash per op", states, ops, PassCount);
+  return 0;
+}